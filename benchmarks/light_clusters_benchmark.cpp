@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <ow/light_clusters.hpp>
+
+namespace {
+
+// view space lights spread in the frustum, radii from 0.5 to 5.
+ow::sphere_batch random_lights(std::size_t count, float fov, float aspect) {
+	std::mt19937 rng{5};
+	std::uniform_real_distribution<float> unit{0.f, 1.f};
+	ow::sphere_batch lights;
+	for (std::size_t l = 0; l < count; ++l) {
+		float depth = 1.f + 99.f * unit(rng);
+		float half_height = std::tan(fov / 2.f) * depth;
+		lights.push_back({glm::vec3{(2.f * unit(rng) - 1.f) * half_height * aspect, (2.f * unit(rng) - 1.f) * half_height, -depth},
+						  0.5f + 4.5f * unit(rng)});
+	}
+	return lights;
+}
+
+const char* kernel_name(ow::culling_kernel kernel) {
+	switch (kernel) {
+	case ow::culling_kernel::scalar:
+		return "scalar";
+	case ow::culling_kernel::sse:
+		return "sse";
+	case ow::culling_kernel::avx2:
+		return "avx2";
+	case ow::culling_kernel::automatic:
+	default:
+		return "automatic";
+	}
+}
+
+}
+
+int main() {
+	constexpr float fov = 1.f;
+	constexpr float aspect = 16.f / 9.f;
+	constexpr int runs = 20;
+
+	ow::light_clusters clusters{};
+	clusters.set_projection(glm::perspective(fov, aspect, 0.1f, 100.f));
+	for (std::size_t count : {256, 4096, 65536}) {
+		auto lights = random_lights(count, fov, aspect);
+		for (auto kernel : {ow::culling_kernel::scalar, ow::culling_kernel::sse, ow::culling_kernel::avx2}) {
+			if (kernel > ow::best_culling_kernel()) {
+				continue;
+			}
+			double best = 0.0;
+			ow::cluster_stats stats{};
+			for (int run = 0; run < runs; ++run) {
+				auto start = std::chrono::steady_clock::now();
+				stats = clusters.assign(lights, kernel);
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+				best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+			}
+			std::cout << count << " lights, " << kernel_name(kernel) << ": " << best << " ms, "
+					  << stats.indices << " indices, " << stats.max_per_cluster << " max per cluster\n";
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/mesh_simplifier.hpp>
+
+namespace {
+
+// closed unit sphere, (rings - 1) * segments + 2 vertices.
+void uv_sphere(unsigned int rings, unsigned int segments, std::vector<ow::vertex>* vertices,
+			   std::vector<unsigned int>* indices) {
+	const float pi = std::acos(-1.f);
+	vertices->emplace_back(glm::vec3(0, 1, 0), glm::vec3(0, 1, 0));
+	for (unsigned int r = 1; r < rings; ++r) {
+		float theta = pi * static_cast<float>(r) / static_cast<float>(rings);
+		for (unsigned int s = 0; s < segments; ++s) {
+			float phi = 2.f * pi * static_cast<float>(s) / static_cast<float>(segments);
+			glm::vec3 position(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertices->emplace_back(position, position);
+		}
+	}
+	vertices->emplace_back(glm::vec3(0, -1, 0), glm::vec3(0, -1, 0));
+
+	auto at = [segments] (unsigned int r, unsigned int s) { return 1 + (r - 1) * segments + s % segments; };
+	const auto south = static_cast<unsigned int>(vertices->size() - 1);
+	for (unsigned int s = 0; s < segments; ++s) {
+		indices->insert(indices->end(), {0, at(1, s + 1), at(1, s)});
+		indices->insert(indices->end(), {south, at(rings - 1, s), at(rings - 1, s + 1)});
+	}
+	for (unsigned int r = 1; r + 1 < rings; ++r) {
+		for (unsigned int s = 0; s < segments; ++s) {
+			indices->insert(indices->end(), {at(r, s), at(r, s + 1), at(r + 1, s)});
+			indices->insert(indices->end(), {at(r, s + 1), at(r + 1, s + 1), at(r + 1, s)});
+		}
+	}
+}
+
+template <typename F>
+double best_milliseconds(int runs, F&& body) {
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		body();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+}
+
+int main() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	uv_sphere(512, 1024, &vertices, &indices);
+	std::cout << "sphere: " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles\n";
+
+	for (std::size_t divisor : {2, 10, 100}) {
+		std::size_t target = indices.size() / divisor;
+		target -= target % 3;
+		std::size_t triangles = 0;
+		double ms = best_milliseconds(3, [&] {
+			triangles = ow::simplify(vertices, indices, target, 1.f).indices.size() / 3;
+		});
+		std::cout << "simplify to 1/" << divisor << ": " << ms << " ms, " << triangles << " triangles\n";
+	}
+
+	std::size_t level_count = 0;
+	double ms = best_milliseconds(3, [&] { level_count = ow::build_lod_chain(vertices, indices).size(); });
+	std::cout << "build_lod_chain: " << ms << " ms, " << level_count << " levels\n";
+	return 0;
+}
@@ -8,6 +8,7 @@
 #include <glad/glad.h>
 
 #include "checkable.hpp"
+#include "gl_state.hpp"
 #include "opengl_codes.hpp"
 #include "utils.hpp"
 
@@ -78,11 +79,9 @@ namespace ow {
 		}
 
 		~VBO() {
-			GLuint array[N];
 			for (auto i = 0u; i < N; ++i) {
-				array[i] = id(i);
+				gl_state::current().delete_buffer(id(i));
 			}
-			glDeleteBuffers(N, array);
 			check_errors("Chuck Norris exception.\n");
 		}
 
@@ -115,6 +114,22 @@ namespace ow {
 			size_of(idx) = sizeof(typename T::value_type);
 		}
 
+		// uploads raw bytes in the selected buffer, for interleaved vertices whose attributes
+		// are described by a vertex_format instead of the VBO_attribs (see vertex_format::setup).
+		// The buffer stays bound.
+		void set_bytes(const void* data, std::size_t byte_size, GLenum usage = GL_STATIC_DRAW) {
+			set_bytes_s(current_idx(), data, byte_size, usage);
+		}
+
+		void set_bytes_s(unsigned int idx, const void* data, std::size_t byte_size, GLenum usage = GL_STATIC_DRAW) {
+			bind(idx);
+			glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(byte_size), data, usage);
+			check_errors("Error while setting data in buffer " + std::to_string(id(idx)) + ".\n");
+			type(idx) = GL_NONE; // no single component type
+			usable(idx) = true;
+			size_of(idx) = 1;
+		}
+
 		void set_attributes(const VBO_attribs& attribs) noexcept {
 			m_attributes = attribs;
 		}
@@ -174,7 +189,7 @@ namespace ow {
 		}
 
 		void bind(unsigned int idx) {
-			glBindBuffer(GL_ARRAY_BUFFER, id(idx));
+			gl_state::current().bind_buffer(GL_ARRAY_BUFFER, id(idx));
 			p_state = check_errors("Error while binding array buffer " + std::to_string(id(idx)) + ".\n");
 		}
 
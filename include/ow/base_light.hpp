@@ -1,43 +1,91 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 #include <glm/glm.hpp>
 
 #include <ow/shader_program.hpp>
 
 namespace ow {
 
+// intensity under which a light is considered off: past it, an 8 bits framebuffer doesn't
+// show the difference.
+constexpr float LIGHT_CUTOFF_INTENSITY = 1.f / 256.f;
+
+// distance at which intensity / (constant + linear * d + quadratic * d^2) falls to cutoff,
+// infinite when the light is never attenuated.
+inline float attenuation_range(float constant, float linear, float quadratic, float intensity,
+							   float cutoff = LIGHT_CUTOFF_INTENSITY) {
+	float c = constant - intensity / cutoff;
+	if (c >= 0.f) {
+		return 0.f;
+	}
+	if (quadratic > 0.f) {
+		return (-linear + std::sqrt(linear * linear - 4.f * quadratic * c)) / (2.f * quadratic);
+	}
+	if (linear > 0.f) {
+		return -c / linear;
+	}
+	return std::numeric_limits<float>::infinity();
+}
+
 class base_light {
 public:
 	explicit base_light(glm::vec3 diffuse = glm::vec3(0.5f), glm::vec3 specular = glm::vec3(1.0f))
 		: m_diffuse(diffuse)
-		, m_specular(specular) {}
+		, m_specular(specular)
+		, m_version{1} {}
 
 	virtual ~base_light() noexcept = default;
 
-	virtual void update_all(const shader_program& prog, glm::mat4 /*view*/, const std::string& uniform_prefix = "light.") const {
-		prog.set(uniform_prefix + "diffuse", m_diffuse);
-		prog.set(uniform_prefix + "specular", m_specular);
+	virtual void update_all(const shader_program& prog, glm::mat4 /*view*/, std::string_view uniform_prefix = "light.") const {
+		prog.set(uniform_name(uniform_prefix, "diffuse"), m_diffuse);
+		prog.set(uniform_name(uniform_prefix, "specular"), m_specular);
 	}
 
 	void set_diffuse(glm::vec3 diffuse) {
-		m_diffuse = diffuse;
+		_set(&m_diffuse, diffuse);
 	}
 
 	void set_specular(glm::vec3 specular) {
-		m_specular = specular;
+		_set(&m_specular, specular);
 	}
 
-	glm::vec3 get_diffuse() {
+	glm::vec3 get_diffuse() const {
 		return m_diffuse;
 	}
 
-	glm::vec3 get_specular() {
+	glm::vec3 get_specular() const {
 		return m_specular;
 	}
 
+	// brightest channel of the diffuse and specular colors.
+	float get_intensity() const {
+		return std::max({m_diffuse.x, m_diffuse.y, m_diffuse.z, m_specular.x, m_specular.y, m_specular.z});
+	}
+
+	// changes each time a parameter of the light changes, setting a parameter to its
+	// current value doesn't count. lights_set only uploads the lights whose version changed.
+	std::uint64_t version() const noexcept {
+		return m_version;
+	}
+
+protected:
+	template <typename T>
+	void _set(T* parameter, const T& value) {
+		if (*parameter != value) {
+			*parameter = value;
+			++m_version;
+		}
+	}
+
 private:
 	glm::vec3 m_diffuse;
 	glm::vec3 m_specular;
+	std::uint64_t m_version;
 };
 
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+// axis aligned bounding box
+struct aabb {
+	glm::vec3 min{0.f};
+	glm::vec3 max{0.f};
+
+	glm::vec3 center() const {
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 extent() const {
+		return max - min;
+	}
+};
+
+struct bounding_sphere {
+	glm::vec3 center{0.f};
+	float radius = 0.f;
+};
+
+// empty vertices give a degenerate box and sphere at the origin.
+aabb compute_aabb(const vertex* vertices, std::size_t count);
+aabb compute_aabb(const std::vector<vertex>& vertices);
+
+// close to the minimal sphere (Ritter's algorithm), never bigger than the box's.
+bounding_sphere compute_bounding_sphere(const vertex* vertices, std::size_t count);
+bounding_sphere compute_bounding_sphere(const std::vector<vertex>& vertices);
+
+// box containing the transformed box (Arvo's method).
+aabb transform(const aabb& box, const glm::mat4& matrix);
+
+// sphere containing the transformed sphere, the radius is scaled by the largest axis scale.
+bounding_sphere transform(const bounding_sphere& sphere, const glm::mat4& matrix);
+
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/bounds.hpp>
+#include <ow/frustum.hpp>
+#include <ow/thread_pool.hpp>
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+constexpr float NO_HIT = std::numeric_limits<float>::infinity();
+
+// whether a distance is NO_HIT, without comparing floats for equality (NaNs are misses too).
+constexpr bool missed(float distance) noexcept {
+	return !(distance < NO_HIT);
+}
+
+// points at origin + t * direction. direction doesn't need to be normalized,
+// distances are then expressed in multiples of its length.
+struct ray {
+	glm::vec3 origin;
+	glm::vec3 direction;
+};
+
+// world space ray from the camera through a cursor position, in pixels from the top left
+// corner of the viewport (the GLFW convention). The direction is normalized.
+ray ray_through_cursor(const glm::mat4& proj, const glm::mat4& view, glm::vec2 cursor, glm::vec2 viewport_size);
+
+// same ray expressed in another space: the parameter t of a point is unchanged.
+ray transform(const ray& r, const glm::mat4& matrix);
+
+// entry distance of the ray into the box, NO_HIT if it misses it before max_distance.
+// Conservative: rays grazing a face hit it despite rounding.
+float intersect(const ray& r, const aabb& box, float max_distance = NO_HIT);
+
+// Bounding volume hierarchy over primitives given by their boxes, built with the
+// surface area heuristic. Nodes are stored depth first: children always come after
+// their parent, so refitting is a single reverse pass.
+class bvh {
+public:
+	struct node {
+		aabb bounds;
+		std::uint32_t first; // leaf: first index in primitives(), inner node: first child (the second follows)
+		std::uint32_t count; // number of primitives, 0 for inner nodes
+	};
+
+	// builds over the given primitives (indices in primitive_bounds).
+	void build(const std::vector<aabb>& primitive_bounds, std::vector<std::uint32_t> primitives);
+
+	// updates the node bounds after primitives moved, the tree itself is kept.
+	void refit(const std::vector<aabb>& primitive_bounds);
+
+	// renames the primitives 0, 1, 2... in leaf order and returns their previous names, so that
+	// callers can store their data in the same order as the traversals read it.
+	std::vector<std::uint32_t> renumber_primitives();
+
+	bool empty() const noexcept {
+		return m_nodes.empty();
+	}
+
+	const std::vector<node>& nodes() const noexcept {
+		return m_nodes;
+	}
+
+	// primitives in leaf order
+	const std::vector<std::uint32_t>& primitives() const noexcept {
+		return m_primitives;
+	}
+
+	// calls on_primitive(primitive) for every primitive whose box intersects the frustum.
+	template <typename F>
+	void query(const frustum& view_frustum, const std::vector<aabb>& primitive_bounds, F&& on_primitive) const {
+		_traverse([&view_frustum] (const node& n, bool* contained) {
+			if (*contained) {
+				return true;
+			}
+			if (!view_frustum.intersects(n.bounds)) {
+				return false;
+			}
+			*contained = view_frustum.contains(n.bounds); // no need to test below.
+			return true;
+		}, [&] (std::uint32_t primitive, bool contained) {
+			if (contained || view_frustum.intersects(primitive_bounds[primitive])) {
+				on_primitive(primitive);
+			}
+		});
+	}
+
+	// nearest hit: hit_primitive(primitive, max_distance) returns the distance of the hit
+	// or NO_HIT. Returns the nearest distance found, NO_HIT if none.
+	template <typename F>
+	float raycast(const ray& r, float max_distance, F&& hit_primitive) const {
+		if (m_nodes.empty()) {
+			return NO_HIT;
+		}
+
+		float nearest = max_distance;
+		bool found = false;
+		std::array<std::uint32_t, MAX_DEPTH> stack;
+		std::size_t stack_size = 0;
+		std::uint32_t current = 0;
+		if (missed(intersect(r, m_nodes[0].bounds, nearest))) {
+			return NO_HIT;
+		}
+
+		for (;;) {
+			const node& n = m_nodes[current];
+			if (n.count > 0) {
+				for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+					float distance = hit_primitive(m_primitives[i], nearest);
+					if (distance < nearest) {
+						nearest = distance;
+						found = true;
+					}
+				}
+			} else {
+				// visit the nearest child first, it may shorten the ray for the other one.
+				float left = intersect(r, m_nodes[n.first].bounds, nearest);
+				float right = intersect(r, m_nodes[n.first + 1].bounds, nearest);
+				std::uint32_t near_child = left <= right ? n.first : n.first + 1;
+				std::uint32_t far_child = left <= right ? n.first + 1 : n.first;
+				if (!missed(std::min(left, right))) {
+					if (!missed(std::max(left, right))) {
+						stack[stack_size++] = far_child;
+					}
+					current = near_child;
+					continue;
+				}
+			}
+
+			// pop the next node still closer than the nearest hit.
+			do {
+				if (stack_size == 0) {
+					return found ? nearest : NO_HIT;
+				}
+				current = stack[--stack_size];
+			} while (missed(intersect(r, m_nodes[current].bounds, nearest)));
+		}
+	}
+
+private:
+	static constexpr std::size_t MAX_DEPTH = 64;
+
+	// visit(node, &contained) decides whether to descend, contained is inherited by the children
+	// and passed to on_primitive(primitive, contained) in the leaves.
+	template <typename Visit, typename F>
+	void _traverse(Visit&& visit, F&& on_primitive) const {
+		if (m_nodes.empty()) {
+			return;
+		}
+
+		std::array<std::pair<std::uint32_t, bool>, MAX_DEPTH> stack;
+		std::size_t stack_size = 0;
+		stack[stack_size++] = {0, false};
+		while (stack_size > 0) {
+			auto [index, contained] = stack[--stack_size];
+			const node& n = m_nodes[index];
+			if (!visit(n, &contained)) {
+				continue;
+			}
+			if (n.count > 0) {
+				for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+					on_primitive(m_primitives[i], contained);
+				}
+			} else {
+				stack[stack_size++] = {n.first + 1, contained};
+				stack[stack_size++] = {n.first, contained};
+			}
+		}
+	}
+
+	void _build_node(std::uint32_t index, std::uint32_t begin, std::uint32_t end, const std::vector<aabb>& primitive_bounds,
+					 const std::vector<glm::vec3>& centroids, std::size_t depth);
+
+private:
+	std::vector<node> m_nodes{};
+	std::vector<std::uint32_t> m_primitives{};
+};
+
+// Dynamic set of objects known by their world space box.
+// Insertions and removals rebuild the tree on commit(), updates only refit it.
+class scene_bvh {
+public:
+	using object_id = std::uint32_t;
+	static constexpr object_id INVALID_OBJECT = std::numeric_limits<object_id>::max();
+
+	struct hit {
+		object_id object = INVALID_OBJECT;
+		float distance = NO_HIT;
+
+		explicit operator bool() const noexcept {
+			return object != INVALID_OBJECT;
+		}
+	};
+
+	object_id insert(const aabb& bounds);
+	void remove(object_id object);
+	void update(object_id object, const aabb& bounds);
+
+	// applies the pending changes, must be called before querying.
+	void commit();
+
+	std::size_t size() const noexcept {
+		return m_bounds.size() - m_free.size();
+	}
+
+	const aabb& bounds(object_id object) const {
+		return m_bounds[object];
+	}
+
+	// objects which may be visible, appended to *visible.
+	void query(const frustum& view_frustum, std::vector<object_id>* visible) const;
+
+	// nearest object whose box is hit.
+	hit raycast(const ray& r, float max_distance = NO_HIT) const {
+		return raycast(r, [this, &r] (object_id object, float max) {
+			return intersect(r, m_bounds[object], max);
+		}, max_distance);
+	}
+
+	// nearest hit with a narrow phase: narrow(object, max_distance) returns the hit
+	// distance (NO_HIT if missed), it is only called for objects whose box is hit.
+	template <typename Narrow>
+	hit raycast(const ray& r, Narrow&& narrow, float max_distance = NO_HIT) const {
+		hit result;
+		m_bvh.raycast(r, max_distance, [&] (std::uint32_t object, float max) {
+			if (missed(intersect(r, m_bounds[object], max))) {
+				return NO_HIT;
+			}
+			float distance = narrow(object, max);
+			if (distance < result.distance) {
+				result = {object, distance};
+			}
+			return distance;
+		});
+		return result;
+	}
+
+	// casts every ray on the global thread pool. narrow is called concurrently.
+	template <typename Narrow>
+	void raycast(const std::vector<ray>& rays, std::vector<hit>* hits, Narrow&& narrow) const {
+		constexpr std::size_t RAYS_PER_TASK = 256;
+		hits->resize(rays.size());
+		thread_pool::global().parallel_for((rays.size() + RAYS_PER_TASK - 1) / RAYS_PER_TASK, [&] (std::size_t task) {
+			std::size_t end = std::min(rays.size(), (task + 1) * RAYS_PER_TASK);
+			for (std::size_t i = task * RAYS_PER_TASK; i < end; ++i) {
+				(*hits)[i] = raycast(rays[i], narrow);
+			}
+		});
+	}
+
+private:
+	std::vector<aabb> m_bounds{};
+	std::vector<bool> m_alive{};
+	std::vector<object_id> m_free{};
+	bvh m_bvh{};
+	bool m_needs_build = false;
+	bool m_needs_refit = false;
+};
+
+// BVH over the triangles of a mesh, for ray casts in mesh space.
+class triangle_bvh {
+public:
+	struct hit {
+		std::uint32_t triangle = std::numeric_limits<std::uint32_t>::max(); // index in the triangle list
+		float distance = NO_HIT;
+		glm::vec2 barycentric{0.f}; // weights of the second and third vertices
+
+		explicit operator bool() const noexcept {
+			return !missed(distance);
+		}
+	};
+
+	triangle_bvh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices);
+
+	hit raycast(const ray& r, float max_distance = NO_HIT) const;
+
+	std::size_t triangle_count() const noexcept {
+		return m_triangle_ids.size();
+	}
+
+private:
+	bvh m_bvh;
+	std::vector<glm::vec3> m_corners;          // 3 per triangle, in leaf order
+	std::vector<std::uint32_t> m_triangle_ids; // original index of each triangle, in leaf order
+};
+
+}
@@ -79,6 +79,11 @@ public:
 		return m_pitch;
 	}
 
+	// vertical field of view, in radians
+	float get_fov() const {
+		return m_fov;
+	}
+
 private:
 	// Calculates the front vector from the Camera's (updated) Euler Angles
 	void _update_camera_vectors();
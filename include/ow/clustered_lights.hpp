@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ow/light_clusters.hpp>
+#include <ow/light_texels.hpp>
+#include <ow/lights_set.hpp>
+#include <ow/shader_program.hpp>
+
+namespace ow {
+
+// Clustered forward shading: each frame, the point lights and spotlights of a lights_set are
+// assigned to the clusters of the view frustum (see light_clusters), and
+// phong_clustered_frag.glsl only shades a fragment with the lights of its cluster.
+// Directional lights are still read from the `Lights` block: lights_set::upload must be
+// called too. Lights and lists are stored in texture buffers, OpenGL 3.3 has no storage buffer.
+class clustered_lights {
+public:
+	// texture units of the buffers, the skybox uses the last one.
+	static constexpr GLuint LIGHTS_UNIT = 12;
+	static constexpr GLuint RANGES_UNIT = 13;
+	static constexpr GLuint INDICES_UNIT = 14;
+
+	explicit clustered_lights(cluster_grid grid = {});
+	clustered_lights(const clustered_lights& other) = delete;
+	~clustered_lights();
+	clustered_lights& operator=(const clustered_lights& other) = delete;
+
+	// packs the lights (see light_texels.hpp), assigns them, uploads everything and binds
+	// the buffers to their units. Lights and indices past GL_MAX_TEXTURE_BUFFER_SIZE are dropped.
+	void update(const lights_set& lights, const glm::mat4& view, const glm::mat4& proj);
+
+	// uniforms of phong_clustered_frag.glsl, the tiles are sized after the current viewport.
+	void set_uniforms(const shader_program& prog) const;
+
+	const light_clusters& clusters() const noexcept {
+		return m_clusters;
+	}
+
+	const cluster_stats& stats() const noexcept {
+		return m_clusters.stats();
+	}
+
+private:
+	void _create();
+
+private:
+	light_clusters m_clusters;
+	sphere_batch m_bounds;
+	std::vector<glm::vec4> m_texels;
+
+	// lights, cluster ranges and indices.
+	std::array<GLuint, 3> m_buffers;
+	std::array<GLuint, 3> m_textures;
+	std::size_t m_max_texels;
+};
+
+}
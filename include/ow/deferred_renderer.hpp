@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ow/frustum.hpp>
+#include <ow/lights_set.hpp>
+#include <ow/shader_program.hpp>
+
+namespace ow {
+
+// Deferred shading, an alternative to the forward phong programs on the same scene:
+//  1. geometry_pass(): opaque meshes are drawn with geometry_program(), which stores view
+//     space normals, albedo, specular color and shininess in the G-buffer, with the depth.
+//  2. lighting_pass(): a full screen triangle applies the directional lights of the `Lights`
+//     block, then every point light and spotlight is drawn as the back faces of a sphere
+//     around its range: only the pixels inside it are shaded.
+//  3. forward_pass(): what the G-buffer can't hold (emissive, transparent meshes) is drawn
+//     with the forward programs, over the lit image and against the scene depth.
+//  4. present(): the lit image is copied to the viewport of the default framebuffer.
+// The passes render at the viewport size, the buffers are reallocated when it changes.
+// lights_set::upload must be called before lighting_pass, for the directional lights.
+class deferred_renderer {
+public:
+	// texture units of the G-buffer: normal, albedo, specular and depth from this one.
+	static constexpr GLuint GBUFFER_UNIT = 8;
+	// the lights texture buffer, in the layout of light_texels.hpp.
+	static constexpr GLuint LIGHTS_UNIT = 12;
+
+	deferred_renderer();
+	deferred_renderer(const deferred_renderer& other) = delete;
+	~deferred_renderer();
+	deferred_renderer& operator=(const deferred_renderer& other) = delete;
+
+	// program to draw the opaque meshes with during the geometry pass. Like the forward
+	// programs, its materials_shininess uniform is set by the caller.
+	const shader_program& geometry_program() const noexcept {
+		return m_geometry_prog;
+	}
+
+	// binds and clears the G-buffer, and sets the view and proj uniforms of geometry_program().
+	void geometry_pass(const glm::mat4& view, const glm::mat4& proj);
+
+	// shades the G-buffer into the lit image. Leaves the GL state as it found it.
+	void lighting_pass(const lights_set& lights, const glm::mat4& view, const glm::mat4& proj);
+
+	// binds the lit image, with the depth of the geometry pass.
+	void forward_pass();
+
+	// copies the lit image to the default framebuffer, which is bound again.
+	void present();
+
+	// point lights and spotlights drawn by the last lighting pass.
+	std::size_t light_volumes() const noexcept {
+		return m_light_count;
+	}
+
+private:
+	void _resize(GLsizei width, GLsizei height);
+	void _destroy_targets();
+
+private:
+	shader_program m_geometry_prog;
+	shader_program m_directional_prog;
+	shader_program m_volume_prog;
+
+	GLuint m_gbuffer;
+	std::array<GLuint, 4> m_gbuffer_textures; // normal, albedo, specular, depth
+	GLuint m_lighting;
+	GLuint m_lit_color;  // renderbuffer
+	GLuint m_lit_depth;  // renderbuffer, copy of the G-buffer depth: it is sampled while shading
+	GLsizei m_width;
+	GLsizei m_height;
+	std::array<GLint, 4> m_viewport; // of the default framebuffer, restored by present
+
+	// unit sphere of the light volumes, and a vertex array without attributes for the
+	// full screen triangle.
+	GLuint m_sphere_vertex_array;
+	GLuint m_sphere_vertices;
+	GLuint m_sphere_indices;
+	GLsizei m_sphere_index_count;
+	GLuint m_empty_vertex_array;
+
+	GLuint m_lights_buffer;
+	GLuint m_lights_texture;
+	std::vector<glm::vec4> m_texels;
+	sphere_batch m_bounds;
+	std::size_t m_max_lights; // that GL_MAX_TEXTURE_BUFFER_SIZE allows
+	std::size_t m_light_count;
+};
+
+}
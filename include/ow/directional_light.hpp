@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 
 #include <ow/base_light.hpp>
+#include <ow/light_block.hpp>
 
 namespace ow {
 
@@ -18,19 +19,24 @@ public:
 		, m_direction(direction)
 		, m_ambient(ambient) {}
 
-	void update_all(const shader_program& prog, glm::mat4 view, const std::string& uniform_prefix = "dir_light.") const override {
+	void update_all(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "dir_light.") const override {
 		base_light::update_all(prog, view, uniform_prefix);
 
-		prog.set(uniform_prefix + "direction", glm::vec3(view * glm::vec4(m_direction, 0)));
-		prog.set(uniform_prefix + "ambient", m_ambient);
+		prog.set(uniform_name(uniform_prefix, "direction"), glm::vec3(view * glm::vec4(m_direction, 0)));
+		prog.set(uniform_name(uniform_prefix, "ambient"), m_ambient);
 	}
 
-	void update_direction(const shader_program& prog, glm::mat4 view, const std::string& uniform_prefix = "dir_light.") const {
-		prog.set(uniform_prefix + "direction", glm::vec3(view * glm::vec4(m_direction, 0)));
+	void update_direction(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "dir_light.") const {
+		prog.set(uniform_name(uniform_prefix, "direction"), glm::vec3(view * glm::vec4(m_direction, 0)));
+	}
+
+	// the light as laid out in the lights uniform block.
+	std140_directional_light to_block(const glm::mat4& view) const {
+		return {glm::vec3(view * glm::vec4(m_direction, 0)), 0.f, m_ambient, 0.f, get_diffuse(), 0.f, get_specular(), 0.f};
 	}
 
 	void set_dir(glm::vec3 dir) {
-		m_direction = dir;
+		_set(&m_direction, dir);
 	}
 
 private:
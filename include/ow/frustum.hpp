@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/bounds.hpp>
+
+namespace ow {
+
+// View frustum as 6 planes (left, right, bottom, top, near, far) pointing inward,
+// normalized so that dot(plane, vec4(p, 1)) is the signed distance of p.
+class frustum {
+public:
+	// extracts the planes from proj * view (Gribb and Hartmann): the planes are in world space.
+	frustum(const glm::mat4& proj, const glm::mat4& view);
+
+	bool intersects(const bounding_sphere& sphere) const;
+	bool intersects(const aabb& box) const;
+
+	// true when the box is completely inside.
+	bool contains(const aabb& box) const;
+
+	const std::array<glm::vec4, 6>& planes() const noexcept {
+		return m_planes;
+	}
+
+private:
+	std::array<glm::vec4, 6> m_planes;
+};
+
+// bounding spheres stored as structure of arrays, the layout the culling kernels read.
+struct sphere_batch {
+	std::vector<float> x{}, y{}, z{}, radius{};
+
+	void clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	void push_back(const bounding_sphere& sphere) {
+		x.push_back(sphere.center.x);
+		y.push_back(sphere.center.y);
+		z.push_back(sphere.center.z);
+		radius.push_back(sphere.radius);
+	}
+
+	std::size_t size() const noexcept {
+		return x.size();
+	}
+};
+
+struct culling_stats {
+	std::size_t visible;
+	std::size_t culled;
+};
+
+enum class culling_kernel {
+	automatic, // best one supported by the CPU
+	scalar,
+	sse,       // 4 spheres at once
+	avx2       // 8 spheres at once
+};
+
+// kernel used by culling_kernel::automatic.
+culling_kernel best_culling_kernel() noexcept;
+
+// tests every sphere of the batch against the frustum: (*visibility)[i] is set to 1 when
+// sphere i may be visible, 0 otherwise. Unsupported kernels fall back to the best one available.
+culling_stats cull_spheres(const frustum& view_frustum, const sphere_batch& spheres, std::vector<unsigned char>* visibility,
+						   culling_kernel kernel = culling_kernel::automatic);
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string_view>
+
+#include <glad/glad.h>
+
+// glad is generated for the OpenGL 3.3 core profile: the entry points and enums of newer
+// versions and of the extensions used by the wrapper are declared here instead.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#define GL_GEOMETRY_SHADER_BIT 0x00000004
+#define GL_ALL_SHADER_BITS 0xFFFFFFFF
+#define GL_PROGRAM_SEPARABLE 0x8258
+#define GL_PROGRAM_PIPELINE_BINDING 0x825A
+#endif
+
+namespace ow {
+
+using get_program_binary_proc = void (APIENTRYP)(GLuint program, GLsizei buf_size, GLsizei* length,
+												  GLenum* binary_format, void* binary);
+using program_binary_proc = void (APIENTRYP)(GLuint program, GLenum binary_format, const void* binary,
+											  GLsizei length);
+using program_parameteri_proc = void (APIENTRYP)(GLuint program, GLenum pname, GLint value);
+using max_shader_compiler_threads_proc = void (APIENTRYP)(GLuint count);
+using gen_program_pipelines_proc = void (APIENTRYP)(GLsizei n, GLuint* pipelines);
+using delete_program_pipelines_proc = void (APIENTRYP)(GLsizei n, const GLuint* pipelines);
+using bind_program_pipeline_proc = void (APIENTRYP)(GLuint pipeline);
+using use_program_stages_proc = void (APIENTRYP)(GLuint pipeline, GLbitfield stages, GLuint program);
+using program_uniform_1i_proc = void (APIENTRYP)(GLuint program, GLint location, GLint v0);
+using program_uniform_1ui_proc = void (APIENTRYP)(GLuint program, GLint location, GLuint v0);
+using program_uniform_1f_proc = void (APIENTRYP)(GLuint program, GLint location, GLfloat v0);
+using program_uniform_2f_proc = void (APIENTRYP)(GLuint program, GLint location, GLfloat v0, GLfloat v1);
+using program_uniform_3f_proc = void (APIENTRYP)(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+using program_uniform_4f_proc = void (APIENTRYP)(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2,
+												  GLfloat v3);
+using program_uniform_fv_proc = void (APIENTRYP)(GLuint program, GLint location, GLsizei count, const GLfloat* value);
+using program_uniform_matrix_fv_proc = void (APIENTRYP)(GLuint program, GLint location, GLsizei count,
+														 GLboolean transpose, const GLfloat* value);
+
+// Entry points and features above OpenGL 3.3, filled by load_gl_extensions. Pointers are null
+// when neither the context version nor an extension provides them.
+struct gl_extensions {
+	int major_version;
+	int minor_version;
+
+	// OpenGL 4.1 or GL_ARB_get_program_binary, with at least one binary format.
+	bool program_binary;
+	get_program_binary_proc GetProgramBinary;
+	program_binary_proc ProgramBinary;
+	program_parameteri_proc ProgramParameteri;
+
+	// GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile: compiles and links
+	// run on driver threads, GL_COMPLETION_STATUS_KHR tells when they are done.
+	bool parallel_shader_compile;
+	max_shader_compiler_threads_proc MaxShaderCompilerThreads;
+
+	// OpenGL 4.1 or GL_ARB_separate_shader_objects: programs of a single stage, combined by
+	// program pipelines, and uniforms set without using the program.
+	bool separate_shader_objects;
+	gen_program_pipelines_proc GenProgramPipelines;
+	delete_program_pipelines_proc DeleteProgramPipelines;
+	bind_program_pipeline_proc BindProgramPipeline;
+	use_program_stages_proc UseProgramStages;
+	program_uniform_1i_proc ProgramUniform1i;
+	program_uniform_1ui_proc ProgramUniform1ui;
+	program_uniform_1f_proc ProgramUniform1f;
+	program_uniform_2f_proc ProgramUniform2f;
+	program_uniform_3f_proc ProgramUniform3f;
+	program_uniform_4f_proc ProgramUniform4f;
+	program_uniform_fv_proc ProgramUniform2fv;
+	program_uniform_fv_proc ProgramUniform3fv;
+	program_uniform_fv_proc ProgramUniform4fv;
+	program_uniform_matrix_fv_proc ProgramUniformMatrix2fv;
+	program_uniform_matrix_fv_proc ProgramUniformMatrix3fv;
+	program_uniform_matrix_fv_proc ProgramUniformMatrix4fv;
+
+	// the context version is at least major.minor.
+	bool version(int major, int minor) const noexcept {
+		return major_version > major || (major_version == major && minor_version >= minor);
+	}
+
+	// state of the current context, everything is off until load_gl_extensions is called.
+	static const gl_extensions& current() noexcept;
+};
+
+// call once glad is loaded, with the same function. Returns false if there is no context.
+bool load_gl_extensions(GLADloadproc load);
+
+// GL_EXTENSIONS of the current context contains name.
+bool has_gl_extension(std::string_view name);
+
+}
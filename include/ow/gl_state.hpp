@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+// Shadow copy of the OpenGL state used by the library: calls which wouldn't change it
+// never reach the driver, and the current values are read without glGet.
+// Everything binding objects or changing this state must go through it, raw calls make
+// it stale (see invalidate()). Values not known yet are read from OpenGL on first use.
+// The library uses a single context: there is one tracker, current().
+class gl_state {
+public:
+	static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+	static constexpr GLuint MAX_UNIFORM_BINDINGS = 16;
+
+	struct blend_state {
+		GLenum src;
+		GLenum dst;
+		GLenum equation_rgb;
+		GLenum equation_alpha;
+	};
+
+	struct call_stats {
+		std::size_t issued;  // calls which reached the driver
+		std::size_t skipped; // calls which wouldn't have changed anything
+	};
+
+	static gl_state& current();
+
+	gl_state();
+	gl_state(const gl_state& other) = delete;
+	gl_state& operator=(const gl_state& other) = delete;
+
+	void use_program(GLuint program);
+	GLuint program();
+
+	// GL_ARB_separate_shader_objects (see program_pipeline): the pipeline is only used while
+	// no program is.
+	void bind_program_pipeline(GLuint pipeline);
+	GLuint program_pipeline();
+
+	// the element array buffer binding is part of the vertex array.
+	void bind_vertex_array(GLuint vertex_array);
+	GLuint vertex_array();
+
+	void bind_buffer(GLenum target, GLuint buffer);
+	GLuint buffer(GLenum target);
+
+	// glBindBufferBase, which also changes the generic binding. Only the uniform buffer
+	// binding points are tracked.
+	void bind_buffer_base(GLenum target, GLuint index, GLuint buffer);
+
+	// GL_FRAMEBUFFER binds both the draw and the read framebuffers.
+	void bind_framebuffer(GLenum target, GLuint framebuffer);
+	GLuint framebuffer(GLenum target);
+
+	// unit is a number, not GL_TEXTURE0 + unit.
+	void active_texture(GLuint unit);
+	GLuint active_texture();
+
+	// binds on the active unit.
+	void bind_texture(GLenum target, GLuint texture);
+
+	// binds on the given unit, which becomes the active one if the binding changes.
+	void bind_texture(GLuint unit, GLenum target, GLuint texture);
+	GLuint texture(GLuint unit, GLenum target);
+
+	void set_enabled(GLenum capability, bool enabled);
+	bool is_enabled(GLenum capability);
+
+	void blend_func(GLenum src, GLenum dst);
+	void blend_equation(GLenum equation_rgb, GLenum equation_alpha);
+	blend_state blend();
+
+	void depth_mask(bool write);
+	bool depth_mask();
+	void depth_func(GLenum func);
+	GLenum depth_func();
+
+	void cull_face(GLenum face);
+	GLenum cull_face();
+
+	void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	std::array<GLint, 4> viewport();
+
+	void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+	std::array<GLint, 4> scissor();
+
+	// use these instead of glDelete*: OpenGL unbinds the deleted objects.
+	void delete_program(GLuint program);
+	void delete_program_pipeline(GLuint pipeline);
+	void delete_vertex_array(GLuint vertex_array);
+	void delete_buffer(GLuint buffer);
+	void delete_texture(GLuint texture);
+	void delete_framebuffer(GLuint framebuffer);
+
+	// forgets everything, for state changed behind the tracker's back.
+	void invalidate();
+
+	// debug mode: compares the known values with OpenGL after every change, and logs the
+	// differences. Slow, each check does a few dozens glGet.
+	void set_validation(bool enabled) noexcept {
+		m_validation = enabled;
+	}
+
+	// compares the known values with OpenGL, logs and returns false on a difference.
+	bool validate();
+
+	const call_stats& stats() const noexcept {
+		return m_stats;
+	}
+
+	void reset_stats() noexcept {
+		m_stats = {};
+	}
+
+private:
+	// tracked buffer targets and capabilities, others always reach the driver.
+	static constexpr std::array<GLenum, 7> BUFFER_TARGETS = {
+		GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		GL_PIXEL_UNPACK_BUFFER, GL_UNIFORM_BUFFER, GL_TEXTURE_BUFFER
+	};
+	static constexpr std::array<GLenum, 6> CAPABILITIES = {
+		GL_BLEND, GL_CULL_FACE, GL_DEPTH_CLAMP, GL_DEPTH_TEST, GL_SCISSOR_TEST, GL_STENCIL_TEST
+	};
+	static constexpr std::array<GLenum, 3> TEXTURE_TARGETS = {GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER};
+
+	// returns true when the call must be issued, and records the new value.
+	template <typename T>
+	bool _change(std::optional<T>* known, const T& value) {
+		if (*known == value) {
+			++m_stats.skipped;
+			return false;
+		}
+		*known = value;
+		++m_stats.issued;
+		return true;
+	}
+
+	void _changed();
+
+	static std::size_t _index(GLenum value, const GLenum* values, std::size_t count);
+
+private:
+	std::optional<GLuint> m_program;
+	std::optional<GLuint> m_program_pipeline;
+	std::optional<GLuint> m_vertex_array;
+	std::optional<GLuint> m_draw_framebuffer;
+	std::optional<GLuint> m_read_framebuffer;
+	std::array<std::optional<GLuint>, BUFFER_TARGETS.size()> m_buffers;
+	std::array<std::optional<GLuint>, MAX_UNIFORM_BINDINGS> m_uniform_bindings;
+	std::optional<GLuint> m_active_texture;
+	std::array<std::array<std::optional<GLuint>, TEXTURE_TARGETS.size()>, MAX_TEXTURE_UNITS> m_textures;
+	std::array<std::optional<bool>, CAPABILITIES.size()> m_capabilities;
+	std::optional<std::array<GLenum, 2>> m_blend_func;
+	std::optional<std::array<GLenum, 2>> m_blend_equation;
+	std::optional<bool> m_depth_mask;
+	std::optional<GLenum> m_depth_func;
+	std::optional<GLenum> m_cull_face;
+	std::optional<std::array<GLint, 4>> m_viewport;
+	std::optional<std::array<GLint, 4>> m_scissor;
+
+	bool m_validation;
+	call_stats m_stats;
+};
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ow {
+
+// Decoded image in CPU memory, ready to be uploaded with glTexImage2D.
+// Loading does not touch any OpenGL state nor stb_image's global settings,
+// so images can be decoded from any thread.
+struct image {
+	image() noexcept : data(nullptr), width(0), height(0), channels(0) {}
+	image(const image& other) = delete;
+	image(image&& other) noexcept;
+	~image();
+	image& operator=(const image& other) = delete;
+	image& operator=(image&& other) noexcept;
+
+	static image load(const std::string& filename, bool flip_vertically = true);
+
+	explicit operator bool() const { return data != nullptr; }
+
+	std::size_t byte_size() const {
+		return static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * static_cast<std::size_t>(channels);
+	}
+
+	unsigned char* data;
+	int width;
+	int height;
+	int channels;
+};
+
+}
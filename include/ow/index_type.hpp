@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+// storage width of an index buffer.
+enum class index_type {
+	u8,
+	u16,
+	u32
+};
+
+// narrowest type able to address vertex_count vertices, but not narrower than minimum.
+// 8 bits indices are not the default: several desktop drivers convert them on the CPU.
+index_type index_type_for(std::size_t vertex_count, index_type minimum = index_type::u16) noexcept;
+
+// size in bytes of one index.
+std::size_t index_type_size(index_type type) noexcept;
+
+// matching type for glDrawElements and friends.
+GLenum index_type_to_gl(index_type type) noexcept;
+
+// narrows indices to the given type, ready to upload. Throws std::invalid_argument on an unknown type.
+std::vector<unsigned char> pack_indices(const std::vector<unsigned int>& indices, index_type type);
+
+}
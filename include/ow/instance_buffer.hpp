@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ow/vertex_format.hpp>
+
+namespace ow {
+
+// per instance data of instanced draws, read by the vertex shaders as
+// `instance_model` (locations 3 to 6) and `instance_color` (location 7).
+struct instance {
+	glm::mat4 model;
+	glm::vec4 color; // free for the shaders, the lamps use it as their color
+
+	// a mat4 attribute takes one location per column.
+	using format = vertex_format<float_attribute<4>, float_attribute<4>, float_attribute<4>, float_attribute<4>,
+								 float_attribute<4>>;
+};
+
+static_assert(sizeof(instance) == instance::format::size);
+
+// GPU buffer of instances, bound as divisor 1 attributes of a VAO for the duration of a draw.
+class instance_buffer {
+public:
+	// first location after the vertex attributes (see vertex::format).
+	static constexpr GLuint FIRST_LOCATION = 3;
+
+	instance_buffer();
+	instance_buffer(const instance_buffer& other) = delete;
+	instance_buffer(instance_buffer&& other) noexcept;
+	~instance_buffer();
+	instance_buffer& operator=(const instance_buffer& other) = delete;
+
+	// replaces the instances. The storage is orphaned, so that the previous
+	// draws still reading it don't stall the upload.
+	void set_data(const std::vector<instance>& instances);
+
+	std::size_t size() const noexcept {
+		return m_size;
+	}
+
+	// points the instance attributes of the bound VAO to this buffer.
+	void attach() const;
+
+	// disables the instance attributes of the bound VAO, regular draws don't read them.
+	static void detach();
+
+private:
+	GLuint m_buffer;
+	std::size_t m_size;
+	std::size_t m_capacity;
+};
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace ow {
+
+// C++ mirror of the std140 `Lights` uniform block of resources/shaders/include/lights.glsl:
+// any change here must be made there too.
+// A vec3 followed by a float shares a single 16 bytes slot.
+
+// binding point of the block, set on every program declaring it when it is linked.
+constexpr GLuint LIGHTS_BLOCK_BINDING = 0;
+constexpr const char* LIGHTS_BLOCK_NAME = "Lights";
+
+constexpr std::size_t MAX_DIR_LIGHTS = 8;
+constexpr std::size_t MAX_POINT_LIGHTS = 128;
+constexpr std::size_t MAX_SPOTLIGHTS = 64;
+
+struct alignas(16) std140_directional_light {
+	glm::vec3 direction{0.f}; // view space
+	float padding0 = 0.f;
+	glm::vec3 ambient{0.f};
+	float padding1 = 0.f;
+	glm::vec3 diffuse{0.f};
+	float padding2 = 0.f;
+	glm::vec3 specular{0.f};
+	float padding3 = 0.f;
+};
+
+struct alignas(16) std140_point_light {
+	glm::vec3 position{0.f}; // view space
+	float attenuation_constant = 0.f;
+	glm::vec3 diffuse{0.f};
+	float attenuation_linear = 0.f;
+	glm::vec3 specular{0.f};
+	float attenuation_quadratic = 0.f;
+};
+
+struct alignas(16) std140_spotlight {
+	glm::vec3 position{0.f}; // view space
+	float cutoff = 0.f;
+	glm::vec3 direction{0.f}; // view space
+	float outer_cutoff = 0.f;
+	glm::vec3 diffuse{0.f};
+	float attenuation_constant = 0.f;
+	glm::vec3 specular{0.f};
+	float attenuation_linear = 0.f;
+	float attenuation_quadratic = 0.f;
+};
+
+struct alignas(16) std140_lights_block {
+	std::int32_t nbr_dir_lights = 0;
+	std::int32_t nbr_point_lights = 0;
+	std::int32_t nbr_spotlights = 0;
+	std::int32_t padding = 0;
+	std140_directional_light dir_lights[MAX_DIR_LIGHTS]{};
+	std140_point_light point_lights[MAX_POINT_LIGHTS]{};
+	std140_spotlight spotlights[MAX_SPOTLIGHTS]{};
+};
+
+static_assert(sizeof(glm::vec3) == 12, "glm::vec3 must be tightly packed");
+
+static_assert(offsetof(std140_directional_light, ambient) == 16);
+static_assert(offsetof(std140_directional_light, diffuse) == 32);
+static_assert(offsetof(std140_directional_light, specular) == 48);
+static_assert(sizeof(std140_directional_light) == 64);
+
+static_assert(offsetof(std140_point_light, attenuation_constant) == 12);
+static_assert(offsetof(std140_point_light, diffuse) == 16);
+static_assert(offsetof(std140_point_light, attenuation_linear) == 28);
+static_assert(offsetof(std140_point_light, specular) == 32);
+static_assert(offsetof(std140_point_light, attenuation_quadratic) == 44);
+static_assert(sizeof(std140_point_light) == 48);
+
+static_assert(offsetof(std140_spotlight, cutoff) == 12);
+static_assert(offsetof(std140_spotlight, direction) == 16);
+static_assert(offsetof(std140_spotlight, outer_cutoff) == 28);
+static_assert(offsetof(std140_spotlight, diffuse) == 32);
+static_assert(offsetof(std140_spotlight, attenuation_constant) == 44);
+static_assert(offsetof(std140_spotlight, specular) == 48);
+static_assert(offsetof(std140_spotlight, attenuation_linear) == 60);
+static_assert(offsetof(std140_spotlight, attenuation_quadratic) == 64);
+static_assert(sizeof(std140_spotlight) == 80); // a struct size is rounded up to 16
+
+static_assert(offsetof(std140_lights_block, dir_lights) == 16);
+static_assert(offsetof(std140_lights_block, point_lights) == 16 + 64 * MAX_DIR_LIGHTS);
+static_assert(offsetof(std140_lights_block, spotlights) == 16 + 64 * MAX_DIR_LIGHTS + 48 * MAX_POINT_LIGHTS);
+static_assert(sizeof(std140_lights_block) <= 16384, "GL_MAX_UNIFORM_BLOCK_SIZE is at least 16KB");
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/frustum.hpp>
+
+namespace ow {
+
+// Clusters of a view frustum: x * y screen tiles, cut in z depth slices growing
+// exponentially from the near plane to the far plane, so that clusters stay about as deep as
+// they are wide. Cluster (i, j, k) is number i + x * (j + y * k), tile (0, 0) is the bottom
+// left one.
+struct cluster_grid {
+	std::uint32_t x = 16;
+	std::uint32_t y = 9;
+	std::uint32_t z = 24;
+
+	std::size_t size() const noexcept {
+		return std::size_t{x} * y * z;
+	}
+};
+
+// lights of a cluster: indices [offset, offset + count) of light_clusters::indices().
+struct cluster_range {
+	std::uint32_t offset;
+	std::uint32_t count;
+};
+
+struct cluster_stats {
+	std::size_t lights;          // lights between the near and far planes
+	std::size_t indices;         // length of the lights lists, dropped ones excluded
+	std::size_t dropped;         // indices which didn't fit in the limit
+	std::size_t max_per_cluster;
+};
+
+// Assigns lights to the clusters their bounding sphere intersects. Pure CPU: the lists are
+// built without OpenGL, see clustered_lights for the upload.
+class light_clusters {
+public:
+	static constexpr std::size_t MAX_LIGHTS = std::size_t{std::numeric_limits<std::uint16_t>::max()} + 1;
+
+	explicit light_clusters(cluster_grid grid = {});
+
+	// proj must be a perspective projection, like glm::perspective: the planes and the
+	// fields of view are read from it. The cluster bounds are only rebuilt when it changes.
+	void set_projection(const glm::mat4& proj);
+
+	// fills the clusters with the view space spheres of at most MAX_LIGHTS lights, slices
+	// are processed in parallel on the global thread pool. Once max_indices is reached, the
+	// next clusters get truncated lists (and the last ones nothing).
+	cluster_stats assign(const sphere_batch& lights, culling_kernel kernel = culling_kernel::automatic,
+						 std::size_t max_indices = std::numeric_limits<std::size_t>::max());
+
+	// slice of a view space depth (-z), clamped to the grid. The shader does the same with
+	// depth_scale() and depth_bias().
+	std::uint32_t slice(float depth) const;
+
+	// slice = log(depth) * depth_scale + depth_bias
+	float depth_scale() const noexcept {
+		return m_depth_scale;
+	}
+
+	float depth_bias() const noexcept {
+		return m_depth_bias;
+	}
+
+	const cluster_grid& grid() const noexcept {
+		return m_grid;
+	}
+
+	const std::vector<cluster_range>& ranges() const noexcept {
+		return m_ranges;
+	}
+
+	const std::vector<std::uint16_t>& indices() const noexcept {
+		return m_indices;
+	}
+
+	const cluster_stats& stats() const noexcept {
+		return m_stats;
+	}
+
+	// lights of cluster (i, j, k), for tests and debugging.
+	std::vector<std::uint16_t> lights_of(std::uint32_t i, std::uint32_t j, std::uint32_t k) const;
+
+private:
+	// candidates of a slice, padded to a multiple of 8 with spheres hitting nothing.
+	struct slice_lights {
+		std::vector<float> x{}, y{}, dz2{}, r2{};
+		std::vector<std::uint16_t> light{};
+		std::vector<std::vector<std::uint16_t>> clusters{}; // x * y lists
+	};
+
+	void _assign_slice(std::uint32_t k, culling_kernel kernel);
+
+private:
+	cluster_grid m_grid;
+	glm::mat4 m_proj;
+	float m_near;
+	float m_far;
+	float m_depth_scale;
+	float m_depth_bias;
+
+	// view space bounds: columns and rows as x = ndc * tan, depths of the z + 1 slice planes.
+	std::vector<float> m_tile_x; // x + 1 values of x / depth
+	std::vector<float> m_tile_y; // y + 1 values of y / depth
+	std::vector<float> m_slice_depth;
+
+	std::vector<slice_lights> m_slices;
+	std::vector<cluster_range> m_ranges;
+	std::vector<std::uint16_t> m_indices;
+	cluster_stats m_stats;
+};
+
+}
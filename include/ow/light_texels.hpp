@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/frustum.hpp>
+#include <ow/lights_set.hpp>
+
+namespace ow {
+
+// Point lights and spotlights as RGBA32F texels, the layout the clustered and deferred
+// shaders read from texture buffers. Everything is in view space.
+//   0: position, attenuation_constant
+//   1: diffuse, attenuation_linear
+//   2: specular, attenuation_quadratic
+//   3: direction, cutoff
+//   4: outer_cutoff, unused
+//   5: bounding sphere center, radius
+// Point lights get cutoffs which make the spot factor 1.
+constexpr std::size_t LIGHT_TEXELS = 6;
+
+// packs at most max_lights lights, point lights first, and returns how many were.
+// bounds receives the bounding spheres too, in the layout of the culling kernels.
+std::size_t pack_light_texels(const lights_set& lights, const glm::mat4& view, std::size_t max_lights,
+							  std::vector<glm::vec4>* texels, sphere_batch* bounds);
+
+}
@@ -1,54 +1,48 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
-#include <sstream>
 
+#include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include <ow/shader_program.hpp>
 #include <ow/directional_light.hpp>
+#include <ow/light_block.hpp>
 #include <ow/point_light.hpp>
+#include <ow/shader_preprocessor.hpp>
 #include <ow/spotlight.hpp>
 
 namespace ow {
 
+// what the last lights_set::upload did.
+struct lights_upload_stats {
+	std::size_t dirty_lights;   // lights packed again: changed since the last upload, or all when the view changed
+	std::size_t uploaded_bytes; // 0 when nothing changed
+};
+
+// Lights of a scene, shared by every program declaring the `Lights` uniform block
+// (see light_block.hpp): programs don't get per light uniforms.
 class lights_set {
 public:
-	lights_set() : m_dir_lights(), m_point_lights(), m_spotlights() {}
-
-	void update_all(const shader_program& prog, glm::mat4 view) const {
-		prog.set("nbr_dir_lights", static_cast<int>(m_dir_lights.size()));
-		for (auto i = m_dir_lights.size(); i--;) {
-			m_dir_lights[i]->update_all(prog, view, "dir_lights[" + std::to_string(i) + "].");
-		}
-
-		prog.set("nbr_point_lights", static_cast<int>(m_point_lights.size()));
-		for (auto i = m_point_lights.size(); i--;) {
-			m_point_lights[i]->update_all(prog, view, "point_lights[" + std::to_string(i) + "].");
-		}
-
-		prog.set("nbr_spotlights", static_cast<int>(m_spotlights.size()));
-		for (auto i = m_spotlights.size(); i--;) {
-			m_spotlights[i]->update_all(prog, view, "spotlights[" + std::to_string(i) + "].");
-		}
-	}
-
-	void update_position_and_direction(const shader_program& prog, glm::mat4 view) {
-		prog.set("nbr_dir_lights", static_cast<int>(m_dir_lights.size()));
-		for (auto i = m_dir_lights.size(); i--;) {
-			m_dir_lights[i]->update_direction(prog, view, "dir_lights[" + std::to_string(i) + "].");
-		}
-
-		prog.set("nbr_point_lights", static_cast<int>(m_point_lights.size()));
-		for (auto i = m_point_lights.size(); i--;) {
-			m_point_lights[i]->update_position(prog, view, "point_lights[" + std::to_string(i) + "].");
-		}
-
-		prog.set("nbr_spotlights", static_cast<int>(m_spotlights.size()));
-		for (auto i = m_spotlights.size(); i--;) {
-			m_spotlights[i]->update_position_and_direction(prog, view, "spotlights[" + std::to_string(i) + "].");
-		}
+	lights_set()
+			: m_buffer{0}, m_block(), m_view(), m_dir_lights(), m_point_lights(), m_spotlights()
+			, m_dir_versions(), m_point_versions(), m_spot_versions(), m_stats{} {}
+	lights_set(const lights_set& other) = delete;
+	lights_set(lights_set&& other) noexcept;
+	~lights_set();
+	lights_set& operator=(const lights_set& other) = delete;
+
+	// packs the lights in view space, uploads them with a single buffer update and binds the
+	// buffer to LIGHTS_BLOCK_BINDING. Only the lights whose version changed are packed,
+	// unless the view changed, and nothing is uploaded when no light changed.
+	// Lights past the MAX_* limits are ignored.
+	void upload(const glm::mat4& view);
+
+	const lights_upload_stats& stats() const noexcept {
+		return m_stats;
 	}
 
 	void add_directional_light(std::shared_ptr<directional_light> dir_light_ptr) {
@@ -63,11 +57,33 @@ public:
 		m_spotlights.push_back(std::move(spotlight_ptr));
 	}
 
+	// DIR_LIGHTS, POINT_LIGHTS and SPOTLIGHTS: the defines of a program specialised for the
+	// current light counts, within the MAX_* limits. It must be built again when they change.
+	shader_defines count_defines() const;
+
+	const std::vector<std::shared_ptr<point_light>>& get_point_lights() const noexcept {
+		return m_point_lights;
+	}
+
+	const std::vector<std::shared_ptr<spotlight>>& get_spotlights() const noexcept {
+		return m_spotlights;
+	}
+
 private:
+	GLuint m_buffer; // created by the first upload
+	std::unique_ptr<std140_lights_block> m_block; // CPU side copy, ~12KB
+	std::optional<glm::mat4> m_view; // of the last upload
+
 	std::vector<std::shared_ptr<directional_light>> m_dir_lights;
 	std::vector<std::shared_ptr<point_light>> m_point_lights;
 	std::vector<std::shared_ptr<spotlight>> m_spotlights;
+
+	// versions of the lights in the GPU buffer, 0 for none.
+	std::vector<std::uint64_t> m_dir_versions;
+	std::vector<std::uint64_t> m_point_versions;
+	std::vector<std::uint64_t> m_spot_versions;
+
+	lights_upload_stats m_stats;
 };
 
 }
-
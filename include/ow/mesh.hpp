@@ -5,6 +5,11 @@
 
 #include <glm/glm.hpp>
 
+#include <ow/bounds.hpp>
+#include <ow/bvh.hpp>
+#include <ow/index_type.hpp>
+#include <ow/instance_buffer.hpp>
+#include <ow/mesh_simplifier.hpp>
 #include <ow/shader_program.hpp>
 #include <ow/texture.hpp>
 #include <ow/vertex.hpp>
@@ -12,16 +17,30 @@
 
 namespace ow {
 
+// binds textures[current_pass] (if any) on the next texture unit and sets the matching
+// `has_<type>_map` and `<type>_map` uniforms of prog.
+void activate_next_texture_unit(const shader_program& prog, int* next_unit_to_activate, unsigned int current_pass,
+								const std::vector<std::shared_ptr<texture>>& textures, texture_type tex_type);
+
+// layout of the vertices in the GPU buffer.
+enum class vertex_packing {
+	none,  // vertex, 32 bytes
+	packed // packed_vertex, 16 bytes: the program needs a `dequantization` uniform (see phong_vertex.glsl)
+};
+
+// the vertices and indices are uploaded as given: run optimize_mesh on them first to reorder
+// them for the GPU caches.
 class mesh {
 public:
 	mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices,
 		 std::vector<std::shared_ptr<texture>> diffuse_maps,
 		 std::vector<std::shared_ptr<texture>> specular_maps,
-		 std::vector<std::shared_ptr<texture>> emission_maps
+		 std::vector<std::shared_ptr<texture>> emission_maps,
+		 vertex_packing packing = vertex_packing::none
 	);
 	mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices,
-		 std::vector<std::shared_ptr<texture>> textures);
-	mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices);
+		 std::vector<std::shared_ptr<texture>> textures, vertex_packing packing = vertex_packing::none);
+	mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices, vertex_packing packing = vertex_packing::none);
 	mesh(const mesh& other) = delete;
 	mesh(mesh&& other) noexcept(noexcept(std::vector<vertex>{std::move(std::vector<vertex>{})}));
 	~mesh();
@@ -29,12 +48,60 @@ public:
 
 	void draw(const shader_program& prog) const;
 
+	// draws the given level of detail (see generate_lods).
+	void draw(const shader_program& prog, std::size_t lod) const;
+
+	// draws one copy of the mesh per instance in a single draw call. The program reads the
+	// instances when its `instanced` uniform is set (see phong_vertex.glsl).
+	// The instances are uploaded in a buffer owned by the mesh.
+	void draw_instanced(const shader_program& prog, const std::vector<instance>& instances, std::size_t lod = 0) const;
+
+	// same with instances already uploaded, e.g. shared by several meshes.
+	void draw_instanced(const shader_program& prog, const instance_buffer& instances, std::size_t lod = 0) const;
+
+	// steps of draw() for callers which skip the redundant state changes (see render_queue):
+	// with prog in use, bind_textures(prog) and bind get_vertex_array(), then draw_elements().
+	// Packed meshes also need the `dequantization` uniform set to get_dequantization().
+	void bind_textures(const shader_program& prog) const;
+	void draw_elements(std::size_t lod = 0, const instance_buffer* instances = nullptr) const;
+	GLuint get_vertex_array() const { return m_VAO; }
+	const glm::mat4& get_dequantization() const { return m_dequantization; }
+
+	// builds simplified versions of the mesh, stored after the full resolution indices
+	// in the same index buffer. get_indices() still returns the full resolution ones.
+	void generate_lods(const lod_settings& settings = {});
+
+	std::size_t get_lod_count() const { return m_lods.size(); }
+
+	// deviation of a level from the full resolution mesh, in mesh units.
+	float get_lod_error(std::size_t lod) const { return m_lods[lod].error; }
+
+	// coarsest level whose error stays under max_pixel_error once projected on screen.
+	// distance is from the camera to the mesh, in mesh units (divide by the model scale).
+	std::size_t select_lod(float distance, float fov, float viewport_height, float max_pixel_error = 1.f) const;
+
 	std::vector<vertex>& get_vertices() { return m_vertices; }
 	const std::vector<vertex>& get_vertices() const { return m_vertices; }
 
 	std::vector<unsigned int>& get_indices() { return m_indices; }
 	const std::vector<unsigned int>& get_indices() const { return m_indices; }
 
+	// bounds of the vertices, in mesh space.
+	const aabb& get_aabb() const { return m_aabb; }
+	const bounding_sphere& get_bounding_sphere() const { return m_bounding_sphere; }
+
+	// triangle BVH in mesh space for ray casts, built on first call from get_vertices() and get_indices().
+	const triangle_bvh& build_bvh();
+
+	// nullptr until build_bvh() is called.
+	const triangle_bvh* get_bvh() const { return m_bvh.get(); }
+
+	// width of the indices in the GPU buffer, picked from the vertex count.
+	index_type get_index_type() const { return m_index_type; }
+
+	// layout of the vertices in the GPU buffer, get_vertices() always returns unpacked ones.
+	vertex_packing get_vertex_packing() const { return m_vertex_packing; }
+
 	std::vector<std::shared_ptr<texture>>& get_diffuse_maps() { return m_diffuse_maps; }
 	const std::vector<std::shared_ptr<texture>>& get_diffuse_maps() const { return m_diffuse_maps; }
 
@@ -46,17 +113,37 @@ public:
 
 	void add_texture(std::shared_ptr<texture> texture);
 
+	// HAS_DIFFUSE_MAP, HAS_SPECULAR_MAP and HAS_EMISSION_MAP for the maps of the mesh: the
+	// defines of a program specialised for its material (see shader_permutations).
+	shader_defines material_defines() const;
+
 private:
+	struct lod_range {
+		std::size_t first_index;
+		std::size_t index_count;
+		float error;
+	};
+
+	void _draw(const shader_program& prog, std::size_t lod, const instance_buffer* instances) const;
+	void _bind_textures(const shader_program& prog, unsigned int pass) const;
 	void _setup_mesh();
+	void _upload_indices(const std::vector<lod_level>& levels);
 
-	void _activate_next_texture_unit(const shader_program& prog, int* next_unit_to_activate,
-									 unsigned int current_pass, std::vector<std::shared_ptr<texture>> textures,
-									 ow::texture_type tex_type) const;
+	template <typename Vertex>
+	void _upload_vertices(const std::vector<Vertex>& vertices);
 
 private:
 	// render data
 	unsigned int m_VAO, m_EBO;
 	VBO<1> m_VBO;
+	index_type m_index_type;
+	vertex_packing m_vertex_packing;
+	glm::mat4 m_dequantization; // only used with packed vertices
+	std::vector<lod_range> m_lods; // level 0 is m_indices
+	aabb m_aabb;
+	bounding_sphere m_bounding_sphere;
+	std::unique_ptr<triangle_bvh> m_bvh;
+	mutable std::unique_ptr<instance_buffer> m_instances; // created by the first draw_instanced
 
 	// mesh data
 	std::vector<vertex> m_vertices;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <ow/bounds.hpp>
+#include <ow/instance_buffer.hpp>
+#include <ow/shader_program.hpp>
+#include <ow/texture.hpp>
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+// Packs several meshes in one vertex buffer and one index buffer sharing a single VAO.
+// Each mesh is a range of the index buffer drawn with glDrawElementsBaseVertex, so that
+// drawing all of them only binds the program and the VAO once.
+class mesh_arena {
+public:
+	using texture_maps = std::array<std::vector<std::shared_ptr<texture>>, 3>; // diffuse, specular, emission
+
+	mesh_arena();
+	mesh_arena(const mesh_arena& other) = delete;
+	mesh_arena(mesh_arena&& other) noexcept;
+	~mesh_arena();
+	mesh_arena& operator=(const mesh_arena& other) = delete;
+
+	// make room for at least this amount of vertices and indices.
+	void reserve(std::size_t vertex_capacity, std::size_t index_capacity);
+
+	// uploads the mesh right after the previous ones (buffers grow if needed).
+	void add_mesh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices, texture_maps maps);
+
+	// same from any memory, e.g. a mapped mesh_cache.
+	void add_mesh(const vertex* vertices, std::size_t vertex_count, const unsigned int* indices, std::size_t index_count,
+				  texture_maps maps);
+
+	// when visibility is given, mesh i is only drawn if (*visibility)[i] is set.
+	void draw(const shader_program& prog, const unsigned char* visibility = nullptr) const;
+
+	// same, one copy per instance (see mesh::draw_instanced).
+	void draw_instanced(const shader_program& prog, const instance_buffer& instances,
+						const unsigned char* visibility = nullptr) const;
+
+	std::size_t size() const noexcept {
+		return m_submeshes.size();
+	}
+
+	// bounds of mesh i, in mesh space.
+	const bounding_sphere& bounds(std::size_t i) const {
+		return m_submeshes[i].bounds;
+	}
+
+private:
+	struct submesh {
+		std::size_t first_index;
+		GLsizei index_count;
+		GLint base_vertex;
+		texture_maps maps;
+		bounding_sphere bounds;
+	};
+
+	void _draw(const shader_program& prog, const unsigned char* visibility, const instance_buffer* instances) const;
+	void _setup_attribs();
+
+private:
+	// render data
+	GLuint m_VAO, m_VBO, m_EBO;
+	std::size_t m_vertex_capacity, m_index_capacity;
+	std::size_t m_vertex_count, m_index_count;
+
+	std::vector<submesh> m_submeshes;
+};
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ow/texture.hpp>
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+// On-disk cache of an imported model: already converted vertices and indices
+// of every mesh, plus the texture file names of their materials.
+//
+// File layout (native endianness, every section aligned on 8 bytes):
+//   header | mesh records | vertices | indices | string offsets | string chars
+constexpr std::uint32_t MESH_CACHE_VERSION = 1;
+constexpr std::size_t MESH_CACHE_TEXTURE_TYPES = 3; // diffuse, specular, emission
+
+struct mesh_cache_header {
+	std::array<char, 4> magic;
+	std::uint32_t version;
+	std::uint32_t endianness;
+	std::uint32_t vertex_size;
+	std::uint64_t source_hash;
+	std::uint64_t mesh_count;
+	std::uint64_t vertex_count;
+	std::uint64_t index_count;
+	std::uint64_t string_count;
+	std::uint64_t string_bytes;
+};
+
+struct mesh_cache_record {
+	std::uint64_t vertex_first;
+	std::uint64_t vertex_count;
+	std::uint64_t index_first;
+	std::uint64_t index_count;
+	std::array<std::uint32_t, MESH_CACHE_TEXTURE_TYPES> texture_first;
+	std::array<std::uint32_t, MESH_CACHE_TEXTURE_TYPES> texture_count;
+};
+
+// Accumulates meshes during an import and serializes them.
+class mesh_cache_writer {
+public:
+	mesh_cache_writer() : m_records(), m_vertices(), m_indices(), m_strings() {}
+
+	void add_mesh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+				  const std::array<std::vector<std::string>, MESH_CACHE_TEXTURE_TYPES>& texture_names);
+
+	bool write(const std::string& cache_filename, std::uint64_t source_hash) const;
+
+private:
+	std::vector<mesh_cache_record> m_records;
+	std::vector<vertex> m_vertices;
+	std::vector<unsigned int> m_indices;
+	std::vector<std::string> m_strings;
+};
+
+// Read-only view over a cache file. The file is memory mapped when the platform
+// allows it, so vertices and indices can be handed to OpenGL without any conversion.
+class mesh_cache {
+public:
+	// cache_filename is rejected (operator bool returns false) if it is missing, was written
+	// by another version of the format or does not match the given source hash.
+	mesh_cache(const std::string& cache_filename, std::uint64_t expected_source_hash);
+	mesh_cache(const mesh_cache& other) = delete;
+	mesh_cache(mesh_cache&& other) noexcept;
+	~mesh_cache();
+	mesh_cache& operator=(const mesh_cache& other) = delete;
+
+	explicit operator bool() const { return m_header != nullptr; }
+
+	std::size_t mesh_count() const;
+
+	const vertex* vertices(std::size_t mesh_idx) const;
+	std::size_t vertex_count(std::size_t mesh_idx) const;
+
+	const unsigned int* indices(std::size_t mesh_idx) const;
+	std::size_t index_count(std::size_t mesh_idx) const;
+
+	std::vector<std::string> texture_names(std::size_t mesh_idx, texture_type type) const;
+
+	// cache file used for a given model file.
+	static std::string cache_filename_for(const std::string& model_filename);
+
+private:
+	bool _validate(std::uint64_t expected_source_hash);
+	void _release();
+
+	const mesh_cache_record& _record(std::size_t mesh_idx) const;
+
+private:
+	const char* m_data;
+	std::size_t m_size;
+	bool m_mapped;
+	std::vector<char> m_buffer; // used when memory mapping is not available
+
+	const mesh_cache_header* m_header;
+	const mesh_cache_record* m_records;
+	const vertex* m_vertices;
+	const unsigned int* m_indices;
+	const std::uint64_t* m_string_offsets;
+	const char* m_string_chars;
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+// Vertex welding and index reordering passes, run on the CPU before a mesh is uploaded.
+// None of them needs an OpenGL context.
+
+constexpr std::size_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+constexpr float DEFAULT_WELD_TOLERANCE = 1e-5f;
+
+struct vertex_cache_stats {
+	std::size_t transformed_vertices; // post-transform cache misses
+	float acmr; // average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst)
+	float atvr; // average transformed vertex ratio: transformed vertices per vertex (1 is ideal)
+};
+
+struct mesh_optimization_report {
+	vertex_cache_stats before;
+	vertex_cache_stats after;
+};
+
+// merges vertices whose position, normal and texture coordinates all match within tolerance,
+// and rewrites the indices. Vertices are bucketed in grid cells a few tolerances wide, those
+// close to a cell border are also compared with the neighbouring cells. A vertex is merged
+// into the first earlier one it matches, the kept vertices stay in the original order.
+// Big meshes are processed on the global thread pool. Returns the new vertex count.
+std::size_t weld_vertices(std::vector<vertex>* vertices, std::vector<unsigned int>* indices,
+						  float tolerance = DEFAULT_WELD_TOLERANCE);
+
+// simulates a FIFO post-transform vertex cache of the given size on a triangle list.
+vertex_cache_stats simulate_vertex_cache(const std::vector<unsigned int>& indices, std::size_t vertex_count,
+										 std::size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+// reorders triangles to maximize post-transform cache hits (Forsyth's linear-speed algorithm).
+void optimize_vertex_cache(std::vector<unsigned int>* indices, std::size_t vertex_count);
+
+// reorders clusters of triangles so that outward facing ones come first, reducing overdraw
+// (Sander et al., "Fast triangle reordering for vertex locality and reduced overdraw").
+// Expects cache optimized indices: clusters are only split where the ACMR of the result
+// stays within `threshold` times the ACMR of the input.
+void optimize_overdraw(std::vector<unsigned int>* indices, const std::vector<vertex>& vertices, float threshold = 1.05f,
+					   std::size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+// reorders vertices by first use so that vertex fetches are sequential, and drops unreferenced
+// vertices. Indices are remapped accordingly. Returns the new vertex count.
+std::size_t optimize_vertex_fetch(std::vector<vertex>* vertices, std::vector<unsigned int>* indices);
+
+// runs the three passes above.
+mesh_optimization_report optimize_mesh(std::vector<vertex>* vertices, std::vector<unsigned int>* indices,
+									   float overdraw_threshold = 1.05f);
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <ow/vertex.hpp>
+
+namespace ow {
+
+// Quadric error mesh simplification (Garland and Heckbert), collapsing vertices onto one of
+// their neighbours: simplified indices still reference the original vertex buffer.
+// Vertices sharing a position (normal or uv seams) move together so that the surface doesn't
+// crack, and open borders are kept in place. CPU only, no OpenGL context needed.
+
+struct simplify_result {
+	std::vector<unsigned int> indices;
+	float error; // estimated deviation from the input surface, in mesh units
+};
+
+// collapses vertices by increasing error until at most target_index_count indices are left,
+// or until the next collapse would move the surface by more than max_error.
+simplify_result simplify(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+						 std::size_t target_index_count, float max_error);
+
+struct lod_settings {
+	std::size_t max_levels = 4; // including the full resolution one
+	float reduction = 0.5f;     // index count of a level relative to the previous one
+	float max_error = 0.02f;    // deviation of the coarsest level, relative to the bounding box diagonal
+};
+
+struct lod_level {
+	std::vector<unsigned int> indices;
+	float error; // deviation from level 0, in mesh units
+};
+
+// level 0 is the input, each other level is simplified from the previous one and reordered
+// for the vertex cache. Stops early when a level doesn't remove enough triangles.
+std::vector<lod_level> build_lod_chain(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+									   const lod_settings& settings = {});
+
+// size on screen, in pixels, of an error at the given distance from a perspective camera.
+float projected_error(float error, float distance, float fov, float viewport_height);
+
+}
@@ -1,29 +1,123 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <string>
 
+#include <glad/glad.h>
 #include <assimp/scene.h>
+#include <ow/frustum.hpp>
 #include <ow/shader_program.hpp>
 #include <ow/mesh.hpp>
+#include <ow/mesh_arena.hpp>
+#include <ow/mesh_cache.hpp>
 #include <ow/texture.hpp>
 
 namespace ow {
 
+enum class model_load_mode {
+	blocking,  // everything is imported and uploaded by the constructor
+	streaming  // the constructor returns at once, see model::stream()
+};
+
+struct model_options {
+	model_load_mode mode = model_load_mode::blocking;
+
+	// the converted meshes are stored next to the model file (see mesh_cache)
+	// and reloaded from there as long as the model file is unchanged.
+	bool use_cache = true;
+
+	// all the meshes share the same buffers and VAO (see mesh_arena).
+	bool packed = false;
+
+	// merge identical vertices when importing (see weld_vertices).
+	bool weld = true;
+
+	// reorder indices and vertices for the GPU caches when importing (see optimize_mesh).
+	// The result is what gets cached and what both plain meshes and the arena upload.
+	bool optimize = false;
+};
+
 class model {
 public:
-	explicit model(const std::string& path);
+	explicit model(const std::string& path, model_options options = {});
+	model(const model& other) = delete;
+	model(model&& other) noexcept;
+	~model();
+	model& operator=(const model& other) = delete;
+
+	// draws the meshes uploaded so far.
 	void draw(const shader_program& prog) const;
 
+	// same, skipping the meshes outside of view_frustum once placed with model_matrix.
+	// The visible and culled mesh counts are added to *stats.
+	void draw(const shader_program& prog, const frustum& view_frustum, const glm::mat4& model_matrix,
+			  culling_stats* stats = nullptr) const;
+
+	// draws one copy of the meshes uploaded so far per instance (see mesh::draw_instanced).
+	void draw_instanced(const shader_program& prog, const std::vector<instance>& instances) const;
+
+	// streaming mode: upload meshes and textures prepared by the worker threads until
+	// budget is spent, checked after each upload (at least one is done if one is ready).
+	// Must be called from the OpenGL context thread, typically once per frame.
+	// Returns true once the model is completely loaded.
+	bool stream(std::chrono::microseconds budget);
+
+	bool loaded() const {
+		return m_streaming == nullptr;
+	}
+
 private:
+	using texture_names = std::array<std::vector<std::string>, MESH_CACHE_TEXTURE_TYPES>;
+
+	// mesh imported in CPU memory, not uploaded yet. The meshes of a cache have no vertices
+	// and indices: they are uploaded straight from the mapped file.
+	struct mesh_data {
+		std::vector<vertex> vertices{};
+		std::vector<unsigned int> indices{};
+		texture_names textures{};
+		std::shared_ptr<const mesh_cache> cache{};
+		std::size_t cache_mesh = 0;
+
+		std::size_t vertex_count() const {
+			return cache ? cache->vertex_count(cache_mesh) : vertices.size();
+		}
+
+		std::size_t index_count() const {
+			return cache ? cache->index_count(cache_mesh) : indices.size();
+		}
+	};
+
+	// shared with the worker threads when streaming.
+	struct streaming_state;
+
 	std::vector<mesh> m_meshes;
+	std::unique_ptr<mesh_arena> m_arena; // used instead of m_meshes when packed
 	std::string m_directory;
+	std::shared_ptr<streaming_state> m_streaming;
+	GLuint m_pixel_unpack_buffer;
+
+	// culling scratch, kept to avoid allocating every frame.
+	mutable sphere_batch m_world_bounds;
+	mutable std::vector<unsigned char> m_visibility;
+
+	mutable std::unique_ptr<instance_buffer> m_instances; // created by the first draw_instanced
 
-	void load_model(const std::string& path);
-	void process_node(aiNode* node, const aiScene* scene);
-	void process_mesh(aiMesh* mesh, const aiScene* scene);
-	std::vector<std::shared_ptr<texture>> load_material_textures(aiMaterial* mat, aiTextureType type, const texture_type& type_name);
+	void load_model(const std::string& path, const model_options& options);
+	void start_streaming(const std::string& path, const model_options& options);
+	void build_meshes(std::vector<mesh_data> meshes);
+	void add_mesh(mesh_data data, std::array<std::vector<std::shared_ptr<texture>>, MESH_CACHE_TEXTURE_TYPES> maps);
+
+	// import steps don't touch the model itself: they can run on any thread.
+	static std::vector<mesh_data> import_meshes(const std::string& path, const model_options& options);
+	static void weld_meshes(const std::string& path, std::vector<mesh_data>* meshes);
+	static void optimize_meshes(const std::string& path, std::vector<mesh_data>* meshes);
+	static void load_cache(const std::shared_ptr<const mesh_cache>& cache, std::vector<mesh_data>* meshes);
+	static void process_node(aiNode* node, const aiScene* scene, std::vector<mesh_data>* meshes);
+	static void process_mesh(aiMesh* mesh, const aiScene* scene, std::vector<mesh_data>* meshes);
+	static std::vector<std::string> material_texture_names(aiMaterial* mat, aiTextureType type);
 };
 
 }
-
@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 
 #include <ow/base_light.hpp>
+#include <ow/bounds.hpp>
+#include <ow/light_block.hpp>
 
 namespace ow {
 
@@ -23,25 +25,38 @@ public:
 		, m_attenuation_linear(attenuation_linear)
 		, m_attenuation_quadratic(attenuation_quadratic) {}
 
-	void update_all(const shader_program& prog, glm::mat4 view, const std::string& uniform_prefix = "point_light.") const override {
+	void update_all(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "point_light.") const override {
 		base_light::update_all(prog, view, uniform_prefix);
 
-		prog.set(uniform_prefix + "position", glm::vec3(view * glm::vec4(m_position, 1)));
+		prog.set(uniform_name(uniform_prefix, "position"), glm::vec3(view * glm::vec4(m_position, 1)));
 
-		prog.set(uniform_prefix + "attenuation_constant", m_attenuation_constant);
-		prog.set(uniform_prefix + "attenuation_linear", m_attenuation_linear);
-		prog.set(uniform_prefix + "attenuation_quadratic", m_attenuation_quadratic);
+		prog.set(uniform_name(uniform_prefix, "attenuation_constant"), m_attenuation_constant);
+		prog.set(uniform_name(uniform_prefix, "attenuation_linear"), m_attenuation_linear);
+		prog.set(uniform_name(uniform_prefix, "attenuation_quadratic"), m_attenuation_quadratic);
 	}
 
-	void update_position(const shader_program& prog, glm::mat4 view, std::string uniform_prefix = "point_light.") const {
-		prog.set(uniform_prefix + "position", glm::vec3(view * glm::vec4(m_position, 1)));
+	void update_position(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "point_light.") const {
+		prog.set(uniform_name(uniform_prefix, "position"), glm::vec3(view * glm::vec4(m_position, 1)));
+	}
+
+	// the light as laid out in the lights uniform block.
+	std140_point_light to_block(const glm::mat4& view) const {
+		return {glm::vec3(view * glm::vec4(m_position, 1)), m_attenuation_constant,
+				get_diffuse(), m_attenuation_linear,
+				get_specular(), m_attenuation_quadratic};
+	}
+
+	// world space sphere out of which the light is under cutoff.
+	bounding_sphere bounds(float cutoff = LIGHT_CUTOFF_INTENSITY) const {
+		return {m_position, attenuation_range(m_attenuation_constant, m_attenuation_linear, m_attenuation_quadratic,
+											  get_intensity(), cutoff)};
 	}
 
 	void set_pos(glm::vec3 pos) {
-		m_position = pos;
+		_set(&m_position, pos);
 	}
 
-	glm::vec3 get_pos() {
+	glm::vec3 get_pos() const {
 		return m_position;
 	}
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+// On-disk cache of linked programs, as returned by glGetProgramBinary. An entry is keyed by a
+// hash of the shader stages and sources, of the defines they are built with and of the
+// GL_VENDOR, GL_RENDERER and GL_VERSION strings: a binary only loads on the driver which
+// produced it. Drivers may still reject one (after an update keeping the same strings), the
+// program is then linked from its sources and the entry rewritten.
+//
+// File layout (native endianness): header | binary
+constexpr std::uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct program_cache_header {
+	std::array<char, 4> magic;
+	std::uint32_t version;
+	std::uint32_t endianness;
+	std::uint32_t binary_format;
+	std::uint64_t key;
+	std::uint64_t binary_size;
+};
+
+class program_binary_cache {
+public:
+	// entries are written in directory, which is created when needed.
+	explicit program_binary_cache(std::string directory);
+
+	// cache of the shader programs, in "cache/shaders/".
+	static program_binary_cache& global();
+
+	// the context supports program binaries (see load_gl_extensions) and the cache is not disabled.
+	bool enabled() const noexcept;
+
+	void set_enabled(bool enabled) noexcept {
+		m_enabled = enabled;
+	}
+
+	std::uint64_t key(const std::vector<std::pair<GLenum, std::string>>& sources, std::string_view defines = {}) const;
+
+	// links program from the entry of key. False if there is none or the driver rejected it.
+	bool load(GLuint program, std::uint64_t key) const;
+
+	// to call before linking a program which is then stored.
+	void prepare(GLuint program) const;
+
+	// program must be linked.
+	bool store(GLuint program, std::uint64_t key) const;
+
+	std::string filename_for(std::uint64_t key) const;
+
+private:
+	std::string m_directory;
+	bool m_enabled;
+};
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+
+#include <glad/glad.h>
+
+#include <ow/checkable.hpp>
+#include <ow/gl_extensions.hpp>
+#include <ow/shader_program.hpp>
+
+namespace ow {
+
+// Program pipeline object of GL_ARB_separate_shader_objects: the stages of separable programs
+// (see shader_program::set_separable) are combined at draw time instead of being linked
+// together, N vertex and M fragment variants cost N + M links instead of N * M. Each stage
+// remembers its program, and glUseProgramStages is only called for the stages which change.
+// The pipeline object is created on the first use_stages or bind.
+class program_pipeline : public checkable {
+public:
+	program_pipeline() noexcept : checkable{}, m_pipeline_id{0}, m_stages{} {}
+
+	program_pipeline(const program_pipeline&) = delete;
+	program_pipeline& operator=(const program_pipeline&) = delete;
+
+	program_pipeline(program_pipeline&& other) noexcept;
+
+	~program_pipeline();
+
+	// program provides the stages (GL_VERTEX_SHADER_BIT...) of the pipeline. It must be
+	// separable and linked. Returns false if every stage already used it: no OpenGL call.
+	bool use_stages(GLbitfield stages, const shader_program& program);
+
+	// program id of a single stage, 0 if none was set.
+	GLuint stage(GLbitfield stage) const noexcept;
+
+	// the pipeline is only used while no program is: this also unbinds the current one.
+	void bind();
+
+	GLuint get_id() const noexcept {
+		return m_pipeline_id;
+	}
+
+private:
+	// generates the pipeline object if there is none yet.
+	void _create();
+
+	// tracked stages, other bits of use_stages are ignored.
+	static constexpr std::array<GLbitfield, 3> STAGE_BITS = {
+		GL_VERTEX_SHADER_BIT, GL_FRAGMENT_SHADER_BIT, GL_GEOMETRY_SHADER_BIT
+	};
+
+	GLuint m_pipeline_id;
+	std::array<GLuint, STAGE_BITS.size()> m_stages; // program id by stage
+};
+
+}
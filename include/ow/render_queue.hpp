@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ow/mesh.hpp>
+#include <ow/program_pipeline.hpp>
+#include <ow/shader_program.hpp>
+
+namespace ow {
+
+enum class render_pass : std::uint8_t {
+	opaque,     // drawn first, front to back
+	transparent // drawn last with alpha blending and without depth writes, back to front
+};
+
+// state changes of the last render_queue::execute. "avoided" counts the draws which
+// would have changed the state if they had been drawn one by one with mesh::draw.
+struct render_queue_stats {
+	std::size_t draws;
+	std::size_t program_changes;
+	std::size_t program_changes_avoided;
+	std::size_t stage_changes;          // glUseProgramStages of the separable draws
+	std::size_t stage_changes_avoided;  // stages kept while the other one changed
+	std::size_t material_changes;
+	std::size_t material_changes_avoided;
+	std::size_t vertex_array_changes;
+	std::size_t vertex_array_changes_avoided;
+};
+
+// Draws submitted during a frame, executed in an order which minimizes the state changes.
+// Each draw gets a 64 bits key, most significant bits first:
+//  - opaque:      pass (2) | program (10) | material (14) | vertex array (14) | depth (24)
+//  - transparent: pass (2) | inverted depth (24) | program (10) | material (14) | vertex array (14)
+// The program bits of separable draws are vertex (5) | fragment (5), and the keys are radix
+// sorted. Keys only decide the order: the state is compared for real before being skipped,
+// so truncated ids can't produce wrong draws.
+class render_queue {
+public:
+	render_queue() : m_items(), m_entries(), m_scratch(), m_pipeline(), m_stats{} {}
+
+	// the program must have `model` and `normal_matrix` uniforms (see phong_vertex.glsl),
+	// its other uniforms (view, proj, lights...) are set by the caller.
+	void submit(const mesh& m, const shader_program& prog, const glm::mat4& model, render_pass pass = render_pass::opaque,
+				std::size_t lod = 0);
+
+	// separable stages (see shader_program::set_separable), drawn through the queue's
+	// program_pipeline: between two draws only the stage which differs is changed. The vertex
+	// program gets `model` and `normal_matrix`, the fragment one the material. The same
+	// program for both is drawn like the overload above.
+	void submit(const mesh& m, const shader_program& vertex, const shader_program& fragment, const glm::mat4& model,
+				render_pass pass = render_pass::opaque, std::size_t lod = 0);
+
+	// sorts and draws everything submitted since the last call, then empties the queue.
+	// view gives the depth of the draws and their normal matrix.
+	void execute(const glm::mat4& view);
+
+	std::size_t size() const noexcept {
+		return m_items.size();
+	}
+
+	const render_queue_stats& stats() const noexcept {
+		return m_stats;
+	}
+
+	// depth is the distance to the camera along the view direction.
+	static std::uint64_t make_key(render_pass pass, GLuint program, std::uint32_t material, GLuint vertex_array,
+								  float depth) noexcept;
+
+private:
+	struct item {
+		const mesh* drawn_mesh;
+		const shader_program* vertex;
+		const shader_program* fragment; // same as vertex if the program is not separable
+		glm::mat4 model;
+		std::size_t lod;
+		render_pass pass;
+	};
+
+	struct sort_entry {
+		std::uint64_t key;
+		std::uint32_t item;
+	};
+
+	void _sort();
+
+	// 10 bits of the key: the vertex stage first, so that draws sharing it are consecutive.
+	static GLuint _program_key(const item& it) noexcept;
+
+private:
+	std::vector<item> m_items;
+	std::vector<sort_entry> m_entries;
+	std::vector<sort_entry> m_scratch; // radix sort double buffer, kept between frames
+	program_pipeline m_pipeline;
+	render_queue_stats m_stats;
+};
+
+}
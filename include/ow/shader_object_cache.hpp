@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+struct shader_object_stats {
+	std::size_t compiled; // shader objects created
+	std::size_t reused;   // acquisitions served by an existing one
+};
+
+// Compiled shader objects shared by the programs being linked: a stage used by several of them
+// (phong_vertex.glsl...) is compiled once. Entries are found by a hash of the stage and the
+// preprocessed source, then compared with both: colliding sources get their own shader.
+// Shaders outlive the programs which attach them, so that programs linked one after the other
+// by shader_program::put share them too: call trim() once the programs are loaded.
+class shader_object_cache {
+public:
+	shader_object_cache() : m_entries(), m_keys(), m_stats{} {}
+	shader_object_cache(const shader_object_cache& other) = delete;
+	shader_object_cache& operator=(const shader_object_cache& other) = delete;
+
+	static shader_object_cache& global();
+
+	// shader of source, sourced and compiled if it isn't cached yet. The compile status is
+	// left to the caller: with GL_KHR_parallel_shader_compile, it isn't known yet.
+	GLuint acquire(GLenum stage, const std::string& source);
+
+	// the program which acquired shader is linked, or gave up. The shader stays cached.
+	void release(GLuint shader);
+
+	// deletes the shaders no program holds.
+	void trim();
+
+	// cached shaders, held or not.
+	std::size_t size() const noexcept {
+		return m_entries.size();
+	}
+
+	const shader_object_stats& stats() const noexcept {
+		return m_stats;
+	}
+
+private:
+	struct entry {
+		GLenum stage = GL_NONE;
+		std::string source{};
+		GLuint shader = 0;
+		std::size_t users = 0; // programs holding the shader
+	};
+
+	std::unordered_multimap<std::uint64_t, entry> m_entries; // by stage and source hash
+	std::unordered_map<GLuint, std::uint64_t> m_keys;        // by shader
+	shader_object_stats m_stats;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <ow/shader_preprocessor.hpp>
+#include <ow/shader_program.hpp>
+
+namespace ow {
+
+// Variants of the same shader files, specialised with different defines (material features,
+// light counts, skybox reflection...) and linked the first time they are asked for. Programs
+// live as long as the permutations: the references returned by get() stay valid.
+// Separable permutations usually hold a single stage, combined with the others by a
+// program_pipeline: a variant links that stage only.
+class shader_permutations {
+public:
+	explicit shader_permutations(std::vector<std::pair<GLenum, std::string>> shaders, bool separable = false);
+	shader_permutations(const shader_permutations& other) = delete;
+	shader_permutations& operator=(const shader_permutations& other) = delete;
+
+	// starts linking a variant in the background (see shader_program::put_async), unless it
+	// already was. A variant which failed to compile or link is false, and isn't built again.
+	shader_program& submit(const shader_defines& defines);
+
+	// the variant, linked: waits for it if it was submitted.
+	const shader_program& get(const shader_defines& defines);
+
+	// linked variants.
+	std::size_t size() const noexcept {
+		return m_programs.size();
+	}
+
+private:
+	std::vector<std::pair<GLenum, std::string>> m_shaders;
+	bool m_separable;
+	// by defines text: sorted by name, equal defines give the same key and no two others do.
+	std::unordered_map<std::string, std::unique_ptr<shader_program>> m_programs;
+};
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ow {
+
+// #define directives injected in a shader, kept sorted by name: equal sets give equal sources,
+// and equal program keys.
+class shader_defines {
+public:
+	shader_defines() : m_defines() {}
+	shader_defines(std::initializer_list<std::pair<std::string_view, std::string_view>> defines);
+
+	// replaces the value of name if it is already defined.
+	shader_defines& set(std::string_view name, std::string_view value = "1");
+	shader_defines& set(std::string_view name, long value);
+
+	// the values of other win.
+	shader_defines& merge(const shader_defines& other);
+
+	bool empty() const noexcept {
+		return m_defines.empty();
+	}
+
+	// one "#define NAME VALUE" line per define.
+	std::string text() const;
+
+	// lines of the defines whose name appears in source.
+	std::string text_used_by(std::string_view source) const;
+
+private:
+	std::vector<std::pair<std::string, std::string>> m_defines;
+};
+
+// Turns a shader file of resources/shaders/ into the source given to the driver:
+//  - `#include "file"` lines are replaced by the file, searched next to the including one.
+//    A file is only included once per shader, as if it started with #pragma once.
+//  - the defines are inserted after the #version line, which must be the first one. Only the
+//    ones the shader refers to are: a stage which ignores them stays the same source in every
+//    variant, and its compiled shader is shared (see shader_object_cache).
+//  - #line directives keep the driver messages pointing at the right lines, their source
+//    string numbers are the ids of file_name(id).
+// Files are read once and kept: call clear() to reload them.
+class shader_preprocessor {
+public:
+	explicit shader_preprocessor(std::string root);
+
+	// preprocessor of the files of resources/shaders/.
+	static shader_preprocessor& global();
+
+	// false, with a message, if a file is missing or an #include is malformed.
+	bool process(std::string_view file_name, const shader_defines& defines, std::string* source);
+
+	// file of a source string number, empty if unknown.
+	std::string_view file_name(int id) const noexcept;
+
+	void clear() noexcept;
+
+private:
+	// defines_at receives the offset of the defines, nullptr for included files.
+	bool _expand(const std::string& file_name, std::size_t* defines_at, std::vector<std::string>* included,
+				 std::string* source);
+
+	// cached contents, nullptr if the file can't be read.
+	const std::string* _read(const std::string& file_name);
+
+	int _id_of(const std::string& file_name);
+
+private:
+	std::string m_root;
+	std::unordered_map<std::string, std::string> m_files;
+	std::vector<std::string> m_file_names; // by id
+};
+
+}
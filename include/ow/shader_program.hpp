@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,29 +13,132 @@
 #include <tuple>
 #include <vector>
 #include "checkable.hpp"
+#include "gl_extensions.hpp"
+#include "gl_state.hpp"
 #include "opengl_codes.hpp"
+#include "shader_preprocessor.hpp"
+#include "uniform_table.hpp"
 
 namespace ow {
 
+// location of a uniform, resolved once with shader_program::uniform and valid until the
+// program is linked again. Handles of uniforms absent from the program are false, setting
+// them does nothing.
+class uniform_handle {
+public:
+	constexpr uniform_handle() noexcept : m_location{-1} {}
+	constexpr explicit uniform_handle(GLint location) noexcept : m_location{location} {}
+
+	constexpr GLint location() const noexcept {
+		return m_location;
+	}
+
+	constexpr explicit operator bool() const noexcept {
+		return m_location >= 0;
+	}
+
+private:
+	GLint m_location;
+};
+
+// name of a uniform in a struct or an array ("lights[2].position"), built on the stack.
+class uniform_name {
+public:
+	static constexpr std::size_t MAX_LENGTH = 127;
+
+	uniform_name(std::string_view prefix, std::string_view field) noexcept : m_buffer(), m_size{0} {
+		_append(prefix);
+		_append(field);
+	}
+
+	// array[index]suffix
+	uniform_name(std::string_view array, std::size_t index, std::string_view suffix = {}) noexcept
+			: m_buffer(), m_size{0} {
+		_append(array);
+		_append("[");
+		char digits[20];
+		std::size_t count = 0;
+		do {
+			digits[count++] = static_cast<char>('0' + index % 10);
+			index /= 10;
+		} while (index != 0);
+		while (count--) {
+			_append({&digits[count], 1});
+		}
+		_append("]");
+		_append(suffix);
+	}
+
+	operator std::string_view() const noexcept {
+		return {m_buffer, m_size};
+	}
+
+private:
+	void _append(std::string_view str) noexcept {
+		assert(m_size + str.size() <= MAX_LENGTH);
+		std::size_t count = std::min(str.size(), MAX_LENGTH - m_size);
+		std::memcpy(m_buffer + m_size, str.data(), count);
+		m_size += count;
+	}
+
+	char m_buffer[MAX_LENGTH];
+	std::size_t m_size;
+};
+
 class shader_program : public checkable {
 public:
-	shader_program() noexcept : checkable{}, m_program_id{0} {}
+	shader_program() noexcept : checkable{}, m_program_id{0}, m_uniforms(), m_pending(), m_separable{false} {}
 
-	explicit shader_program(const std::vector<std::pair<GLenum, std::string_view>>& shaders) : shader_program() {
-		put(shaders);
+	explicit shader_program(const std::vector<std::pair<GLenum, std::string_view>>& shaders,
+							const shader_defines& defines = {}) : shader_program() {
+		put(shaders, defines);
 	}
 
 	shader_program(const shader_program&) = delete;
 
 	shader_program(shader_program&&) noexcept ;
 
-	~shader_program() {
-		if (get_id() != 0) {
-			glDeleteProgram(m_program_id);
-		}
+	~shader_program();
+
+	// compiles and links the shader files of resources/shaders/, preprocessed with the defines
+	// (see shader_preprocessor). Linked programs are kept in program_binary_cache::global(),
+	// and loaded from it the next time.
+	bool put(const std::vector<std::pair<GLenum, std::string_view>>& shaders, const shader_defines& defines = {});
+
+	// same as put, without waiting for the driver: submit every program first, then poll()
+	// them. With GL_KHR_parallel_shader_compile they are compiled and linked on the driver
+	// threads meanwhile. Like put, they share the stages compiled before (see
+	// shader_object_cache). False if a file couldn't be read, compile and link errors come later.
+	bool put_async(const std::vector<std::pair<GLenum, std::string_view>>& shaders,
+				   const shader_defines& defines = {});
+
+	// checks whether the driver is done with put_async, and finishes the program when it is.
+	// True once the program is linked or failed to. Without the extension, it waits.
+	bool poll();
+
+	// finishes the program submitted by put_async.
+	void wait();
+
+	bool pending() const noexcept {
+		return m_pending != nullptr;
+	}
+
+	// applies to the next put: the program is linked with GL_PROGRAM_SEPARABLE, usually from
+	// a single stage, and combined with others by a program_pipeline. Its uniforms are set with
+	// glProgramUniform, without using it. Needs gl_extensions::separate_shader_objects. Its
+	// shaders are compiled with SEPARABLE_PROGRAM defined.
+	void set_separable(bool separable) noexcept {
+		m_separable = separable;
+	}
+
+	bool separable() const noexcept {
+		return m_separable;
 	}
 
-	bool put(const std::vector<std::pair<GLenum, std::string_view>>& shaders);
+	// this program once it is linked, placeholder until then, or if it failed.
+	const shader_program& ready_or(const shader_program& placeholder) {
+		return poll() && *this ? *this : placeholder;
+	}
 
 	// get the OpenGL program id
 	GLuint get_id() const noexcept {
@@ -40,21 +148,41 @@ public:
 	// use the shader program
 	void use() const {
 		chk_state();
-		glUseProgram(get_id());
+		if (pending()) {
+			throw invalid_state("Shader " + std::to_string(get_id()) + " is still being linked, poll() it first.");
+		}
+		gl_state::current().use_program(get_id());
 		check_errors("Error while setting " + std::to_string(get_id()) + " as shader program.\n");
 	}
 
+	// binds the uniform block `name`, if the program declares it, to a binding point.
+	// The blocks of light_block.hpp are bound when the program is linked.
+	void bind_uniform_block(std::string_view name, GLuint binding) const;
+
+	// the active uniforms are introspected when the program is linked: no OpenGL call.
+	uniform_handle uniform(std::string_view name) const noexcept {
+		return uniform_handle{m_uniforms.find(name)};
+	}
+
+	// prefer handles in loops, names cost a hash table lookup.
 	template <typename T>
 	void set(std::string_view name, T value) const noexcept {
+		set(uniform(name), value);
+	}
+
+	template <typename T>
+	void set(uniform_handle handle, T value) const noexcept {
 		using namespace std;
 		using namespace glm;
 
-		auto loc = glGetUniformLocation(m_program_id, name.data());
-		if (!check_errors("error when getting uniform location '" + std::string(name) + "' ")) {
+		if (!handle) {
 			return;
 		}
+		auto loc = handle.location();
 
-		if constexpr (is_same_v<bool, T>) {
+		if (m_separable) {
+			_program_uniform(loc, value);
+		} else if constexpr (is_same_v<bool, T>) {
 			glUniform1i(loc, value ? GL_TRUE : GL_FALSE);
 		} else if constexpr (is_same_v<int, T>) {
 			glUniform1i(loc, value);
@@ -96,18 +224,77 @@ public:
 			static_assert(is_same_v<T,T*>, "Unknown type");
 		}
 
-		check_errors("error when setting uniform '" + std::string(name) + "'@" + std::to_string(loc) + " ");
+		check_errors("error when setting uniform @" + std::to_string(loc) + " ");
 	}
 
 private:
-	static bool load_shader(GLuint shader, std::string_view file_name);
+	// set() of separable programs, which don't have to be in use.
+	template <typename T>
+	void _program_uniform(GLint loc, T value) const noexcept {
+		using namespace std;
+		using namespace glm;
+
+		auto& gl = gl_extensions::current();
+		auto id = get_id();
+		if constexpr (is_same_v<bool, T>) {
+			gl.ProgramUniform1i(id, loc, value ? GL_TRUE : GL_FALSE);
+		} else if constexpr (is_same_v<int, T>) {
+			gl.ProgramUniform1i(id, loc, value);
+		} else if constexpr (is_same_v<float, T>) {
+			gl.ProgramUniform1f(id, loc, value);
+		} else if constexpr (is_same_v<unsigned int, T> || is_same_v<unsigned long, T>) {
+			gl.ProgramUniform1ui(id, loc, static_cast<unsigned int>(value));
+		} else if constexpr (is_same_v<tuple<float, float, float, float>, T>) {
+			gl.ProgramUniform4f(id, loc, get<0>(value), get<1>(value), get<2>(value), get<3>(value));
+		} else if constexpr (is_same_v<tuple<float, float, float>, T>) {
+			gl.ProgramUniform3f(id, loc, get<0>(value), get<1>(value), get<2>(value));
+		} else if constexpr (is_same_v<tuple<float, float>, T>) {
+			gl.ProgramUniform2f(id, loc, get<0>(value), get<1>(value));
+		} else if constexpr (is_same_v<vec4, T>) {
+			gl.ProgramUniform4fv(id, loc, 1, value_ptr(value));
+		} else if constexpr (is_same_v<vec3, T>) {
+			gl.ProgramUniform3fv(id, loc, 1, value_ptr(value));
+		} else if constexpr (is_same_v<vec2, T>) {
+			gl.ProgramUniform2fv(id, loc, 1, value_ptr(value));
+		} else if constexpr (is_same_v<mat4, T>) {
+			gl.ProgramUniformMatrix4fv(id, loc, 1, GL_FALSE, value_ptr(value));
+		} else if constexpr (is_same_v<mat3, T>) {
+			gl.ProgramUniformMatrix3fv(id, loc, 1, GL_FALSE, value_ptr(value));
+		} else if constexpr (is_same_v<mat2, T>) {
+			gl.ProgramUniformMatrix2fv(id, loc, 1, GL_FALSE, value_ptr(value));
+		} else {
+			static_assert(is_same_v<T,T*>, "Unknown type");
+		}
+	}
+
+	static bool load_shader(std::string_view file_name, const shader_defines& defines, std::string* source);
 
 	static bool checked_compile(GLuint shader, std::string_view shader_file);
 
-	static bool load_compile(GLuint shader, std::string_view shader_file);
+	static bool checked_link(GLuint program);
+
+	// checks the shaders and the link of put_async.
+	void _finish();
+
+	// introspects the program once it is linked, from its sources or from a cached binary.
+	bool _linked();
+
+	// fills m_uniforms with the active uniforms, array elements included.
+	void _introspect();
 
 private:
+	// shaders of put_async (see shader_object_cache), with their files, released once the
+	// link is checked.
+	struct pending_link {
+		std::vector<std::pair<GLuint, std::string>> shaders{};
+		std::uint64_t cache_key = 0;
+		bool cached = false;
+	};
+
 	GLuint m_program_id;
+	uniform_table m_uniforms;
+	std::unique_ptr<pending_link> m_pending;
+	bool m_separable;
 };
 
 }
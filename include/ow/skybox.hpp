@@ -15,6 +15,7 @@ struct skybox {
 	skybox& operator=(const skybox& other) = delete;
 
 	GLuint id;
+	std::size_t byte_size; // estimated video memory used by the six faces
 };
 
 
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cmath>
+
 #include <glm/glm.hpp>
 
 #include <ow/base_light.hpp>
+#include <ow/bounds.hpp>
+#include <ow/light_block.hpp>
 
 namespace ow {
 
@@ -31,31 +35,61 @@ public:
 		, m_attenuation_linear(attenuation_linear)
 		, m_attenuation_quadratic(attenuation_quadratic) {}
 
-	void update_all(const shader_program& prog, glm::mat4 view, const std::string& uniform_prefix = "spotlight.") const override {
+	void update_all(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "spotlight.") const override {
 		base_light::update_all(prog, view, uniform_prefix);
 
-		prog.set(uniform_prefix + "position", glm::vec3(view * glm::vec4(m_position, 1)));
-		prog.set(uniform_prefix + "direction", glm::vec3(view * glm::vec4(m_direction, 0)));
+		prog.set(uniform_name(uniform_prefix, "position"), glm::vec3(view * glm::vec4(m_position, 1)));
+		prog.set(uniform_name(uniform_prefix, "direction"), glm::vec3(view * glm::vec4(m_direction, 0)));
+
+		prog.set(uniform_name(uniform_prefix, "cutoff"), m_cutoff);
+		prog.set(uniform_name(uniform_prefix, "outer_cutoff"), m_outer_cutoff);
 
-		prog.set(uniform_prefix + "cutoff", m_cutoff);
-		prog.set(uniform_prefix + "outer_cutoff", m_outer_cutoff);
+		prog.set(uniform_name(uniform_prefix, "attenuation_constant"), m_attenuation_constant);
+		prog.set(uniform_name(uniform_prefix, "attenuation_linear"), m_attenuation_linear);
+		prog.set(uniform_name(uniform_prefix, "attenuation_quadratic"), m_attenuation_quadratic);
+	}
+
+	void update_position_and_direction(const shader_program& prog, glm::mat4 view, std::string_view uniform_prefix = "spotlight.") const {
+		prog.set(uniform_name(uniform_prefix, "position"), glm::vec3(view * glm::vec4(m_position, 1)));
+		prog.set(uniform_name(uniform_prefix, "direction"), glm::vec3(view * glm::vec4(m_direction, 0)));
+	}
 
-		prog.set(uniform_prefix + "attenuation_constant", m_attenuation_constant);
-		prog.set(uniform_prefix + "attenuation_linear", m_attenuation_linear);
-		prog.set(uniform_prefix + "attenuation_quadratic", m_attenuation_quadratic);
+	// the light as laid out in the lights uniform block.
+	std140_spotlight to_block(const glm::mat4& view) const {
+		return {glm::vec3(view * glm::vec4(m_position, 1)), m_cutoff,
+				glm::vec3(view * glm::vec4(m_direction, 0)), m_outer_cutoff,
+				get_diffuse(), m_attenuation_constant,
+				get_specular(), m_attenuation_linear,
+				m_attenuation_quadratic};
 	}
 
-	void update_position_and_direction(const shader_program& prog, glm::mat4 view, std::string uniform_prefix = "spotlight.") const {
-		prog.set(uniform_prefix + "position", glm::vec3(view * glm::vec4(m_position, 1)));
-		prog.set(uniform_prefix + "direction", glm::vec3(view * glm::vec4(m_direction, 0)));
+	// world space sphere around the cone out of which the light is under cutoff.
+	bounding_sphere bounds(float cutoff = LIGHT_CUTOFF_INTENSITY) const {
+		float range = attenuation_range(m_attenuation_constant, m_attenuation_linear, m_attenuation_quadratic,
+										get_intensity(), cutoff);
+		if (m_outer_cutoff <= 0.f) {
+			// half a space or more.
+			return {m_position, range};
+		}
+
+		// smallest sphere around the cone and its spherical cap: the one through the apex
+		// and the base circle for narrow cones, the one around the base circle otherwise.
+		glm::vec3 direction = glm::normalize(m_direction);
+		float cos_angle = m_outer_cutoff;
+		if (cos_angle < std::sqrt(0.5f)) {
+			float sin_angle = std::sqrt(1.f - cos_angle * cos_angle);
+			return {m_position + direction * (range * cos_angle), range * sin_angle};
+		}
+		float radius = range / (2.f * cos_angle);
+		return {m_position + direction * radius, radius};
 	}
 
 	void set_pos(glm::vec3 pos) {
-		m_position = pos;
+		_set(&m_position, pos);
 	}
 
 	void set_dir(glm::vec3 dir) {
-		m_direction = dir;
+		_set(&m_direction, dir);
 	}
 
 private:
@@ -5,6 +5,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <ow/image.hpp>
+
 namespace ow {
 
 enum class texture_type {
@@ -16,8 +18,11 @@ enum class texture_type {
 std::string texture_type_to_string(texture_type type);
 
 struct texture {
-	explicit texture(unsigned int id_, texture_type type_ = texture_type::emission) : id(id_), type(type_) {}
+	explicit texture(unsigned int id_, texture_type type_ = texture_type::emission) : id(id_), type(type_), byte_size(0) {}
 	explicit texture(const std::string& filename, texture_type type_ = texture_type::emission);
+	// upload an already decoded image (must be called from the OpenGL context thread).
+	// When pixel_unpack_buffer is not 0, pixels are staged through this buffer object.
+	explicit texture(const image& img, texture_type type_ = texture_type::emission, GLuint pixel_unpack_buffer = 0);
 	texture(const texture& other) = delete;
 	texture(texture&& other) noexcept;
 	~texture();
@@ -29,6 +34,7 @@ struct texture {
 
 	GLuint id;
 	texture_type type;
+	std::size_t byte_size; // estimated video memory used, mipmaps included
 };
 
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <ow/image.hpp>
+#include <ow/skybox.hpp>
+#include <ow/texture.hpp>
+
+namespace ow {
+
+struct texture_registry_stats {
+	std::size_t hits;
+	std::size_t misses;
+	std::size_t resident_textures;
+	std::size_t resident_bytes;
+};
+
+// Hands out shared texture handles so that an image file referenced several times
+// is decoded and uploaded only once. Entries are keyed by canonical path and texture type.
+//
+// The registry only keeps weak references: a texture is released as soon as the last
+// mesh using it is destroyed, and loaded again on the next request.
+//
+// Every method may be called from any thread. When a texture has to be created, it is
+// created on the calling thread, which must then own the OpenGL context.
+class texture_registry {
+public:
+	texture_registry() : m_mutex(), m_textures(), m_skyboxes(), m_hits(0), m_misses(0) {}
+	texture_registry(const texture_registry&) = delete;
+	texture_registry& operator=(const texture_registry&) = delete;
+
+	// registry shared by the whole library (used by ow::model).
+	static texture_registry& global();
+
+	std::shared_ptr<texture> get(const std::string& filename, texture_type type = texture_type::emission);
+
+	// same as above, but uploads the given image (decoded from filename) on a miss.
+	std::shared_ptr<texture> get(const std::string& filename, texture_type type, const image& decoded,
+								 GLuint pixel_unpack_buffer = 0);
+
+	std::shared_ptr<skybox> get_skybox(const std::string& dirname);
+
+	// returns the texture if it is already resident, without loading it.
+	std::shared_ptr<texture> find(const std::string& filename, texture_type type = texture_type::emission) const;
+
+	texture_registry_stats stats() const;
+
+	// forget about released textures.
+	void purge();
+
+	static std::string canonical_path(const std::string& filename);
+
+private:
+	using key_type = std::pair<std::string, texture_type>;
+
+	mutable std::mutex m_mutex;
+	std::map<key_type, std::weak_ptr<texture>> m_textures;
+	std::map<std::string, std::weak_ptr<skybox>> m_skyboxes;
+	std::size_t m_hits;
+	std::size_t m_misses;
+};
+
+}
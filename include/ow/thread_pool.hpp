@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ow {
+
+// Fixed size pool of worker threads running submitted tasks in FIFO order.
+// Tasks must not touch OpenGL: workers don't own any context.
+class thread_pool {
+public:
+	// 0 means one thread per hardware thread.
+	explicit thread_pool(std::size_t thread_count = 0);
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+	~thread_pool();
+
+	// pool shared by the whole library.
+	static thread_pool& global();
+
+	template <typename F>
+	std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& task) {
+		using result_type = std::invoke_result_t<std::decay_t<F>>;
+		auto packaged = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(task));
+		auto future = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_tasks.emplace([packaged] { (*packaged)(); });
+		}
+		m_condition.notify_one();
+		return future;
+	}
+
+	// calls body(i) for every i in [0, count) using the calling thread and the workers,
+	// and returns once all of them are done. Safe to call from a worker: the calling
+	// thread doesn't wait on tasks which have not started yet.
+	template <typename F>
+	void parallel_for(std::size_t count, F&& body) {
+		struct shared_state {
+			std::atomic<std::size_t> next{0};
+			std::size_t done = 0; // guarded by mutex
+			std::mutex mutex{};
+			std::condition_variable finished{};
+		};
+		auto state = std::make_shared<shared_state>();
+
+		// body outlives every call made through run: late tasks find nothing left to claim.
+		auto run = [state, count, &body] {
+			std::size_t processed = 0;
+			for (std::size_t i = state->next++; i < count; i = state->next++) {
+				body(i);
+				++processed;
+			}
+			if (processed > 0) {
+				std::lock_guard<std::mutex> lock{state->mutex};
+				state->done += processed;
+				if (state->done == count) {
+					state->finished.notify_all();
+				}
+			}
+		};
+
+		std::size_t helpers = std::min(size(), count > 0 ? count - 1 : 0);
+		for (std::size_t i = 0; i < helpers; ++i) {
+			submit(run);
+		}
+		run();
+
+		std::unique_lock<std::mutex> lock{state->mutex};
+		state->finished.wait(lock, [&state, count] { return state->done == count; });
+	}
+
+	std::size_t size() const noexcept {
+		return m_workers.size();
+	}
+
+private:
+	void _work();
+
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stopping;
+};
+
+}
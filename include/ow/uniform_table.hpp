@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+// Uniform locations of a program by name. Open addressing with linear probing: lookups
+// hash a string_view and compare in place, they never allocate.
+class uniform_table {
+public:
+	uniform_table() noexcept : m_slots(), m_size{0} {}
+
+	// replaces the location of an already known name.
+	void insert(std::string_view name, GLint location);
+
+	// -1 for unknown names, like glGetUniformLocation.
+	GLint find(std::string_view name) const noexcept;
+
+	void clear() noexcept;
+
+	std::size_t size() const noexcept {
+		return m_size;
+	}
+
+private:
+	struct slot {
+		std::string name;
+		std::size_t hash;
+		GLint location; // -1 for an empty slot
+	};
+
+	// index of the slot holding name, or of the empty slot ending its probe sequence.
+	std::size_t _probe(std::string_view name, std::size_t hash) const noexcept;
+
+	void _grow();
+
+private:
+	std::vector<slot> m_slots; // power of two size, at most half full
+	std::size_t m_size;
+};
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 #include <iostream>
 
@@ -7,4 +8,17 @@ namespace ow {
 #define logger logger_impl(__FILE__, __FUNCTION__, __LINE__)
 
 	std::ostream& logger_impl(std::string_view, std::string_view, unsigned long);
+
+	constexpr std::uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr std::uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+	// 64 bits FNV-1a hash, `seed` allows to chain several buffers.
+	std::uint64_t hash_bytes(const void* data, std::size_t size, std::uint64_t seed = FNV1A_OFFSET_BASIS) noexcept;
+
+	inline std::uint64_t hash_string(std::string_view str, std::uint64_t seed = FNV1A_OFFSET_BASIS) noexcept {
+		return hash_bytes(str.data(), str.size(), seed);
+	}
+
+	// hash the whole content of a file. Returns 0 if the file can't be read.
+	std::uint64_t hash_file(const std::string& filename);
 }
@@ -1,10 +1,20 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
 
+#include <ow/vertex_format.hpp>
+
 namespace ow {
 
 struct vertex {
+	// locations 0, 1 and 2: position, normal and texture coordinates.
+	using format = vertex_format<float_attribute<3>, float_attribute<3>, float_attribute<2>>;
+
 	vertex(glm::vec3 pos) : position(pos), normal(0), tex_coords(0) {}
 	vertex(glm::vec3 pos, glm::vec3 norm) : position(pos), normal(norm), tex_coords(0) {}
 	vertex(glm::vec3 pos, glm::vec3 norm, glm::vec2 texture_coords)
@@ -15,4 +25,32 @@ struct vertex {
 	glm::vec2 tex_coords;
 };
 
+static_assert(sizeof(vertex) == vertex::format::size);
+static_assert(offsetof(vertex, normal) == vertex::format::offsets[1]);
+static_assert(offsetof(vertex, tex_coords) == vertex::format::offsets[2]);
+
+// 16 bytes version of vertex, with the same locations. Positions are quantized on 16 bits
+// in the bounds of their mesh: the vertex shader maps them back with a dequantization matrix.
+struct packed_vertex {
+	using format = vertex_format<unorm16_attribute<4>, snorm_2_10_10_10_attribute, half_attribute<2>>;
+
+	std::array<std::uint16_t, 4> position; // w is padding, keeps the next attribute aligned
+	std::uint32_t normal;
+	std::array<std::uint16_t, 2> tex_coords;
+};
+
+static_assert(sizeof(packed_vertex) == packed_vertex::format::size);
+static_assert(offsetof(packed_vertex, normal) == packed_vertex::format::offsets[1]);
+static_assert(offsetof(packed_vertex, tex_coords) == packed_vertex::format::offsets[2]);
+
+// packs vertices and sets *dequantization to the matrix mapping the quantized positions
+// (in [0, 1]^3) back to the original space. The scale is the same on every axis, so
+// that the normal matrix of the model is still valid.
+std::vector<packed_vertex> pack_vertices(const std::vector<vertex>& vertices, glm::mat4* dequantization);
+
+// octahedral encoding of a unit vector on 2 snorm16 (for snorm16_attribute<2> normals,
+// the shader decodes them with the inverse mapping). A zero vector is encoded as +z.
+std::array<std::int16_t, 2> encode_octahedral(glm::vec3 normal);
+glm::vec3 decode_octahedral(std::array<std::int16_t, 2> encoded);
+
 }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <glad/glad.h>
+
+namespace ow {
+
+// `Count` components stored as `T` and fetched by OpenGL as `GLType`.
+// Normalized integers are read as floats in [0, 1] (unsigned) or [-1, 1] (signed).
+template <typename T, GLint Count, GLenum GLType, bool Normalized = false>
+struct vertex_attribute {
+	static_assert(Count >= 1 && Count <= 4, "a vertex attribute has 1 to 4 components");
+
+	// all the components share a single word.
+	static constexpr bool packed = GLType == GL_INT_2_10_10_10_REV || GLType == GL_UNSIGNED_INT_2_10_10_10_REV;
+	static_assert(!packed || (Count == 4 && sizeof(T) == 4), "2_10_10_10 attributes are 4 components in 32 bits");
+
+	using component_type = T;
+	static constexpr GLint count = Count;
+	static constexpr GLenum gl_type = GLType;
+	static constexpr bool normalized = Normalized;
+	static constexpr std::size_t size = packed ? sizeof(T) : sizeof(T) * Count;
+};
+
+template <GLint Count>
+using float_attribute = vertex_attribute<float, Count, GL_FLOAT>;
+
+template <GLint Count>
+using half_attribute = vertex_attribute<std::uint16_t, Count, GL_HALF_FLOAT>;
+
+template <GLint Count>
+using unorm16_attribute = vertex_attribute<std::uint16_t, Count, GL_UNSIGNED_SHORT, true>;
+
+template <GLint Count>
+using snorm16_attribute = vertex_attribute<std::int16_t, Count, GL_SHORT, true>;
+
+// xyz on 10 bits and w on 2 bits, signed normalized (see glm::packSnorm3x10_1x2).
+using snorm_2_10_10_10_attribute = vertex_attribute<std::uint32_t, 4, GL_INT_2_10_10_10_REV, true>;
+
+// Interleaved vertex layout: attribute i is bound to location first_location + i.
+// The layout is checked at compile time, vertex structs assert that they match it.
+template <typename... Attributes>
+struct vertex_format {
+	static constexpr std::size_t attribute_count = sizeof...(Attributes);
+	static_assert(attribute_count > 0, "a vertex has at least one attribute");
+
+	static constexpr std::array<std::size_t, attribute_count> offsets = [] {
+		std::array<std::size_t, attribute_count> result{};
+		std::size_t sizes[] = {Attributes::size...};
+		for (std::size_t i = 1; i < attribute_count; ++i) {
+			result[i] = result[i - 1] + sizes[i - 1];
+		}
+		return result;
+	}();
+
+	static constexpr std::size_t size = (Attributes::size + ...);
+
+	// unaligned attributes make some drivers fall back to a slow path.
+	static_assert(((Attributes::size % 4 == 0) && ...), "attributes must be a multiple of 4 bytes");
+
+	// describes the attributes of the buffer bound to GL_ARRAY_BUFFER in the bound VAO.
+	// With a divisor of 1, the attributes advance once per instance instead of once per vertex.
+	static void setup(GLuint first_location = 0, GLuint divisor = 0) {
+		_setup(first_location, divisor, std::index_sequence_for<Attributes...>{});
+	}
+
+	// disables the attributes in the bound VAO.
+	static void disable(GLuint first_location = 0) {
+		for (GLuint i = 0; i < attribute_count; ++i) {
+			glDisableVertexAttribArray(first_location + i);
+		}
+	}
+
+private:
+	template <std::size_t... Is>
+	static void _setup(GLuint first_location, GLuint divisor, std::index_sequence<Is...>) {
+		(_setup_attribute<Attributes>(first_location + static_cast<GLuint>(Is), offsets[Is], divisor), ...);
+	}
+
+	template <typename Attribute>
+	static void _setup_attribute(GLuint location, std::size_t offset, GLuint divisor) {
+		glVertexAttribPointer(location, Attribute::count, Attribute::gl_type,
+							  Attribute::normalized ? GL_TRUE : GL_FALSE,
+							  static_cast<GLsizei>(size), reinterpret_cast<void*>(offset));
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, divisor);
+	}
+};
+
+}
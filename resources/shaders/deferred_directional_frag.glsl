@@ -0,0 +1,32 @@
+#version 330 core
+
+// lighting pass of ow::deferred_renderer: the directional lights, on the whole screen.
+
+// === G-buffer ===
+
+#include "include/gbuffer.glsl"
+
+// === light stuff ===
+
+#include "include/lights.glsl"
+
+// === output ===
+
+out vec4 frag_color;
+
+// =============
+
+void main() {
+	Surface surface;
+	if (!readSurface(surface)) {
+		discard;
+	}
+	vec3 view_dir = normalize(-surface.position);
+
+	vec3 result = vec3(0.0);
+	for (int i = 0; i < DIR_LIGHT_COUNT; ++i) {
+		result += shadeDirLight(dir_lights[i], surface, view_dir);
+	}
+
+	frag_color = vec4(result, 1.0);
+}
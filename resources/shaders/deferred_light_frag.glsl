@@ -0,0 +1,32 @@
+#version 330 core
+
+// lighting pass of ow::deferred_renderer: a point light or spotlight, on the pixels of its
+// volume.
+
+flat in int light;
+
+// === G-buffer ===
+
+#include "include/gbuffer.glsl"
+
+// === light stuff ===
+
+#include "include/light_texels.glsl"
+
+uniform samplerBuffer lights;
+
+// === output ===
+
+out vec4 frag_color;
+
+// =============
+
+void main() {
+	Surface surface;
+	if (!readSurface(surface)) {
+		discard;
+	}
+	vec3 view_dir = normalize(-surface.position);
+
+	frag_color = vec4(shadeTexelLight(lights, light, surface, view_dir), 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+// geometry pass of ow::deferred_renderer: the material is stored, lighting comes later.
+
+// === input ===
+
+in vec3 vertex_normal;
+in vec3 vertex_pos;
+in vec2 vertex_tex_coord;
+
+// === material stuff ===
+
+#include "include/material.glsl"
+
+// === output ===
+
+layout (location = 0) out vec4 gbuffer_normal;   // view space
+layout (location = 1) out vec4 gbuffer_albedo;
+layout (location = 2) out vec4 gbuffer_specular; // alpha: shininess / 256
+
+// =============
+
+void main() {
+	Surface surface = readMaterial(vertex_pos, vertex_normal, vertex_tex_coord);
+	gbuffer_normal = vec4(surface.normal, 0.0);
+	gbuffer_albedo = vec4(surface.albedo, has_diffuse_map ? 1.0 : 0.0);
+	gbuffer_specular = vec4(surface.specular, surface.shininess / 256.0);
+}
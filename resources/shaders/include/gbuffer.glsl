@@ -0,0 +1,27 @@
+#include "phong.glsl"
+
+// G-buffer of ow::deferred_renderer, written by gbuffer_frag.glsl.
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_albedo;
+uniform sampler2D gbuffer_specular;
+uniform sampler2D gbuffer_depth;
+uniform vec2 gbuffer_size;
+uniform mat4 inv_proj;
+
+// false for the background.
+bool readSurface(out Surface surface) {
+	vec2 uv = gl_FragCoord.xy / gbuffer_size;
+	float depth = texture(gbuffer_depth, uv).r;
+	if (depth == 1.0) {
+		return false;
+	}
+
+	vec4 position = inv_proj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	vec4 specular = texture(gbuffer_specular, uv);
+	surface.position = position.xyz / position.w;
+	surface.normal = normalize(texture(gbuffer_normal, uv).xyz);
+	surface.albedo = texture(gbuffer_albedo, uv).rgb;
+	surface.specular = specular.rgb;
+	surface.shininess = specular.a * 256.0;
+	return true;
+}
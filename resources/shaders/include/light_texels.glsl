@@ -0,0 +1,18 @@
+#include "phong.glsl"
+
+// point lights and spotlights of a texture buffer, 6 texels per light laid out as described in
+// light_texels.hpp. Point lights have cutoffs which make the cone intensity 1.
+vec3 shadeTexelLight(samplerBuffer lights, int light, Surface surface, vec3 view_dir) {
+	int base = light * 6;
+	vec4 position = texelFetch(lights, base);
+	vec4 diffuse = texelFetch(lights, base + 1);
+	vec4 specular = texelFetch(lights, base + 2);
+	vec4 direction = texelFetch(lights, base + 3);
+	float outer_cutoff = texelFetch(lights, base + 4).x;
+
+	vec3 light_dir = normalize(position.xyz - surface.position);
+	float distance = length(position.xyz - surface.position);
+	return attenuation(distance, position.w, diffuse.w, specular.w)
+		* coneIntensity(light_dir, direction.xyz, direction.w, outer_cutoff)
+		* phong(surface, view_dir, light_dir, diffuse.rgb, specular.rgb);
+}
@@ -0,0 +1,91 @@
+#include "phong.glsl"
+
+// std140 block, mirrored by ow::std140_lights_block (see light_block.hpp):
+// the members order is the one of the C++ structures.
+#define MAX_DIR_LIGHTS 8
+#define MAX_POINT_LIGHTS 128
+#define MAX_SPOTLIGHTS 64
+
+struct DirectionalLight {
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+struct PointLight {
+	vec3 position;
+	float attenuation_constant;
+
+	vec3 diffuse;
+	float attenuation_linear;
+
+	vec3 specular;
+	float attenuation_quadratic;
+};
+
+struct Spotlight {
+	vec3 position;
+	float cutoff;
+
+	vec3 direction;
+	float outer_cutoff;
+
+	vec3 diffuse;
+	float attenuation_constant;
+
+	vec3 specular;
+	float attenuation_linear;
+
+	float attenuation_quadratic;
+};
+
+layout(std140) uniform Lights {
+	int nbr_dir_lights;
+	int nbr_point_lights;
+	int nbr_spotlights;
+	DirectionalLight dir_lights[MAX_DIR_LIGHTS];
+	PointLight point_lights[MAX_POINT_LIGHTS];
+	Spotlight spotlights[MAX_SPOTLIGHTS];
+};
+
+// light counts are read from the block, unless the program is specialised for them (see
+// ow::lights_set::count_defines): the loops then have constant bounds.
+#ifdef DIR_LIGHTS
+#define DIR_LIGHT_COUNT DIR_LIGHTS
+#else
+#define DIR_LIGHT_COUNT min(nbr_dir_lights, MAX_DIR_LIGHTS)
+#endif
+
+#ifdef POINT_LIGHTS
+#define POINT_LIGHT_COUNT POINT_LIGHTS
+#else
+#define POINT_LIGHT_COUNT min(nbr_point_lights, MAX_POINT_LIGHTS)
+#endif
+
+#ifdef SPOTLIGHTS
+#define SPOTLIGHT_COUNT SPOTLIGHTS
+#else
+#define SPOTLIGHT_COUNT min(nbr_spotlights, MAX_SPOTLIGHTS)
+#endif
+
+vec3 shadeDirLight(DirectionalLight light, Surface surface, vec3 view_dir) {
+	vec3 light_dir = normalize(-light.direction);
+	return light.ambient * surface.albedo + phong(surface, view_dir, light_dir, light.diffuse, light.specular);
+}
+
+vec3 shadePointLight(PointLight light, Surface surface, vec3 view_dir) {
+	vec3 light_dir = normalize(light.position - surface.position);
+	float distance = length(light.position - surface.position);
+	return attenuation(distance, light.attenuation_constant, light.attenuation_linear, light.attenuation_quadratic)
+		* phong(surface, view_dir, light_dir, light.diffuse, light.specular);
+}
+
+vec3 shadeSpotlight(Spotlight light, Surface surface, vec3 view_dir) {
+	vec3 light_dir = normalize(light.position - surface.position);
+	float distance = length(light.position - surface.position);
+	return attenuation(distance, light.attenuation_constant, light.attenuation_linear, light.attenuation_quadratic)
+		* coneIntensity(light_dir, light.direction, light.cutoff, light.outer_cutoff)
+		* phong(surface, view_dir, light_dir, light.diffuse, light.specular);
+}
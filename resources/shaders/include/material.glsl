@@ -0,0 +1,41 @@
+#include "phong.glsl"
+
+// the maps of a mesh are uniforms, unless the program is specialised for its material (see
+// ow::mesh::material_defines): HAS_DIFFUSE_MAP, HAS_SPECULAR_MAP and HAS_EMISSION_MAP are then
+// 0 or 1, and the compiler removes the branches of the missing maps.
+#ifdef HAS_DIFFUSE_MAP
+const bool has_diffuse_map = HAS_DIFFUSE_MAP != 0;
+#else
+uniform bool has_diffuse_map;
+#endif
+
+#ifdef HAS_SPECULAR_MAP
+const bool has_specular_map = HAS_SPECULAR_MAP != 0;
+#else
+uniform bool has_specular_map;
+#endif
+
+#ifdef HAS_EMISSION_MAP
+const bool has_emission_map = HAS_EMISSION_MAP != 0;
+#else
+uniform bool has_emission_map;
+#endif
+
+uniform sampler2D diffuse_map;
+uniform sampler2D specular_map;
+uniform sampler2D emission_map;
+uniform float materials_shininess;
+
+Surface readMaterial(vec3 position, vec3 normal, vec2 tex_coord) {
+	Surface surface;
+	surface.position = position;
+	surface.normal = normalize(normal);
+	surface.albedo = has_diffuse_map ? texture(diffuse_map, tex_coord).rgb : vec3(0.0);
+	surface.specular = has_specular_map ? texture(specular_map, tex_coord).rgb : vec3(0.0);
+	surface.shininess = materials_shininess;
+	return surface;
+}
+
+vec3 readEmission(vec2 tex_coord) {
+	return has_emission_map ? texture(emission_map, tex_coord).rgb : vec3(0.0);
+}
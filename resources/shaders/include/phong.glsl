@@ -0,0 +1,34 @@
+// Phong shading shared by the forward and deferred programs. Everything is in view
+// space: the viewer is at (0, 0, 0).
+
+struct Surface {
+	vec3 position;
+	vec3 normal;
+	vec3 albedo;   // black without diffuse map
+	vec3 specular; // black without specular map
+	float shininess;
+};
+
+// diffuse and specular terms of a light coming from light_dir.
+vec3 phong(Surface surface, vec3 view_dir, vec3 light_dir, vec3 diffuse, vec3 specular) {
+	// diffuse shading
+	float diff = max(dot(surface.normal, light_dir), 0.0);
+
+	// specular shading
+	vec3 reflect_dir = reflect(-light_dir, surface.normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), surface.shininess);
+
+	// combine
+	return diffuse * diff * surface.albedo + specular * spec * surface.specular;
+}
+
+float attenuation(float distance, float constant, float linear, float quadratic) {
+	return 1.0 / (constant + linear * distance + quadratic * distance * distance);
+}
+
+// 1 inside the cutoff, 0 past the outer cutoff.
+float coneIntensity(vec3 light_dir, vec3 direction, float cutoff, float outer_cutoff) {
+	float theta = dot(light_dir, normalize(-direction));
+	float epsilon = cutoff - outer_cutoff;
+	return clamp((theta - outer_cutoff) / epsilon, 0.0, 1.0);
+}
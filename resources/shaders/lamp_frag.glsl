@@ -1,9 +1,9 @@
 #version 330 core
 
-out vec4 frag_color;
+in vec3 lamp_color;
 
-uniform vec3 color;
+out vec4 frag_color;
 
 void main() {
-	frag_color = vec4(color, 1.0);
+	frag_color = vec4(lamp_color, 1.0);
 }
@@ -1,9 +1,20 @@
 #version 330 core
 
 layout (location = 0) in vec3 pos;
+// per instance, only read when instanced is set (see ow::instance).
+layout (location = 3) in mat4 instance_model;
+layout (location = 7) in vec4 instance_color;
 
+out vec3 lamp_color;
+
+// proj * view only for instanced draws, the model matrix comes from the instance.
 uniform mat4 MVP;
+uniform vec3 color;
+// maps quantized positions back to model space (see ow::packed_vertex).
+uniform mat4 dequantization = mat4(1.0);
+uniform bool instanced = false;
 
 void main() {
-	gl_Position = MVP * vec4(pos, 1.0);
+	gl_Position = MVP * (instanced ? instance_model : mat4(1.0)) * dequantization * vec4(pos, 1.0);
+	lamp_color = instanced ? instance_color.rgb : color;
 }
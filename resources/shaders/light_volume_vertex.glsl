@@ -0,0 +1,17 @@
+#version 330 core
+
+// sphere around the range of a light, one instance per light of ow::deferred_renderer.
+
+layout (location = 0) in vec3 pos;
+
+flat out int light;
+
+// 6 texels per light, laid out as described in light_texels.hpp.
+uniform samplerBuffer lights;
+uniform mat4 proj;
+
+void main() {
+	light = gl_InstanceID;
+	vec4 sphere = texelFetch(lights, gl_InstanceID * 6 + 5); // view space
+	gl_Position = proj * vec4(sphere.xyz + pos * sphere.w, 1.0);
+}
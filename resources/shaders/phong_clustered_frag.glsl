@@ -0,0 +1,74 @@
+#version 330 core
+
+// === input ===
+
+in vec3 vertex_normal;
+in vec3 vertex_pos;
+in vec2 vertex_tex_coord;
+
+// === material stuff ===
+
+#include "include/material.glsl"
+
+// === light stuff ===
+
+// Only the directional lights are read from the block, the others come from the clusters.
+#include "include/lights.glsl"
+#include "include/light_texels.glsl"
+
+// clusters filled by ow::clustered_lights: cluster (x, y, z) is number
+// x + clusters_x * (y + clusters_y * z), its lights are the indices
+// [range.x, range.x + range.y) of cluster_indices.
+uniform samplerBuffer cluster_lights;
+uniform usamplerBuffer cluster_ranges;
+uniform usamplerBuffer cluster_indices;
+uniform uint clusters_x;
+uniform uint clusters_y;
+uniform uint clusters_z;
+uniform vec2 cluster_tile_size;       // in pixels
+uniform vec2 cluster_viewport_origin;
+// depth slice = log(view space depth) * scale + bias
+uniform float cluster_depth_scale;
+uniform float cluster_depth_bias;
+
+// === output ===
+
+out vec4 frag_color;
+
+// =============
+
+uvec2 clusterRange() {
+	uvec2 tile = uvec2(max((gl_FragCoord.xy - cluster_viewport_origin) / cluster_tile_size, vec2(0.0)));
+	uint slice = uint(max(log(-vertex_pos.z) * cluster_depth_scale + cluster_depth_bias, 0.0));
+	tile = min(tile, uvec2(clusters_x, clusters_y) - 1u);
+	slice = min(slice, clusters_z - 1u);
+	return texelFetch(cluster_ranges, int(tile.x + clusters_x * (tile.y + clusters_y * slice))).xy;
+}
+
+void main() {
+	vec3 result = vec3(0.0);
+
+	if (has_diffuse_map || has_specular_map) {
+		// view position is always (0, 0, 0) since we're
+		// doing lighting in view space.
+		vec3 view_dir = normalize(-vertex_pos);
+		Surface surface = readMaterial(vertex_pos, vertex_normal, vertex_tex_coord);
+
+		// phase 1: directional light
+		for (int i = 0; i < DIR_LIGHT_COUNT; ++i) {
+			result += shadeDirLight(dir_lights[i], surface, view_dir);
+		}
+
+		// phase 2: point lights and spotlights of the cluster
+		uvec2 range = clusterRange();
+		for (uint i = range.x, end = range.x + range.y; i < end; ++i) {
+			int light = int(texelFetch(cluster_indices, int(i)).x);
+			result += shadeTexelLight(cluster_lights, light, surface, view_dir);
+		}
+	}
+
+	// phase 3: emission light
+	result += readEmission(vertex_tex_coord);
+
+	frag_color = vec4(result, 1.0);
+}
@@ -1,8 +1,20 @@
 #version 330 core
+#ifdef SEPARABLE_PROGRAM
+#extension GL_ARB_separate_shader_objects : enable
+#endif
 
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 tex_coord;
+// per instance, only read when instanced is set (see ow::instance).
+layout (location = 3) in mat4 instance_model;
+
+#ifdef SEPARABLE_PROGRAM
+// redeclared for separable programs (see ow::program_pipeline), which some drivers require.
+out gl_PerVertex {
+	vec4 gl_Position;
+};
+#endif
 
 out vec3 vertex_normal;
 out vec3 vertex_pos;
@@ -12,11 +24,17 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 uniform mat3 normal_matrix;
+// maps quantized positions back to model space (see ow::packed_vertex).
+uniform mat4 dequantization = mat4(1.0);
+// instanced draws take the model matrix from the instance instead of model and normal_matrix.
+uniform bool instanced = false;
 
 void main() {
-	gl_Position = proj * view * model * vec4(pos, 1.0);
-	vertex_normal = normal_matrix * normal;
-	vertex_pos = vec3(view * model * vec4(pos, 1.0));
+	mat4 model_view = view * (instanced ? instance_model : model);
+	vec4 model_pos = dequantization * vec4(pos, 1.0);
+	gl_Position = proj * model_view * model_pos;
+	vertex_normal = (instanced ? transpose(inverse(mat3(model_view))) : normal_matrix) * normal;
+	vertex_pos = vec3(model_view * model_pos);
 	vertex_tex_coord = tex_coord;
 }
 
@@ -0,0 +1,10 @@
+#version 330 core
+
+// stands in for the programs which are still being linked (see shader_program::ready_or),
+// with phong_vertex.glsl: a flat grey.
+
+out vec4 frag_color;
+
+void main() {
+	frag_color = vec4(0.5, 0.5, 0.5, 1.0);
+}
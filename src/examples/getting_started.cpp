@@ -9,7 +9,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <ow/gl_extensions.hpp>
+#include <ow/gl_state.hpp>
 #include <ow/shader_program.hpp>
+#include <ow/shader_object_cache.hpp>
 #include <ow/camera_fps.hpp>
 #include <ow/vertex.hpp>
 #include <ow/texture.hpp>
@@ -61,10 +64,12 @@ int main() {
 		ow::logger << "Failed to initialize GLAD" << std::endl;
 		return EXIT_FAILURE;
 	}
+	// entry points above OpenGL 3.3, when the driver has them
+	ow::load_gl_extensions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	ow::gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
 	// call to draw in wireframe polygons.
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -79,6 +84,8 @@ int main() {
 			{{GL_VERTEX_SHADER,   "basic_vertex.glsl"}
 			,{GL_FRAGMENT_SHADER, "basic_frag.glsl"}
 	}};
+	// the shaders compiled for these programs are no longer needed.
+	ow::shader_object_cache::global().trim();
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
 	// ------------------------------------------------------------------
@@ -148,12 +155,13 @@ int main() {
 
 	// bind the Vertex Array Object first, then bind and set vertex buffer(s),
 	// and then configure vertex attributes(s).
-	glBindVertexArray(VAO);
+	auto& state = ow::gl_state::current();
+	state.bind_vertex_array(VAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	state.bind_buffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
 	// positions
@@ -166,13 +174,13 @@ int main() {
 	// note that this is allowed, the call to glVertexAttribPointer registered
 	// VBO as the vertex attribute's bound vertex buffer object so afterwards
 	// we can safely unbind
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	state.bind_buffer(GL_ARRAY_BUFFER, 0);
 
 	// You can unbind the VAO afterwards so other VAO calls won't accidentally
 	// modify this VAO, but this rarely happens. Modifying other
 	// VAOs requires a call to glBindVertexArray anyways so we generally don't
 	// unbind VAOs (nor VBOs) when it's not directly necessary.
-	glBindVertexArray(0);
+	state.bind_vertex_array(0);
 
 	// create cubes positions
 	// ----------------------
@@ -214,8 +222,7 @@ int main() {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, wooden_texture->id);
+		state.bind_texture(0, GL_TEXTURE_2D, wooden_texture->id);
 
 		// activate shader program
 		shader_program.use();
@@ -227,7 +234,7 @@ int main() {
 		// Seeing as we only have a single  VAO there's
 		// no need to bind it every time, but we'll do
 		// so to keep things a bit more organized
-		glBindVertexArray(VAO);
+		state.bind_vertex_array(VAO);
 		for (unsigned int i = 0; i < 10; i++) {
 			glm::mat4 model{1.0f};
 			model = glm::translate(model, cube_positions[i]);
@@ -245,9 +252,9 @@ int main() {
 	}
 
 	// optional: de-allocate all resources once they've outlived their purpose:
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	state.delete_vertex_array(VAO);
+	state.delete_buffer(VBO);
+	state.delete_buffer(EBO);
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	glfwTerminate();
@@ -260,7 +267,7 @@ int main() {
 void framebuffer_size_callback(GLFWwindow*, int width, int height) {
 	// make sure the viewport matches the new window dimensions; note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	ow::gl_state::current().viewport(0, 0, width, height);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released
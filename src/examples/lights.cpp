@@ -1,4 +1,6 @@
+#include <cmath>
 #include <iostream>
+#include <random>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -6,20 +8,29 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <ow/gl_extensions.hpp>
+#include <ow/gl_state.hpp>
+#include <ow/shader_object_cache.hpp>
+#include <ow/shader_permutations.hpp>
 #include <ow/shader_program.hpp>
 #include <ow/camera_fps.hpp>
+#include <ow/clustered_lights.hpp>
+#include <ow/deferred_renderer.hpp>
 #include <ow/vertex.hpp>
 #include <ow/lights_set.hpp>
 #include <ow/directional_light.hpp>
 #include <ow/point_light.hpp>
 #include <ow/spotlight.hpp>
 #include <ow/mesh.hpp>
+#include <ow/render_queue.hpp>
 #include <ow/texture.hpp>
+#include <ow/texture_registry.hpp>
 #include <ow/utils.hpp>
 
 void process_input(GLFWwindow* window, float dt);
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
@@ -34,6 +45,16 @@ float last_x = static_cast<float>(SCREEN_WIDTH) / 2.f;
 float last_y = static_cast<float>(SCREEN_HEIGHT) / 2.f;
 bool first_mouse = true;
 
+// C cycles through the shading paths. Forward only sees the first MAX_POINT_LIGHTS point
+// lights, the others shade with every light.
+enum class shading {
+	forward,
+	clustered,
+	deferred
+};
+shading mode = shading::clustered;
+const std::size_t SWARM_SIZE = 2048;
+
 int main() {
 	// glfw: initialize and configure
 	glfwInit();
@@ -57,32 +78,55 @@ int main() {
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	// glad: load all OpenGL function pointers
 	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
 		ow::logger << "Failed to initialize GLAD" << std::endl;
 		return EXIT_FAILURE;
 	}
+	// entry points above OpenGL 3.3, when the driver has them
+	ow::load_gl_extensions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	ow::gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
 	// call to draw in wireframe polygons.
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	// load the texture
 	// ----------------
-	auto white_texture = std::make_shared<ow::texture>("resources/textures/white.jpg", ow::texture_type::emission);
-	auto diffuse_map   = std::make_shared<ow::texture>("resources/textures/container2.png", ow::texture_type::diffuse);
-	auto specular_map  = std::make_shared<ow::texture>("resources/textures/container2_specular.png", ow::texture_type::specular);
+	auto& textures = ow::texture_registry::global();
+	auto white_texture = textures.get("resources/textures/white.jpg", ow::texture_type::emission);
+	auto diffuse_map   = textures.get("resources/textures/container2.png", ow::texture_type::diffuse);
+	auto specular_map  = textures.get("resources/textures/container2_specular.png", ow::texture_type::specular);
 
 	// load shaders
 	// ------------
-	ow::shader_program prog{
+	// the lit programs are linked in the background, the placeholder is drawn until they are ready.
+	ow::shader_program placeholder{
 			{{GL_VERTEX_SHADER, "phong_vertex.glsl"}
-			,{GL_FRAGMENT_SHADER, "phong_frag.glsl"}
+			,{GL_FRAGMENT_SHADER, "placeholder_frag.glsl"}
 	}};
+	// with separable programs, the variants only link their fragment stage: phong_vertex.glsl
+	// is linked once, and the render queue pairs them in a pipeline.
+	const bool separable = ow::gl_extensions::current().separate_shader_objects;
+	ow::shader_program phong_stage;
+	if (separable) {
+		phong_stage.set_separable(true);
+		phong_stage.put({{GL_VERTEX_SHADER, "phong_vertex.glsl"}});
+	}
+	std::vector<std::pair<GLenum, std::string>> phong_shaders{{GL_FRAGMENT_SHADER, "phong_frag.glsl"}};
+	if (!separable) {
+		phong_shaders.insert(phong_shaders.begin(), {GL_VERTEX_SHADER, "phong_vertex.glsl"});
+	}
+	ow::shader_permutations phong{std::move(phong_shaders), separable};
+	ow::shader_program clustered_prog;
+	clustered_prog.put_async(
+			{{GL_VERTEX_SHADER, "phong_vertex.glsl"}
+			,{GL_FRAGMENT_SHADER, "phong_clustered_frag.glsl"}
+	});
 
 	// set up mesh
 	// -----------
@@ -195,9 +239,34 @@ int main() {
 	);
 	lights.add_spotlight(spotlight);
 
-	prog.use();
-	prog.set("materials_shininess", 32.f);
-	lights.update_all(prog, glm::mat4());
+	// a swarm of small colored lights, going up and down around the containers
+	std::vector<std::shared_ptr<ow::point_light>> swarm;
+	std::vector<glm::vec3> swarm_origins;
+	{
+		std::mt19937 rng{42};
+		std::uniform_real_distribution<float> unit{0.f, 1.f};
+		for (std::size_t i = 0; i < SWARM_SIZE; ++i) {
+			glm::vec3 pos{-6.f + 12.f * unit(rng), -4.f + 8.f * unit(rng), -16.f + 18.f * unit(rng)};
+			glm::vec3 color{unit(rng), unit(rng), unit(rng)};
+			auto light = std::make_shared<ow::point_light>(0.3f * color, 0.3f * color, pos, 1.0f, 0.7f, 1.8f);
+			lights.add_point_light(light);
+			swarm.push_back(light);
+			swarm_origins.push_back(pos);
+		}
+	}
+
+	ow::render_queue queue;
+	ow::clustered_lights clusters;
+	ow::deferred_renderer deferred;
+
+	// forward programs specialised for the material of each mesh and the light counts
+	ow::shader_program& cube_prog = phong.submit(cube_mesh.material_defines().merge(lights.count_defines()));
+	ow::shader_program& lamp_prog = phong.submit(lamp_mesh.material_defines().merge(lights.count_defines()));
+	// every program is submitted: phong_vertex.glsl was compiled once for all of them.
+	ow::shader_object_cache::global().trim();
+
+	deferred.geometry_program().use();
+	deferred.geometry_program().set("materials_shininess", 32.f);
 
 	// game loop
 	// -----------
@@ -215,47 +284,76 @@ int main() {
 		spotlight->set_pos(camera.get_pos());
 		spotlight->set_dir(camera.get_front());
 
+		for (std::size_t i = 0; i < swarm.size(); ++i) {
+			float phase = current_frame + static_cast<float>(i);
+			swarm[i]->set_pos(swarm_origins[i] + glm::vec3(0.f, std::sin(phase), 0.f));
+		}
+
 		// render
 		// ------
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// activate shader program
-		prog.use();
-
 		// create transformations
 		glm::mat4 view = camera.get_view_matrix();
 		glm::mat4 proj = camera.get_proj_matrix(static_cast<float>(SCREEN_WIDTH) / static_cast<float>(SCREEN_HEIGHT));
-		prog.set("view", view);
-		prog.set("proj", proj);
 
 		// update lights
-		lights.update_position_and_direction(prog, view);
+		lights.upload(view);
 
-		// draw lamps
-		for (const auto& pt_light : point_lights) {
-			glm::mat4 model{1.0f};
-			model = glm::translate(model, pt_light->get_pos());
-			model = glm::scale(model, glm::vec3(.2f));
-			prog.set("model", model);
-
-			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * model)));
-			prog.set("normal_matrix", normal_matrix);
-
-			lamp_mesh.draw(prog);
+		// activate shader program
+		const ow::shader_program& lit = mode == shading::forward ? cube_prog.ready_or(placeholder)
+				: mode == shading::clustered ? clustered_prog.ready_or(placeholder)
+				: deferred.geometry_program();
+		const ow::shader_program& lit_vertex = lit.separable() ? phong_stage : lit;
+		if (mode == shading::deferred) {
+			deferred.geometry_pass(view, proj);
+		} else {
+			lit_vertex.use();
+			lit_vertex.set("view", view);
+			lit_vertex.set("proj", proj);
+			lit.set("materials_shininess", 32.f);
+		}
+		if (mode == shading::clustered) {
+			clusters.update(lights, view, proj);
+			clusters.set_uniforms(lit);
 		}
 
-		// draw containers
+		// containers
 		for (unsigned int i = 0; i < 10; i++) {
 			glm::mat4 model{1.0f};
 			model = glm::translate(model, cube_positions[i]);
 			model = glm::rotate(model, static_cast<float>(0.2 * i), glm::vec3(1.0f, 0.3f, 0.5f));
-			prog.set("model", model);
+			queue.submit(cube_mesh, lit_vertex, lit, model);
+		}
 
-			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * model)));
-			prog.set("normal_matrix", normal_matrix);
+		// the G-buffer has no emission: with deferred shading, lamps are drawn forward once lit
+		if (mode == shading::deferred) {
+			queue.execute(view);
+			deferred.lighting_pass(lights, view, proj);
+			deferred.forward_pass();
+		}
+		const ow::shader_program& lamp_lit = mode == shading::clustered ? lit : lamp_prog.ready_or(placeholder);
+		const ow::shader_program& lamp_vertex = lamp_lit.separable() ? phong_stage : lamp_lit;
+		if (&lamp_lit != &lit) {
+			lamp_vertex.use();
+			lamp_vertex.set("view", view);
+			lamp_vertex.set("proj", proj);
+			lamp_lit.set("materials_shininess", 32.f);
+		}
 
-			cube_mesh.draw(prog);
+		// lamps
+		for (const auto& pt_light : point_lights) {
+			glm::mat4 model{1.0f};
+			model = glm::translate(model, pt_light->get_pos());
+			model = glm::scale(model, glm::vec3(.2f));
+			queue.submit(lamp_mesh, lamp_vertex, lamp_lit, model);
+		}
+
+		// draw everything, grouped by material and front to back
+		queue.execute(view);
+		if (mode == shading::deferred) {
+			deferred.present();
 		}
 
 		// glfw: swap buffers and poll IO events
@@ -301,7 +399,15 @@ void process_input(GLFWwindow* window, float dt) {
 void framebuffer_size_callback(GLFWwindow*, int width, int height) {
 	// make sure the viewport matches the new window dimensions; note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	ow::gl_state::current().viewport(0, 0, width, height);
+}
+
+void key_callback(GLFWwindow*, int key, int, int action, int) {
+	if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+		const char* names[] = {"forward", "clustered", "deferred"};
+		mode = static_cast<shading>((static_cast<int>(mode) + 1) % 3);
+		ow::logger << names[static_cast<int>(mode)] << " shading" << std::endl;
+	}
 }
 
 void mouse_callback(GLFWwindow*, double xpos, double ypos) {
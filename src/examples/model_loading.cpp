@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 
 #include <glad/glad.h>
@@ -5,16 +6,21 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <ow/gl_extensions.hpp>
+#include <ow/gl_state.hpp>
 #include <ow/shader_program.hpp>
+#include <ow/shader_object_cache.hpp>
 #include <ow/camera_fps.hpp>
 #include <ow/vertex.hpp>
 #include <ow/lights_set.hpp>
 #include <ow/directional_light.hpp>
 #include <ow/point_light.hpp>
 #include <ow/spotlight.hpp>
+#include <ow/frustum.hpp>
 #include <ow/mesh.hpp>
 #include <ow/texture.hpp>
 #include <ow/model.hpp>
+#include <ow/texture_registry.hpp>
 #include <ow/utils.hpp>
 
 void process_input(GLFWwindow* window, float dt);
@@ -63,17 +69,19 @@ int main() {
 		ow::logger << "Failed to initialize GLAD" << std::endl;
 		return EXIT_FAILURE;
 	}
+	// entry points above OpenGL 3.3, when the driver has them
+	ow::load_gl_extensions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	ow::gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
 	// call to draw in wireframe polygons.
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	// load the texture
 	// ----------------
-	auto white_texture = std::make_shared<ow::texture>("resources/textures/white.jpg", ow::texture_type::emission);
+	auto white_texture = ow::texture_registry::global().get("resources/textures/white.jpg", ow::texture_type::emission);
 
 	// load shaders
 	// ------------
@@ -81,6 +89,8 @@ int main() {
 			{{GL_VERTEX_SHADER, "phong_vertex.glsl"}
 			,{GL_FRAGMENT_SHADER, "phong_frag.glsl"}
 	}};
+	// the shaders compiled for these programs are no longer needed.
+	ow::shader_object_cache::global().trim();
 
 	// set up mesh
 	// -----------
@@ -145,6 +155,7 @@ int main() {
 
 	ow::mesh lamp_mesh{std::move(vertices), std::move(indices)};
 	lamp_mesh.add_texture(white_texture);
+	std::vector<ow::instance> lamp_instances;
 
 	// lights
 	// ------
@@ -169,11 +180,17 @@ int main() {
 
 	prog.use();
 	prog.set("materials_shininess", 32.f);
-	lights.update_all(prog, glm::mat4());
 
 	// load models
 	// -----------
-	ow::model nanosuit{"resources/models/nanosuit/nanosuit.obj"};
+	// streamed: meshes show up as soon as they are uploaded, without stalling the game loop.
+	// packed: all the meshes share one VAO.
+	// optimized: indices and vertices are reordered once, then reloaded from the mesh cache.
+	ow::model_options nanosuit_options;
+	nanosuit_options.mode = ow::model_load_mode::streaming;
+	nanosuit_options.packed = true;
+	nanosuit_options.optimize = true;
+	ow::model nanosuit{"resources/models/nanosuit/nanosuit.obj", nanosuit_options};
 
 	// game loop
 	// -----------
@@ -188,6 +205,13 @@ int main() {
 		// -----
 		process_input(window, delta_time);
 
+		// upload the parts of the model which are ready
+		if (!nanosuit.loaded() && nanosuit.stream(std::chrono::milliseconds(4))) {
+			auto tex_stats = ow::texture_registry::global().stats();
+			ow::logger << "textures: " << tex_stats.resident_textures << " resident (" << tex_stats.resident_bytes / 1024
+					   << " KiB), " << tex_stats.hits << " hits, " << tex_stats.misses << " misses\n";
+		}
+
 		// render
 		// ------
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -203,9 +227,10 @@ int main() {
 		glm::mat4 proj = camera.get_proj_matrix(static_cast<float>(SCREEN_WIDTH) / static_cast<float>(SCREEN_HEIGHT));
 		prog.set("view", view);
 		prog.set("proj", proj);
+		ow::frustum view_frustum{proj, view};
 
 		// update lights
-		lights.update_position_and_direction(prog, view);
+		lights.upload(view);
 
 		{ // nanosuit
 			glm::mat4 model{1.0f};
@@ -216,21 +241,20 @@ int main() {
 			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * model)));
 			prog.set("normal_matrix", normal_matrix);
 
-			nanosuit.draw(prog);
+			nanosuit.draw(prog, view_frustum, model);
 		}
 
-		// draw lamps
+		// draw the visible lamps, all in one draw call
+		lamp_instances.clear();
 		for (auto&& pt_light : point_lights) {
 			glm::mat4 model{1.0f};
 			model = glm::translate(model, pt_light->get_pos());
 			model = glm::scale(model, glm::vec3(.2f));
-			prog.set("model", model);
-
-			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * model)));
-			prog.set("normal_matrix", normal_matrix);
-
-			lamp_mesh.draw(prog);
+			if (view_frustum.intersects(ow::transform(lamp_mesh.get_bounding_sphere(), model))) {
+				lamp_instances.push_back({model, glm::vec4{1.f}});
+			}
 		}
+		lamp_mesh.draw_instanced(prog, lamp_instances);
 
 		// glfw: swap buffers and poll IO events
 		// -------------------------------------
@@ -275,7 +299,7 @@ void process_input(GLFWwindow* window, float dt) {
 void framebuffer_size_callback(GLFWwindow*, int width, int height) {
 	// make sure the viewport matches the new window dimensions; note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	ow::gl_state::current().viewport(0, 0, width, height);
 }
 
 void mouse_callback(GLFWwindow*, double xpos, double ypos) {
@@ -1,3 +1,4 @@
+#include <array>
 #include <cstddef>
 #include <bitset>
 
@@ -14,6 +15,7 @@
 #include <GLFW/glfw3native.h>
 #endif
 
+#include <ow/gl_state.hpp>
 #include <ow/shader_program.hpp>
 #include <gui/imgui_impl.hpp>
 
@@ -80,47 +82,31 @@ void gui::imgui_impl::render() {
 
 	draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
-	// Save OpenGL state to restore it after drawing imgui.
-	GLint last_program;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
-	GLint last_texture;
-	glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-	GLint last_active_texture;
-	glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
-	GLint last_array_buffer;
-	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
-	GLint last_element_array_buffer;
-	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &last_element_array_buffer);
-	GLint last_vertex_array;
-	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
-	GLint last_blend_src;
-	glGetIntegerv(GL_BLEND_SRC, &last_blend_src);
-	GLint last_blend_dst;
-	glGetIntegerv(GL_BLEND_DST, &last_blend_dst);
-	GLint last_blend_equation_rgb;
-	glGetIntegerv(GL_BLEND_EQUATION_RGB, &last_blend_equation_rgb);
-	GLint last_blend_equation_alpha;
-	glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &last_blend_equation_alpha);
-	GLint last_viewport[4];
-	glGetIntegerv(GL_VIEWPORT, last_viewport);
-	GLint last_scissor_box[4];
-	glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-	GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-	GLboolean last_enable_cullface = glIsEnabled(GL_CULL_FACE);
-	GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-	GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+	// Save OpenGL state to restore it after drawing imgui. The tracker knows it: no glGet.
+	auto& state = ow::gl_state::current();
+	GLuint last_program = state.program();
+	GLuint last_active_texture = state.active_texture();
+	GLuint last_texture = state.texture(0, GL_TEXTURE_2D);
+	GLuint last_array_buffer = state.buffer(GL_ARRAY_BUFFER);
+	GLuint last_vertex_array = state.vertex_array();
+	ow::gl_state::blend_state last_blend = state.blend();
+	std::array<GLint, 4> last_viewport = state.viewport();
+	std::array<GLint, 4> last_scissor_box = state.scissor();
+	bool last_enable_blend = state.is_enabled(GL_BLEND);
+	bool last_enable_cullface = state.is_enabled(GL_CULL_FACE);
+	bool last_enable_depth_test = state.is_enabled(GL_DEPTH_TEST);
+	bool last_enable_scissor_test = state.is_enabled(GL_SCISSOR_TEST);
 
 	// Setup Imgui Render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled
-	glEnable(GL_BLEND);
-	glBlendEquation(GL_FUNC_ADD);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
-	glEnable(GL_SCISSOR_TEST);
-	glActiveTexture(GL_TEXTURE0);
+	state.set_enabled(GL_BLEND, true);
+	state.blend_equation(GL_FUNC_ADD, GL_FUNC_ADD);
+	state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	state.set_enabled(GL_CULL_FACE, false);
+	state.set_enabled(GL_DEPTH_TEST, false);
+	state.set_enabled(GL_SCISSOR_TEST, true);
 
 	// Setup viewport from imgui information.
-	glViewport(0, 0, framebuffer_width, framebuffer_height);
+	state.viewport(0, 0, framebuffer_width, framebuffer_height);
 
 	glm::mat4x4 mat4x4 = glm::ortho(0.f, io.DisplaySize.x, io.DisplaySize.y, 0.f);
 
@@ -129,18 +115,18 @@ void gui::imgui_impl::render() {
 	s_shader_program.set("Texture", 0);
 	s_shader_program.set("ProjMtx", mat4x4);
 
-	glBindVertexArray(s_vao_handle);
+	state.bind_vertex_array(s_vao_handle);
 
 	for (int n = 0; n < draw_data->CmdListsCount; n++) {
 		const ImDrawList* cmd_list = draw_data->CmdLists[n];
 		const ImDrawIdx* idx_buffer_offset = nullptr;
 
-		glBindBuffer(GL_ARRAY_BUFFER, s_vbo_handle);
+		state.bind_buffer(GL_ARRAY_BUFFER, s_vbo_handle);
 		glBufferData(GL_ARRAY_BUFFER,
 		             static_cast<GLsizeiptr>(static_cast<long unsigned int>(cmd_list->VtxBuffer.Size) * sizeof(ImDrawVert)),
 		             static_cast<const GLvoid*>(cmd_list->VtxBuffer.Data), GL_STREAM_DRAW);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_elements_handle);
+		state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, s_elements_handle);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
 		             static_cast<GLsizeiptr>(static_cast<long unsigned int>(cmd_list->IdxBuffer.Size) * sizeof(ImDrawIdx)),
 		             static_cast<const GLvoid*>(cmd_list->IdxBuffer.Data), GL_STREAM_DRAW);
@@ -150,8 +136,8 @@ void gui::imgui_impl::render() {
 			if (pcmd->UserCallback) {
 				pcmd->UserCallback(cmd_list, pcmd);
 			} else {
-				glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(reinterpret_cast<intptr_t>(pcmd->TextureId)));
-				glScissor(static_cast<GLint>(pcmd->ClipRect.x),
+				state.bind_texture(0, GL_TEXTURE_2D, static_cast<GLuint>(reinterpret_cast<intptr_t>(pcmd->TextureId)));
+				state.scissor(static_cast<GLint>(pcmd->ClipRect.x),
 				          static_cast<GLint>(static_cast<float>(framebuffer_height)- pcmd->ClipRect.w),
 				          static_cast<GLsizei>(pcmd->ClipRect.z - pcmd->ClipRect.x),
 				          static_cast<GLsizei>(pcmd->ClipRect.w - pcmd->ClipRect.y));
@@ -162,21 +148,20 @@ void gui::imgui_impl::render() {
 		}
 	}
 
-	// Restore modified GL state
-	glUseProgram(static_cast<GLuint>(last_program));
-	glActiveTexture(static_cast<GLuint>(last_active_texture));
-	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(last_texture));
-	glBindVertexArray(static_cast<GLuint>(last_vertex_array));
-	glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(last_array_buffer));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLuint>(last_element_array_buffer));
-	glBlendEquationSeparate(static_cast<GLuint>(last_blend_equation_rgb), static_cast<GLuint>(last_blend_equation_alpha));
-	glBlendFunc(static_cast<GLuint>(last_blend_src), static_cast<GLuint>(last_blend_dst));
-	if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
-	if (last_enable_cullface) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
-	if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
-	if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
-	glViewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
-	glScissor(last_scissor_box[0], last_scissor_box[1], last_scissor_box[2], last_scissor_box[3]);
+	// Restore modified GL state, the element buffer belongs to the vertex array.
+	state.use_program(last_program);
+	state.bind_texture(0, GL_TEXTURE_2D, last_texture);
+	state.active_texture(last_active_texture);
+	state.bind_vertex_array(last_vertex_array);
+	state.bind_buffer(GL_ARRAY_BUFFER, last_array_buffer);
+	state.blend_equation(last_blend.equation_rgb, last_blend.equation_alpha);
+	state.blend_func(last_blend.src, last_blend.dst);
+	state.set_enabled(GL_BLEND, last_enable_blend);
+	state.set_enabled(GL_CULL_FACE, last_enable_cullface);
+	state.set_enabled(GL_DEPTH_TEST, last_enable_depth_test);
+	state.set_enabled(GL_SCISSOR_TEST, last_enable_scissor_test);
+	state.viewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
+	state.scissor(last_scissor_box[0], last_scissor_box[1], last_scissor_box[2], last_scissor_box[3]);
 }
 
 const char* gui::imgui_impl::get_clipboard_text(void *window) {
@@ -233,10 +218,10 @@ bool gui::imgui_impl::create_fonts_texture() {
 	                             &height);   // Load as RGBA 32-bits (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders. If your ImTextureId represent a higher-level concept than just a GL texture id, consider calling GetTexDataAsAlpha8() instead to save on GPU memory.
 
 	// Upload texture to graphics system
-	GLint last_texture;
-	glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+	auto& state = ow::gl_state::current();
+	GLuint last_texture = state.texture(state.active_texture(), GL_TEXTURE_2D);
 	glGenTextures(1, &s_font_texture);
-	glBindTexture(GL_TEXTURE_2D, s_font_texture);
+	state.bind_texture(GL_TEXTURE_2D, s_font_texture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
@@ -245,17 +230,16 @@ bool gui::imgui_impl::create_fonts_texture() {
 	io.Fonts->TexID = reinterpret_cast<void*>(static_cast<intptr_t>(s_font_texture));
 
 	// Restore state
-	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(last_texture));
+	state.bind_texture(GL_TEXTURE_2D, last_texture);
 
 	return true;
 }
 
 bool gui::imgui_impl::create_device_objects() {
 	// Backup OpenGL state
-	GLint last_texture, last_array_buffer, last_vertex_array;
-	glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
-	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+	auto& state = ow::gl_state::current();
+	GLuint last_array_buffer = state.buffer(GL_ARRAY_BUFFER);
+	GLuint last_vertex_array = state.vertex_array();
 
 	s_shader_program.put({
 		{GL_VERTEX_SHADER,   "imgui_vertex.glsl"},
@@ -266,8 +250,8 @@ bool gui::imgui_impl::create_device_objects() {
 	glGenBuffers(1, &s_elements_handle);
 	glGenVertexArrays(1, &s_vao_handle);
 
-	glBindVertexArray(s_vao_handle);
-	glBindBuffer(GL_ARRAY_BUFFER, s_vbo_handle);
+	state.bind_vertex_array(s_vao_handle);
+	state.bind_buffer(GL_ARRAY_BUFFER, s_vbo_handle);
 
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), reinterpret_cast<void*>(offsetof(ImDrawVert, pos)));
 	glEnableVertexAttribArray(0);
@@ -278,31 +262,30 @@ bool gui::imgui_impl::create_device_objects() {
 
 	create_fonts_texture();
 
-	// Restore modified OpenGL state
-	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(last_texture));
-	glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(last_array_buffer));
-	glBindVertexArray(static_cast<GLuint>(last_vertex_array));
+	// Restore modified OpenGL state (create_fonts_texture restores the texture)
+	state.bind_buffer(GL_ARRAY_BUFFER, last_array_buffer);
+	state.bind_vertex_array(last_vertex_array);
 
 	return true;
 }
 
 void gui::imgui_impl::invalidate_device_objects() {
 	if (s_vao_handle) {
-		glDeleteVertexArrays(1, &s_vao_handle);
+		ow::gl_state::current().delete_vertex_array(s_vao_handle);
 	}
 
 	if (s_vbo_handle) {
-		glDeleteBuffers(1, &s_vbo_handle);
+		ow::gl_state::current().delete_buffer(s_vbo_handle);
 	}
 
 	if (s_elements_handle) {
-		glDeleteBuffers(1, &s_elements_handle);
+		ow::gl_state::current().delete_buffer(s_elements_handle);
 	}
 
 	s_vao_handle = s_vbo_handle = s_elements_handle = 0;
 
 	if (s_font_texture) {
-		glDeleteTextures(1, &s_font_texture);
+		ow::gl_state::current().delete_texture(s_font_texture);
 		ImGui::GetIO().Fonts->TexID = nullptr;
 		s_font_texture = 0;
 	}
@@ -7,6 +7,7 @@ cube::cube() noexcept
 	, m_EBO(0)
 	, m_VBO()
 	, m_indices_size(0)
+	, m_instances()
 {
 	std::array vertices = {
 			// front
@@ -46,7 +47,8 @@ cube::cube() noexcept
 			0.5f, -0.5f,  0.5f,
 	};
 
-	std::vector<GLuint> indices = {
+	// 24 vertices: 16 bits indices are enough.
+	std::vector<GLushort> indices = {
 			// front face
 			0, 1, 2, // first triangle
 			1, 2, 3,  // second triangle
@@ -71,11 +73,12 @@ cube::cube() noexcept
 	glGenBuffers(1, &m_EBO);
 	glGenVertexArrays(1, &m_VAO);
 
-	glBindVertexArray(m_VAO);
+	auto& state = ow::gl_state::current();
+	state.bind_vertex_array(m_VAO);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 	ow::check_errors("Failed to bind EBO. ");
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
 	ow::check_errors("Failed to set EBO data. ");
 
 	m_VBO.set_data(vertices);
@@ -83,31 +86,53 @@ cube::cube() noexcept
 	m_VBO.attribs().stride = 0;
 	m_VBO.flush_layout_attribs();
 
-	glBindVertexArray(0);
+	state.bind_vertex_array(0);
 }
 
 cube::cube(cube&& other) noexcept
 		: m_VAO{std::exchange(other.m_VAO, 0)}
 		, m_EBO{std::exchange(other.m_EBO, 0)}
 		, m_VBO{std::move(other.m_VBO)}
-		, m_indices_size(other.m_indices_size){}
+		, m_indices_size(other.m_indices_size)
+		, m_instances(std::move(other.m_instances)) {}
 
 cube::~cube() {
-	glDeleteVertexArrays(1, &m_VAO);
+	ow::gl_state::current().delete_vertex_array(m_VAO);
 	ow::check_errors("error while deleting VAO. ");
-	glDeleteBuffers(1, &m_EBO);
+	ow::gl_state::current().delete_buffer(m_EBO);
 	ow::check_errors("error while deleting EBO. ");
 }
 
 void cube::draw(const ow::shader_program& prog) const {
 	prog.use();
 
-	glBindVertexArray(m_VAO);
+	ow::gl_state::current().bind_vertex_array(m_VAO);
 	ow::check_errors("failed to bind VAO. ");
 
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices_size), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices_size), GL_UNSIGNED_SHORT, 0);
+	ow::check_errors("failed to draw VAO elements. ");
+}
+
+void cube::draw_instanced(const ow::shader_program& prog, const std::vector<ow::instance>& instances) const {
+	if (instances.empty()) {
+		return;
+	}
+	if (!m_instances) {
+		m_instances = std::make_unique<ow::instance_buffer>();
+	}
+	m_instances->set_data(instances);
+
+	prog.use();
+	prog.set("instanced", true);
+
+	ow::gl_state::current().bind_vertex_array(m_VAO);
+	ow::check_errors("failed to bind VAO. ");
+	m_instances->attach();
+
+	glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(m_indices_size), GL_UNSIGNED_SHORT, 0,
+							static_cast<GLsizei>(instances.size()));
 	ow::check_errors("failed to draw VAO elements. ");
 
-	glBindVertexArray(0);
-	ow::check_errors("failed to unbind VAO. ");
+	ow::instance_buffer::detach();
+	prog.set("instanced", false);
 }
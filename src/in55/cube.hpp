@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include <ow/instance_buffer.hpp>
 #include <ow/VBO.hpp>
 #include <ow/shader_program.hpp>
 
@@ -13,9 +17,13 @@ public:
 
 	void draw(const ow::shader_program& prog) const;
 
+	// one cube per instance in a single draw call (see lamp_vertex.glsl).
+	void draw_instanced(const ow::shader_program& prog, const std::vector<ow::instance>& instances) const;
+
 private:
 	// render data
 	GLuint m_VAO, m_EBO;
 	ow::VBO<1> m_VBO;
 	unsigned long m_indices_size;
+	mutable std::unique_ptr<ow::instance_buffer> m_instances; // created by the first draw_instanced
 };
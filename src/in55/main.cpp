@@ -1,15 +1,22 @@
+#include <algorithm>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include <ow/gl_extensions.hpp>
+#include <ow/gl_state.hpp>
 #include <ow/shader_program.hpp>
+#include <ow/shader_object_cache.hpp>
 #include <ow/camera_fps.hpp>
 #include <ow/lights_set.hpp>
 #include <ow/directional_light.hpp>
 #include <ow/point_light.hpp>
 #include <ow/texture.hpp>
 #include <ow/skybox.hpp>
+#include <ow/texture_registry.hpp>
 #include <ow/utils.hpp>
+#include <ow/bvh.hpp>
 #include <gui/window.hpp>
 
 #include "parametrical_object.hpp"
@@ -21,6 +28,7 @@ void process_input(gui::window& window, float dt);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 namespace {
 	// settings
@@ -33,6 +41,7 @@ namespace {
 	auto last_x = static_cast<float>(800) / 2.f;
 	auto last_y = static_cast<float>(600) / 2.f;
 	bool first_mouse = true;
+	bool pick_requested = false; // right click: report the object under the cursor
 }
 
 int main() {
@@ -46,16 +55,19 @@ int main() {
 	window.set_framebuffer_size_callback(framebuffer_size_callback);
 	window.set_cursor_pos_callback(mouse_callback);
 	window.set_scroll_callback(scroll_callback);
+	window.set_mouse_callback(mouse_button_callback);
 
 	// glad: load all OpenGL function pointers
 	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
 		ow::logger << "Failed to initialize GLAD" << std::endl;
 		return EXIT_FAILURE;
 	}
+	// entry points above OpenGL 3.3, when the driver has them
+	ow::load_gl_extensions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	ow::gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 	ow::check_errors("Failed to set GL_DEPTH_TEST.");
 
 	// Init ImGui
@@ -64,15 +76,16 @@ int main() {
 
 	// load the texture
 	// ----------------
-	auto white_diffuse = std::make_shared<ow::texture>("resources/textures/white.jpg", ow::texture_type::diffuse);
-	auto white_spec = std::make_shared<ow::texture>("resources/textures/white.jpg", ow::texture_type::specular);
+	auto& textures = ow::texture_registry::global();
+	auto white_diffuse = textures.get("resources/textures/white.jpg", ow::texture_type::diffuse);
+	auto white_spec = textures.get("resources/textures/white.jpg", ow::texture_type::specular);
 
 	// load shaders
 	// ------------
 	ow::shader_program phong_prog{{
 		{GL_VERTEX_SHADER, "phong_vertex.glsl"},
-		{GL_FRAGMENT_SHADER, "phong_skybox_frag.glsl"}
-	}};
+		{GL_FRAGMENT_SHADER, "phong_frag.glsl"}
+	}, {{"SKYBOX_REFLECTION", "1"}}};
 
 	ow::shader_program lamp_prog{{
 		{GL_VERTEX_SHADER, "lamp_vertex.glsl"},
@@ -83,6 +96,8 @@ int main() {
 		{GL_VERTEX_SHADER, "skybox_vertex.glsl"},
 		{GL_FRAGMENT_SHADER, "skybox_frag.glsl"}
 	}};
+	// the shaders compiled for these programs are no longer needed.
+	ow::shader_object_cache::global().trim();
 
 	// lights
 	// ------
@@ -126,10 +141,10 @@ int main() {
 	}
 
 	cube lamp_mesh;
+	std::vector<ow::instance> lamp_instances;
 
 	phong_prog.use();
 	phong_prog.set("materials_shininess", 32.f);
-	lights.update_all(phong_prog, glm::mat4());
 
 	// Create the parametrical object
 	// ------------------------------
@@ -140,24 +155,34 @@ int main() {
 	auto object = std::make_unique<parametrical_object>(number_of_faces);
 	object->add_texture(white_diffuse);
 	object->add_texture(white_spec);
+	object->generate_lods();
+	object->build_bvh();
+
+	// scene index for picking
+	// -----------------------
+	ow::scene_bvh scene;
+	auto object_id = scene.insert(object->get_aabb());
+	std::vector<ow::scene_bvh::object_id> lamp_ids;
+	for (const auto& pt_light : point_lights) {
+		glm::vec3 half_size{.1f}; // cube of side 1 scaled by .2
+		lamp_ids.push_back(scene.insert({pt_light->get_pos() - half_size, pt_light->get_pos() + half_size}));
+	}
 
 	// Skybox
 	// ------
 	// create a skybox texture from several images.
-	auto skybox = std::make_shared<ow::skybox>("resources/textures/skybox");
+	auto skybox = textures.get_skybox("resources/textures/skybox");
 	// cube wrapping the camera with sky texture.
 	auto skybox_cube = std::make_unique<cube>();
 
 	// bind the skybox texture in the skybox shader program.
 	skybox_prog.use();
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->id);
+	ow::gl_state::current().bind_texture(0, GL_TEXTURE_CUBE_MAP, skybox->id);
 	skybox_prog.set("skybox", 0);
 
 	// configure phong program to handle reflections on the skybox
 	phong_prog.use();
-	glActiveTexture(GL_TEXTURE0 + 15);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->id);
+	ow::gl_state::current().bind_texture(15, GL_TEXTURE_CUBE_MAP, skybox->id);
 	phong_prog.set("skybox", 15);
 
 	// game loop
@@ -193,45 +218,75 @@ int main() {
 		phong_prog.set("proj", proj);
 
 		// update lights
-		lights.update_all(phong_prog, view);
+		lights.upload(view);
+
+		glm::mat4 object_model{1.0f};
+		object_model = glm::scale(object_model, glm::vec3(scale));
+		object_model = glm::rotate(object_model, angle_x, glm::vec3(1.0, 0.0, 0.0));
+		object_model = glm::rotate(object_model, angle_z, glm::vec3(0.0, 0.0, 1.0));
+		scene.update(object_id, ow::transform(object->get_aabb(), object_model));
+		scene.commit();
+
+		if (pick_requested) {
+			pick_requested = false;
+			ow::ray cursor_ray = ow::ray_through_cursor(proj, view, {last_x, last_y},
+				{static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT)});
+
+			// the lamps are cubes: their box is exact. The object is tested triangle by triangle.
+			glm::mat4 to_object = glm::inverse(object_model);
+			auto hit = scene.raycast(cursor_ray, [&] (ow::scene_bvh::object_id id, float max_distance) {
+				if (id != object_id) {
+					return ow::intersect(cursor_ray, scene.bounds(id), max_distance);
+				}
+				return object->get_bvh()->raycast(ow::transform(cursor_ray, to_object), max_distance).distance;
+			});
+
+			if (!hit) {
+				ow::logger << "picked nothing" << std::endl;
+			} else if (hit.object == object_id) {
+				ow::logger << "picked the object at distance " << hit.distance << std::endl;
+			} else {
+				auto lamp = std::find(lamp_ids.begin(), lamp_ids.end(), hit.object) - lamp_ids.begin();
+				ow::logger << "picked lamp " << lamp << " at distance " << hit.distance << std::endl;
+			}
+		}
 
 		{ // draw object
-			glm::mat4 model{1.0f};
-			model = glm::scale(model, glm::vec3(scale));
-			model = glm::rotate(model, angle_x, glm::vec3(1.0, 0.0, 0.0));
-			model = glm::rotate(model, angle_z, glm::vec3(0.0, 0.0, 1.0));
-			phong_prog.set("model", model);
+			phong_prog.set("model", object_model);
 
-			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * model)));
+			glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(view * object_model)));
 			phong_prog.set("normal_matrix", normal_matrix);
 
-			object->draw(phong_prog);
+			// the object is centered on the origin.
+			float distance = glm::length(camera.get_pos()) / scale;
+			object->draw(phong_prog, object->select_lod(distance, camera.get_fov(), static_cast<float>(SCREEN_HEIGHT)));
 		}
 
-		// draw lamps
-		lamp_prog.use();
+		// draw lamps, all in one draw call
+		lamp_instances.clear();
 		for (const auto& pt_light : point_lights) {
 			glm::mat4 model{1.0f};
 			model = glm::translate(model, pt_light->get_pos());
 			model = glm::scale(model, glm::vec3(.2f));
-			lamp_prog.set("MVP", proj * view * model);
-			lamp_prog.set("color", pt_light->get_diffuse());
-
-			lamp_mesh.draw(lamp_prog);
+			lamp_instances.push_back({model, glm::vec4{pt_light->get_diffuse(), 1.f}});
 		}
+		lamp_prog.use();
+		lamp_prog.set("MVP", proj * view);
+		lamp_mesh.draw_instanced(lamp_prog, lamp_instances);
 
 		{ // draw skybox as last
 			skybox_prog.use();
-			glDepthFunc(GL_LEQUAL); // change depth function so depth test passes when values are equal to depth buffer's content
+			ow::gl_state::current().depth_func(GL_LEQUAL); // change depth function so depth test passes when values are equal to depth buffer's content
 			glm::mat4 no_translation_view = glm::mat4(glm::mat3(view)); // remove translation from the view matrix
 			skybox_prog.set("VP", proj * no_translation_view);
 			skybox_cube->draw(skybox_prog);
-			glDepthFunc(GL_LESS); // set back to default
+			ow::gl_state::current().depth_func(GL_LESS); // set back to default
 		}
 
 		// imgui window
 		int old_number_of_faces = number_of_faces;
-		imgui_config_window(&number_of_faces, &angle_x, &angle_z, &scale, &lamp_colors, &spotlight_color);
+		bool colors_changed = imgui_config_window(&number_of_faces, &angle_x, &angle_z, &scale, &lamp_colors,
+												  &spotlight_color);
 
 		window.render();
 
@@ -243,15 +298,19 @@ int main() {
 			object = std::make_unique<parametrical_object>(number_of_faces);
 			object->add_texture(white_diffuse);
 			object->add_texture(white_spec);
+			object->generate_lods();
+			object->build_bvh();
 		}
 
-		// light colors
-		for (size_t i = 0; i < lamp_colors.size(); ++i) {
-			point_lights[i]->set_diffuse(lamp_colors[i]);
-			point_lights[i]->set_specular(lamp_colors[i]);
+		// light colors, only uploaded by the next frame when they changed
+		if (colors_changed) {
+			for (size_t i = 0; i < lamp_colors.size(); ++i) {
+				point_lights[i]->set_diffuse(lamp_colors[i]);
+				point_lights[i]->set_specular(lamp_colors[i]);
+			}
+			spotlight->set_diffuse(spotlight_color);
+			spotlight->set_specular(spotlight_color);
 		}
-		spotlight->set_diffuse(spotlight_color);
-		spotlight->set_specular(spotlight_color);
 	}
 
 	return EXIT_SUCCESS;
@@ -288,7 +347,7 @@ void process_input(gui::window& window, float dt) {
 void framebuffer_size_callback(GLFWwindow*, int width, int height) {
 	// make sure the viewport matches the new window dimensions; note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	ow::gl_state::current().viewport(0, 0, width, height);
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -314,3 +373,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow*, double, double yoffset) {
 	camera.process_mouse_scroll(static_cast<float>(yoffset));
 }
+
+void mouse_button_callback(GLFWwindow*, int button, int action, int) {
+	if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+		pick_requested = true;
+	}
+}
@@ -5,6 +5,7 @@
 
 #include <glm/glm.hpp>
 
+#include <ow/mesh_optimizer.hpp>
 #include <ow/vertex.hpp>
 
 using namespace std;
@@ -72,5 +73,17 @@ inline std::vector<unsigned int> generate_indices(unsigned int n) {
 	return std::move(indices);
 }
 
-parametrical_object::parametrical_object(unsigned int n) noexcept
-	: mesh(generate_vertices(n), generate_indices(n)) {}
+inline std::pair<std::vector<ow::vertex>, std::vector<unsigned int>> generate_geometry(unsigned int n, bool weld) {
+	auto vertices = generate_vertices(n);
+	auto indices = generate_indices(n);
+	if (weld) {
+		ow::weld_vertices(&vertices, &indices);
+	}
+	return {std::move(vertices), std::move(indices)};
+}
+
+parametrical_object::parametrical_object(unsigned int n, bool weld) noexcept
+	: parametrical_object(generate_geometry(n, weld)) {}
+
+parametrical_object::parametrical_object(geometry geom) noexcept
+	: mesh(std::move(geom.first), std::move(geom.second), ow::vertex_packing::packed) {}
@@ -1,8 +1,18 @@
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include <ow/mesh.hpp>
 
 class parametrical_object : public ow::mesh {
 public:
-	explicit parametrical_object(unsigned int n) noexcept;
+	// faces are generated separately: welding shares the vertices they have in common.
+	// Vertices are packed on the GPU (see ow::packed_vertex).
+	explicit parametrical_object(unsigned int n, bool weld = true) noexcept;
+
+private:
+	using geometry = std::pair<std::vector<ow::vertex>, std::vector<unsigned int>>;
+
+	explicit parametrical_object(geometry geom) noexcept;
 };
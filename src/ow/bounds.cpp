@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cmath>
+
+#include <ow/bounds.hpp>
+
+ow::aabb ow::compute_aabb(const vertex* vertices, std::size_t count) {
+	if (count == 0) {
+		return {glm::vec3{0.f}, glm::vec3{0.f}};
+	}
+
+	aabb box{vertices[0].position, vertices[0].position};
+	for (const vertex* v = vertices; v != vertices + count; ++v) {
+		box.min = glm::min(box.min, v->position);
+		box.max = glm::max(box.max, v->position);
+	}
+	return box;
+}
+
+ow::aabb ow::compute_aabb(const std::vector<vertex>& vertices) {
+	return compute_aabb(vertices.data(), vertices.size());
+}
+
+ow::bounding_sphere ow::compute_bounding_sphere(const vertex* vertices, std::size_t count) {
+	if (count == 0) {
+		return {glm::vec3{0.f}, 0.f};
+	}
+	const vertex* end = vertices + count;
+
+	// start from two far apart points...
+	auto farthest_from = [vertices, end] (glm::vec3 point) {
+		float best_distance = -1.f;
+		glm::vec3 best = point;
+		for (const vertex* v = vertices; v != end; ++v) {
+			float distance = glm::distance(point, v->position);
+			if (distance > best_distance) {
+				best_distance = distance;
+				best = v->position;
+			}
+		}
+		return best;
+	};
+	glm::vec3 a = farthest_from(vertices[0].position);
+	glm::vec3 b = farthest_from(a);
+
+	bounding_sphere sphere{(a + b) * 0.5f, glm::distance(a, b) * 0.5f};
+
+	// ...then grow the sphere to include the points left outside.
+	for (const vertex* v = vertices; v != end; ++v) {
+		float distance = glm::distance(sphere.center, v->position);
+		if (distance > sphere.radius) {
+			float radius = (sphere.radius + distance) * 0.5f;
+			sphere.center += (v->position - sphere.center) * ((radius - sphere.radius) / distance);
+			sphere.radius = radius;
+		}
+	}
+
+	// the sphere around the box is sometimes tighter.
+	aabb box = compute_aabb(vertices, count);
+	float box_radius = glm::length(box.extent()) * 0.5f;
+	if (box_radius < sphere.radius) {
+		sphere = {box.center(), box_radius};
+	}
+	return sphere;
+}
+
+ow::bounding_sphere ow::compute_bounding_sphere(const std::vector<vertex>& vertices) {
+	return compute_bounding_sphere(vertices.data(), vertices.size());
+}
+
+ow::aabb ow::transform(const aabb& box, const glm::mat4& matrix) {
+	glm::vec3 translation{matrix[3]};
+	aabb result{translation, translation};
+	for (int col = 0; col < 3; ++col) {
+		for (int row = 0; row < 3; ++row) {
+			float a = matrix[col][row] * box.min[col];
+			float b = matrix[col][row] * box.max[col];
+			result.min[row] += std::min(a, b);
+			result.max[row] += std::max(a, b);
+		}
+	}
+	return result;
+}
+
+ow::bounding_sphere ow::transform(const bounding_sphere& sphere, const glm::mat4& matrix) {
+	float scale = std::max({
+		glm::length(glm::vec3{matrix[0]}),
+		glm::length(glm::vec3{matrix[1]}),
+		glm::length(glm::vec3{matrix[2]})
+	});
+	return {glm::vec3{matrix * glm::vec4{sphere.center, 1.f}}, sphere.radius * scale};
+}
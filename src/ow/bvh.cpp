@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include <ow/bvh.hpp>
+
+namespace {
+	constexpr std::size_t SAH_BINS = 16;
+	constexpr std::uint32_t MAX_LEAF_PRIMITIVES = 8;
+	constexpr std::uint32_t MIN_LEAF_PRIMITIVES = 2;
+	constexpr float TRAVERSAL_COST = 1.f; // relative to the cost of testing a primitive
+
+	// bound of the rounding error of the slab distances (gamma(3) of Pharr et al., "Physically
+	// Based Rendering"): exits are pushed back by it so that hits on a face are never lost.
+	constexpr float SLAB_EPSILON = std::numeric_limits<float>::epsilon() * 0.5f;
+	constexpr float SLAB_EXIT_SCALE = 1.f + 2.f * (3.f * SLAB_EPSILON) / (1.f - 3.f * SLAB_EPSILON);
+
+	ow::aabb empty_box() {
+		constexpr float inf = std::numeric_limits<float>::infinity();
+		return {glm::vec3{inf}, glm::vec3{-inf}};
+	}
+
+	void grow(ow::aabb* box, const ow::aabb& other) {
+		box->min = glm::min(box->min, other.min);
+		box->max = glm::max(box->max, other.max);
+	}
+
+	void grow(ow::aabb* box, glm::vec3 point) {
+		box->min = glm::min(box->min, point);
+		box->max = glm::max(box->max, point);
+	}
+
+	float half_area(const ow::aabb& box) {
+		glm::vec3 e = box.extent();
+		return box.min.x > box.max.x ? 0.f : e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+}
+
+ow::ray ow::ray_through_cursor(const glm::mat4& proj, const glm::mat4& view, glm::vec2 cursor, glm::vec2 viewport_size) {
+	glm::vec2 ndc{2.f * cursor.x / viewport_size.x - 1.f, 1.f - 2.f * cursor.y / viewport_size.y};
+	glm::mat4 inverse = glm::inverse(proj * view);
+
+	glm::vec4 near_point = inverse * glm::vec4{ndc.x, ndc.y, -1.f, 1.f};
+	glm::vec4 far_point = inverse * glm::vec4{ndc.x, ndc.y, 1.f, 1.f};
+	glm::vec3 origin = glm::vec3{near_point} / near_point.w;
+	return {origin, glm::normalize(glm::vec3{far_point} / far_point.w - origin)};
+}
+
+ow::ray ow::transform(const ray& r, const glm::mat4& matrix) {
+	return {glm::vec3{matrix * glm::vec4{r.origin, 1.f}}, glm::vec3{matrix * glm::vec4{r.direction, 0.f}}};
+}
+
+float ow::intersect(const ray& r, const aabb& box, float max_distance) {
+	// slabs method, a zero direction component gives infinities which compare correctly.
+	float entry = 0.f;
+	float exit = max_distance;
+	for (int axis = 0; axis < 3; ++axis) {
+		float inverse = 1.f / r.direction[axis];
+		float t0 = (box.min[axis] - r.origin[axis]) * inverse;
+		float t1 = (box.max[axis] - r.origin[axis]) * inverse;
+		if (inverse < 0.f) {
+			std::swap(t0, t1);
+		}
+		t1 *= SLAB_EXIT_SCALE;
+		// written so that NaNs (origin on a slab with a zero direction) keep the bounds.
+		entry = t0 > entry ? t0 : entry;
+		exit = t1 < exit ? t1 : exit;
+	}
+	return entry <= exit ? entry : NO_HIT;
+}
+
+void ow::bvh::build(const std::vector<aabb>& primitive_bounds, std::vector<std::uint32_t> primitives) {
+	m_primitives = std::move(primitives);
+	m_nodes.clear();
+	if (m_primitives.empty()) {
+		return;
+	}
+
+	std::vector<glm::vec3> centroids(primitive_bounds.size());
+	for (std::uint32_t primitive : m_primitives) {
+		centroids[primitive] = primitive_bounds[primitive].center();
+	}
+
+	m_nodes.reserve(2 * m_primitives.size() / MIN_LEAF_PRIMITIVES + 1);
+	m_nodes.push_back({});
+	_build_node(0, 0, static_cast<std::uint32_t>(m_primitives.size()), primitive_bounds, centroids, 1);
+}
+
+void ow::bvh::_build_node(std::uint32_t index, std::uint32_t begin, std::uint32_t end, const std::vector<aabb>& primitive_bounds,
+						  const std::vector<glm::vec3>& centroids, std::size_t depth) {
+	aabb bounds = empty_box();
+	aabb centroid_bounds = empty_box();
+	for (std::uint32_t i = begin; i < end; ++i) {
+		grow(&bounds, primitive_bounds[m_primitives[i]]);
+		grow(&centroid_bounds, centroids[m_primitives[i]]);
+	}
+	m_nodes[index] = {bounds, begin, end - begin};
+
+	std::uint32_t count = end - begin;
+	// the traversal stacks hold at most one entry per level.
+	if (count <= MIN_LEAF_PRIMITIVES || depth + 2 >= MAX_DEPTH) {
+		return;
+	}
+
+	glm::vec3 centroid_extent = centroid_bounds.extent();
+	int axis = 0;
+	if (centroid_extent.y > centroid_extent[axis]) axis = 1;
+	if (centroid_extent.z > centroid_extent[axis]) axis = 2;
+
+	std::uint32_t middle = begin;
+	if (centroid_extent[axis] > 0.f) {
+		// binned surface area heuristic along the widest axis of the centroids.
+		float scale = static_cast<float>(SAH_BINS) / centroid_extent[axis];
+		auto bin_of = [&] (std::uint32_t primitive) {
+			float offset = centroids[primitive][axis] - centroid_bounds.min[axis];
+			return std::min(static_cast<std::size_t>(offset * scale), SAH_BINS - 1);
+		};
+
+		std::array<aabb, SAH_BINS> bin_bounds;
+		std::array<std::uint32_t, SAH_BINS> bin_counts{};
+		bin_bounds.fill(empty_box());
+		for (std::uint32_t i = begin; i < end; ++i) {
+			std::size_t bin = bin_of(m_primitives[i]);
+			grow(&bin_bounds[bin], primitive_bounds[m_primitives[i]]);
+			++bin_counts[bin];
+		}
+
+		// cost of splitting after each bin: sweep from the right, then from the left.
+		std::array<float, SAH_BINS - 1> right_costs;
+		aabb right = empty_box();
+		std::uint32_t right_count = 0;
+		for (std::size_t bin = SAH_BINS - 1; bin > 0; --bin) {
+			grow(&right, bin_bounds[bin]);
+			right_count += bin_counts[bin];
+			right_costs[bin - 1] = half_area(right) * static_cast<float>(right_count);
+		}
+
+		std::size_t best_split = 0;
+		float best_cost = std::numeric_limits<float>::infinity();
+		aabb left = empty_box();
+		std::uint32_t left_count = 0;
+		for (std::size_t bin = 0; bin < SAH_BINS - 1; ++bin) {
+			grow(&left, bin_bounds[bin]);
+			left_count += bin_counts[bin];
+			float cost = half_area(left) * static_cast<float>(left_count) + right_costs[bin];
+			if (left_count > 0 && left_count < count && cost < best_cost) {
+				best_cost = cost;
+				best_split = bin;
+			}
+		}
+
+		float leaf_cost = half_area(bounds) * static_cast<float>(count);
+		best_cost = TRAVERSAL_COST * half_area(bounds) + best_cost;
+		if (best_cost >= leaf_cost && count <= MAX_LEAF_PRIMITIVES) {
+			return;
+		}
+
+		middle = static_cast<std::uint32_t>(std::partition(m_primitives.begin() + begin, m_primitives.begin() + end,
+			[&] (std::uint32_t primitive) { return bin_of(primitive) <= best_split; }) - m_primitives.begin());
+	}
+
+	if (middle == begin || middle == end) {
+		if (count <= MAX_LEAF_PRIMITIVES) {
+			return;
+		}
+		// coincident centroids: split in halves.
+		middle = begin + count / 2;
+		std::nth_element(m_primitives.begin() + begin, m_primitives.begin() + middle, m_primitives.begin() + end,
+			[&] (std::uint32_t a, std::uint32_t b) {
+				return centroids[a][axis] < centroids[b][axis];
+			});
+	}
+
+	auto first_child = static_cast<std::uint32_t>(m_nodes.size());
+	m_nodes[index].first = first_child;
+	m_nodes[index].count = 0;
+	m_nodes.push_back({});
+	m_nodes.push_back({});
+	_build_node(first_child, begin, middle, primitive_bounds, centroids, depth + 1);
+	_build_node(first_child + 1, middle, end, primitive_bounds, centroids, depth + 1);
+}
+
+void ow::bvh::refit(const std::vector<aabb>& primitive_bounds) {
+	for (std::size_t i = m_nodes.size(); i-- > 0;) {
+		node& n = m_nodes[i];
+		if (n.count > 0) {
+			n.bounds = empty_box();
+			for (std::uint32_t p = n.first; p < n.first + n.count; ++p) {
+				grow(&n.bounds, primitive_bounds[m_primitives[p]]);
+			}
+		} else {
+			n.bounds = m_nodes[n.first].bounds;
+			grow(&n.bounds, m_nodes[n.first + 1].bounds);
+		}
+	}
+}
+
+std::vector<std::uint32_t> ow::bvh::renumber_primitives() {
+	std::vector<std::uint32_t> previous = std::move(m_primitives);
+	m_primitives.resize(previous.size());
+	std::iota(m_primitives.begin(), m_primitives.end(), 0u);
+	return previous;
+}
+
+ow::scene_bvh::object_id ow::scene_bvh::insert(const aabb& bounds) {
+	object_id object;
+	if (m_free.empty()) {
+		object = static_cast<object_id>(m_bounds.size());
+		m_bounds.push_back(bounds);
+		m_alive.push_back(true);
+	} else {
+		object = m_free.back();
+		m_free.pop_back();
+		m_bounds[object] = bounds;
+		m_alive[object] = true;
+	}
+	m_needs_build = true;
+	return object;
+}
+
+void ow::scene_bvh::remove(object_id object) {
+	m_alive[object] = false;
+	m_free.push_back(object);
+	m_needs_build = true;
+}
+
+void ow::scene_bvh::update(object_id object, const aabb& bounds) {
+	m_bounds[object] = bounds;
+	m_needs_refit = true;
+}
+
+void ow::scene_bvh::commit() {
+	if (m_needs_build) {
+		std::vector<object_id> objects;
+		objects.reserve(size());
+		for (object_id object = 0; object < m_bounds.size(); ++object) {
+			if (m_alive[object]) {
+				objects.push_back(object);
+			}
+		}
+		m_bvh.build(m_bounds, std::move(objects));
+	} else if (m_needs_refit) {
+		m_bvh.refit(m_bounds);
+	}
+	m_needs_build = false;
+	m_needs_refit = false;
+}
+
+void ow::scene_bvh::query(const frustum& view_frustum, std::vector<object_id>* visible) const {
+	m_bvh.query(view_frustum, m_bounds, [visible] (object_id object) {
+		visible->push_back(object);
+	});
+}
+
+ow::triangle_bvh::triangle_bvh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices)
+	: m_bvh()
+	, m_corners()
+	, m_triangle_ids() {
+	std::size_t triangle_count = indices.size() / 3;
+	std::vector<aabb> bounds(triangle_count);
+	std::vector<std::uint32_t> triangles(triangle_count);
+	for (std::size_t t = 0; t < triangle_count; ++t) {
+		bounds[t] = empty_box();
+		for (std::size_t corner = 0; corner < 3; ++corner) {
+			grow(&bounds[t], vertices[indices[3 * t + corner]].position);
+		}
+		triangles[t] = static_cast<std::uint32_t>(t);
+	}
+	m_bvh.build(bounds, std::move(triangles));
+
+	// store the corners in leaf order, the traversal then reads them sequentially.
+	m_triangle_ids = m_bvh.renumber_primitives();
+	m_corners.reserve(3 * triangle_count);
+	for (std::uint32_t t : m_triangle_ids) {
+		for (std::size_t corner = 0; corner < 3; ++corner) {
+			m_corners.push_back(vertices[indices[3 * t + corner]].position);
+		}
+	}
+}
+
+ow::triangle_bvh::hit ow::triangle_bvh::raycast(const ray& r, float max_distance) const {
+	hit result;
+	m_bvh.raycast(r, max_distance, [&] (std::uint32_t triangle, float max) {
+		// Möller-Trumbore, both faces are hit.
+		const glm::vec3* corners = &m_corners[3 * triangle];
+		glm::vec3 edge1 = corners[1] - corners[0];
+		glm::vec3 edge2 = corners[2] - corners[0];
+		glm::vec3 p = glm::cross(r.direction, edge2);
+		float determinant = glm::dot(edge1, p);
+		if (std::abs(determinant) < 1e-12f) {
+			return NO_HIT;
+		}
+
+		float inverse = 1.f / determinant;
+		glm::vec3 s = r.origin - corners[0];
+		float u = glm::dot(s, p) * inverse;
+		if (u < 0.f || u > 1.f) {
+			return NO_HIT;
+		}
+		glm::vec3 q = glm::cross(s, edge1);
+		float v = glm::dot(r.direction, q) * inverse;
+		if (v < 0.f || u + v > 1.f) {
+			return NO_HIT;
+		}
+		float distance = glm::dot(edge2, q) * inverse;
+		if (distance < 0.f || distance >= max) {
+			return NO_HIT;
+		}
+
+		result = {m_triangle_ids[triangle], distance, glm::vec2{u, v}};
+		return distance;
+	});
+	return result;
+}
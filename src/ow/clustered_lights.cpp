@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include <ow/clustered_lights.hpp>
+#include <ow/gl_state.hpp>
+#include <ow/opengl_codes.hpp>
+
+namespace {
+	static_assert(sizeof(ow::cluster_range) == 2 * sizeof(std::uint32_t), "cluster ranges are uploaded as RG32UI");
+
+	constexpr std::array<GLenum, 3> FORMATS = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+
+	// orphans the buffer storage: the driver doesn't wait for the previous frame.
+	template <typename T>
+	void stream(GLuint buffer, const std::vector<T>& data) {
+		ow::gl_state::current().bind_buffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(data.size() * sizeof(T)), data.data(), GL_STREAM_DRAW);
+		ow::check_errors("Failed to upload clustered lights buffer. ");
+	}
+}
+
+ow::clustered_lights::clustered_lights(cluster_grid grid)
+		: m_clusters{grid}, m_bounds(), m_texels(), m_buffers{}, m_textures{}, m_max_texels{0} {}
+
+ow::clustered_lights::~clustered_lights() {
+	auto& state = gl_state::current();
+	for (std::size_t i = 0; i < m_buffers.size(); ++i) {
+		if (m_textures[i] != 0) {
+			state.delete_texture(m_textures[i]);
+		}
+		if (m_buffers[i] != 0) {
+			state.delete_buffer(m_buffers[i]);
+		}
+	}
+	check_errors("error while deleting clustered lights buffers. ");
+}
+
+void ow::clustered_lights::update(const lights_set& lights, const glm::mat4& view, const glm::mat4& proj) {
+	if (m_buffers[0] == 0) {
+		_create();
+	}
+
+	std::size_t max_lights = std::min(light_clusters::MAX_LIGHTS, m_max_texels / LIGHT_TEXELS);
+	pack_light_texels(lights, view, max_lights, &m_texels, &m_bounds);
+
+	m_clusters.set_projection(proj);
+	m_clusters.assign(m_bounds, culling_kernel::automatic, m_max_texels);
+
+	stream(m_buffers[0], m_texels);
+	stream(m_buffers[1], m_clusters.ranges());
+	stream(m_buffers[2], m_clusters.indices());
+
+	auto& state = gl_state::current();
+	state.bind_texture(LIGHTS_UNIT, GL_TEXTURE_BUFFER, m_textures[0]);
+	state.bind_texture(RANGES_UNIT, GL_TEXTURE_BUFFER, m_textures[1]);
+	state.bind_texture(INDICES_UNIT, GL_TEXTURE_BUFFER, m_textures[2]);
+}
+
+void ow::clustered_lights::set_uniforms(const shader_program& prog) const {
+	auto& grid = m_clusters.grid();
+	auto viewport = gl_state::current().viewport();
+
+	prog.set("cluster_lights", static_cast<int>(LIGHTS_UNIT));
+	prog.set("cluster_ranges", static_cast<int>(RANGES_UNIT));
+	prog.set("cluster_indices", static_cast<int>(INDICES_UNIT));
+	prog.set("clusters_x", grid.x);
+	prog.set("clusters_y", grid.y);
+	prog.set("clusters_z", grid.z);
+	prog.set("cluster_tile_size", glm::vec2(static_cast<float>(viewport[2]) / static_cast<float>(grid.x),
+											static_cast<float>(viewport[3]) / static_cast<float>(grid.y)));
+	prog.set("cluster_viewport_origin", glm::vec2(static_cast<float>(viewport[0]), static_cast<float>(viewport[1])));
+	prog.set("cluster_depth_scale", m_clusters.depth_scale());
+	prog.set("cluster_depth_bias", m_clusters.depth_bias());
+}
+
+void ow::clustered_lights::_create() {
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	m_max_texels = static_cast<std::size_t>(std::max(max_texels, 0));
+
+	auto& state = gl_state::current();
+	glGenBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+	glGenTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+	for (std::size_t i = 0; i < m_buffers.size(); ++i) {
+		state.bind_buffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+		state.bind_texture(GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], m_buffers[i]);
+	}
+	check_errors("Failed to create clustered lights buffers. ");
+}
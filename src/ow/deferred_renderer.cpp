@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+
+#include <ow/deferred_renderer.hpp>
+#include <ow/gl_state.hpp>
+#include <ow/light_texels.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	constexpr unsigned int SPHERE_SEGMENTS = 16;
+	constexpr unsigned int SPHERE_RINGS = 8;
+
+	// formats of the G-buffer textures, shininess / 256 goes in the specular alpha.
+	constexpr std::array<GLenum, 4> GBUFFER_FORMATS = {GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_DEPTH24_STENCIL8};
+	constexpr std::array<GLenum, 4> GBUFFER_PIXEL_FORMATS = {GL_RGBA, GL_RGBA, GL_RGBA, GL_DEPTH_STENCIL};
+	constexpr std::array<GLenum, 4> GBUFFER_PIXEL_TYPES = {GL_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE,
+														   GL_UNSIGNED_INT_24_8};
+
+	// UV sphere whose faces are outside the unit sphere, counter clockwise seen from outside.
+	void make_sphere(std::vector<glm::vec3>* vertices, std::vector<GLushort>* indices) {
+		const auto pi = static_cast<float>(M_PI);
+		// the faces are at least cos(pi / segments) * cos(pi / (2 * rings)) from the center.
+		float scale = 1.f / (std::cos(pi / SPHERE_SEGMENTS) * std::cos(pi / (2 * SPHERE_RINGS)));
+
+		vertices->push_back(glm::vec3(0.f, scale, 0.f));
+		for (unsigned int r = 1; r < SPHERE_RINGS; ++r) {
+			float theta = pi * static_cast<float>(r) / SPHERE_RINGS;
+			for (unsigned int s = 0; s < SPHERE_SEGMENTS; ++s) {
+				float phi = 2.f * pi * static_cast<float>(s) / SPHERE_SEGMENTS;
+				vertices->push_back(scale * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta),
+													  std::sin(theta) * std::sin(phi)));
+			}
+		}
+		vertices->push_back(glm::vec3(0.f, -scale, 0.f));
+
+		auto at = [] (unsigned int r, unsigned int s) {
+			return static_cast<GLushort>(1 + (r - 1) * SPHERE_SEGMENTS + s % SPHERE_SEGMENTS);
+		};
+		auto bottom = static_cast<GLushort>(vertices->size() - 1);
+		for (unsigned int s = 0; s < SPHERE_SEGMENTS; ++s) {
+			indices->insert(indices->end(), {0, at(1, s + 1), at(1, s)});
+			indices->insert(indices->end(), {bottom, at(SPHERE_RINGS - 1, s), at(SPHERE_RINGS - 1, s + 1)});
+		}
+		for (unsigned int r = 1; r + 1 < SPHERE_RINGS; ++r) {
+			for (unsigned int s = 0; s < SPHERE_SEGMENTS; ++s) {
+				indices->insert(indices->end(), {at(r, s), at(r, s + 1), at(r + 1, s)});
+				indices->insert(indices->end(), {at(r, s + 1), at(r + 1, s + 1), at(r + 1, s)});
+			}
+		}
+	}
+}
+
+ow::deferred_renderer::deferred_renderer()
+		: m_geometry_prog{
+				{{GL_VERTEX_SHADER, "phong_vertex.glsl"}
+				,{GL_FRAGMENT_SHADER, "gbuffer_frag.glsl"}}}
+		, m_directional_prog{
+				{{GL_VERTEX_SHADER, "fullscreen_vertex.glsl"}
+				,{GL_FRAGMENT_SHADER, "deferred_directional_frag.glsl"}}}
+		, m_volume_prog{
+				{{GL_VERTEX_SHADER, "light_volume_vertex.glsl"}
+				,{GL_FRAGMENT_SHADER, "deferred_light_frag.glsl"}}}
+		, m_gbuffer{0}, m_gbuffer_textures{}, m_lighting{0}, m_lit_color{0}, m_lit_depth{0}, m_width{0}, m_height{0}
+		, m_viewport{}, m_sphere_vertex_array{0}, m_sphere_vertices{0}, m_sphere_indices{0}, m_sphere_index_count{0}
+		, m_empty_vertex_array{0}, m_lights_buffer{0}, m_lights_texture{0}, m_texels(), m_bounds(), m_max_lights{0}
+		, m_light_count{0} {
+	auto& state = gl_state::current();
+
+	std::vector<glm::vec3> vertices;
+	std::vector<GLushort> indices;
+	make_sphere(&vertices, &indices);
+	m_sphere_index_count = static_cast<GLsizei>(indices.size());
+
+	glGenVertexArrays(1, &m_sphere_vertex_array);
+	glGenBuffers(1, &m_sphere_vertices);
+	glGenBuffers(1, &m_sphere_indices);
+	state.bind_vertex_array(m_sphere_vertex_array);
+	state.bind_buffer(GL_ARRAY_BUFFER, m_sphere_vertices);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
+				 GL_STATIC_DRAW);
+	state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_sphere_indices);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(GLushort)), indices.data(),
+				 GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+	check_errors("Failed to set up the light volume mesh. ");
+
+	// core profile draws need a vertex array, even without attributes.
+	glGenVertexArrays(1, &m_empty_vertex_array);
+
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	m_max_lights = static_cast<std::size_t>(std::max(max_texels, 0)) / LIGHT_TEXELS;
+	glGenBuffers(1, &m_lights_buffer);
+	glGenTextures(1, &m_lights_texture);
+	state.bind_buffer(GL_TEXTURE_BUFFER, m_lights_buffer);
+	state.bind_texture(GL_TEXTURE_BUFFER, m_lights_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lights_buffer);
+	check_errors("Failed to create the deferred lights buffer. ");
+
+	const char* gbuffer_names[] = {"gbuffer_normal", "gbuffer_albedo", "gbuffer_specular", "gbuffer_depth"};
+	for (auto* prog : {&m_directional_prog, &m_volume_prog}) {
+		prog->use();
+		for (GLuint i = 0; i < m_gbuffer_textures.size(); ++i) {
+			prog->set(gbuffer_names[i], static_cast<int>(GBUFFER_UNIT + i));
+		}
+	}
+	m_volume_prog.set("lights", static_cast<int>(LIGHTS_UNIT));
+}
+
+ow::deferred_renderer::~deferred_renderer() {
+	auto& state = gl_state::current();
+	_destroy_targets();
+	state.delete_vertex_array(m_sphere_vertex_array);
+	state.delete_vertex_array(m_empty_vertex_array);
+	state.delete_buffer(m_sphere_vertices);
+	state.delete_buffer(m_sphere_indices);
+	state.delete_texture(m_lights_texture);
+	state.delete_buffer(m_lights_buffer);
+	check_errors("error while deleting the deferred renderer. ");
+}
+
+void ow::deferred_renderer::geometry_pass(const glm::mat4& view, const glm::mat4& proj) {
+	auto& state = gl_state::current();
+	m_viewport = state.viewport();
+	if (m_viewport[2] != m_width || m_viewport[3] != m_height) {
+		_resize(m_viewport[2], m_viewport[3]);
+	}
+
+	state.bind_framebuffer(GL_FRAMEBUFFER, m_gbuffer);
+	state.viewport(0, 0, m_width, m_height);
+	state.depth_mask(true);
+	// glClearBuffer leaves the clear values of the caller alone.
+	const GLfloat zero[] = {0.f, 0.f, 0.f, 0.f};
+	for (GLint i = 0; i < 3; ++i) {
+		glClearBufferfv(GL_COLOR, i, zero);
+	}
+	glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.f, 0);
+	check_errors("Failed to clear the G-buffer. ");
+
+	m_geometry_prog.use();
+	m_geometry_prog.set("view", view);
+	m_geometry_prog.set("proj", proj);
+}
+
+void ow::deferred_renderer::lighting_pass(const lights_set& lights, const glm::mat4& view, const glm::mat4& proj) {
+	auto& state = gl_state::current();
+
+	// the lit image is tested against a copy of the depth, the G-buffer one is sampled.
+	state.bind_framebuffer(GL_READ_FRAMEBUFFER, m_gbuffer);
+	state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, m_lighting);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	state.bind_framebuffer(GL_FRAMEBUFFER, m_lighting);
+	const GLfloat zero[] = {0.f, 0.f, 0.f, 0.f};
+	glClearBufferfv(GL_COLOR, 0, zero);
+	check_errors("Failed to prepare the lighting pass. ");
+
+	for (GLuint i = 0; i < m_gbuffer_textures.size(); ++i) {
+		state.bind_texture(GBUFFER_UNIT + i, GL_TEXTURE_2D, m_gbuffer_textures[i]);
+	}
+
+	bool depth_test = state.is_enabled(GL_DEPTH_TEST);
+	bool blend = state.is_enabled(GL_BLEND);
+	bool cull = state.is_enabled(GL_CULL_FACE);
+	auto blend_state = state.blend();
+	GLenum depth_func = state.depth_func();
+	GLenum cull_face = state.cull_face();
+	bool depth_mask = state.depth_mask();
+	state.set_enabled(GL_BLEND, true);
+	state.blend_func(GL_ONE, GL_ONE);
+	state.depth_mask(false);
+
+	glm::vec2 size{static_cast<float>(m_width), static_cast<float>(m_height)};
+	glm::mat4 inv_proj = glm::inverse(proj);
+
+	// directional lights, on every pixel
+	state.set_enabled(GL_DEPTH_TEST, false);
+	m_directional_prog.use();
+	m_directional_prog.set("inv_proj", inv_proj);
+	m_directional_prog.set("gbuffer_size", size);
+	state.bind_vertex_array(m_empty_vertex_array);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	check_errors("Failed to draw the directional lights. ");
+
+	// point lights and spotlights: the back faces of a sphere with scene geometry in front
+	// of them. Depth clamping keeps the faces past the far plane.
+	m_light_count = pack_light_texels(lights, view, m_max_lights, &m_texels, &m_bounds);
+	// a light which is never attenuated reaches the far corners of the frustum.
+	float far_plane = proj[3][2] / (proj[2][2] + 1.f);
+	float far_corner = far_plane * std::sqrt(1.f + 1.f / (proj[0][0] * proj[0][0]) + 1.f / (proj[1][1] * proj[1][1]));
+	for (std::size_t i = 0; i < m_light_count; ++i) {
+		auto& sphere = m_texels[i * LIGHT_TEXELS + LIGHT_TEXELS - 1];
+		sphere.w = std::min(sphere.w, glm::length(glm::vec3(sphere)) + far_corner);
+	}
+
+	if (m_light_count > 0) {
+		state.bind_buffer(GL_TEXTURE_BUFFER, m_lights_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_texels.size() * sizeof(glm::vec4)), m_texels.data(),
+					 GL_STREAM_DRAW);
+		state.bind_texture(LIGHTS_UNIT, GL_TEXTURE_BUFFER, m_lights_texture);
+
+		state.set_enabled(GL_DEPTH_TEST, true);
+		state.depth_func(GL_GEQUAL);
+		state.set_enabled(GL_CULL_FACE, true);
+		state.cull_face(GL_FRONT);
+		state.set_enabled(GL_DEPTH_CLAMP, true);
+		m_volume_prog.use();
+		m_volume_prog.set("proj", proj);
+		m_volume_prog.set("inv_proj", inv_proj);
+		m_volume_prog.set("gbuffer_size", size);
+		state.bind_vertex_array(m_sphere_vertex_array);
+		glDrawElementsInstanced(GL_TRIANGLES, m_sphere_index_count, GL_UNSIGNED_SHORT, nullptr,
+								static_cast<GLsizei>(m_light_count));
+		check_errors("Failed to draw the light volumes. ");
+
+		state.set_enabled(GL_DEPTH_CLAMP, false);
+	}
+
+	// the caller's state, whatever it was.
+	state.set_enabled(GL_CULL_FACE, cull);
+	state.cull_face(cull_face);
+	state.set_enabled(GL_DEPTH_TEST, depth_test);
+	state.depth_func(depth_func);
+	state.depth_mask(depth_mask);
+	state.blend_func(blend_state.src, blend_state.dst);
+	state.set_enabled(GL_BLEND, blend);
+}
+
+void ow::deferred_renderer::forward_pass() {
+	gl_state::current().bind_framebuffer(GL_FRAMEBUFFER, m_lighting);
+}
+
+void ow::deferred_renderer::present() {
+	auto& state = gl_state::current();
+	state.bind_framebuffer(GL_READ_FRAMEBUFFER, m_lighting);
+	state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, m_width, m_height, m_viewport[0], m_viewport[1], m_viewport[0] + m_viewport[2],
+					  m_viewport[1] + m_viewport[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+	state.viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+	check_errors("Failed to present the lit image. ");
+}
+
+void ow::deferred_renderer::_resize(GLsizei width, GLsizei height) {
+	auto& state = gl_state::current();
+	_destroy_targets();
+	m_width = width;
+	m_height = height;
+
+	glGenFramebuffers(1, &m_gbuffer);
+	state.bind_framebuffer(GL_FRAMEBUFFER, m_gbuffer);
+	glGenTextures(static_cast<GLsizei>(m_gbuffer_textures.size()), m_gbuffer_textures.data());
+	for (std::size_t i = 0; i < m_gbuffer_textures.size(); ++i) {
+		state.bind_texture(GL_TEXTURE_2D, m_gbuffer_textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GBUFFER_FORMATS[i]), width, height, 0, GBUFFER_PIXEL_FORMATS[i],
+					 GBUFFER_PIXEL_TYPES[i], nullptr);
+		// read with texelFetch-like coordinates: no filtering, no mipmaps.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		GLenum attachment = i + 1 < m_gbuffer_textures.size() ? GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i)
+				: GL_DEPTH_STENCIL_ATTACHMENT;
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_gbuffer_textures[i], 0);
+	}
+	const GLenum gbuffer_targets[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+	glDrawBuffers(3, gbuffer_targets);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		logger << "deferred_renderer: incomplete G-buffer." << std::endl;
+	}
+
+	glGenFramebuffers(1, &m_lighting);
+	state.bind_framebuffer(GL_FRAMEBUFFER, m_lighting);
+	glGenRenderbuffers(1, &m_lit_color);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_lit_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_lit_color);
+	glGenRenderbuffers(1, &m_lit_depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_lit_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_lit_depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		logger << "deferred_renderer: incomplete lighting framebuffer." << std::endl;
+	}
+	check_errors("Failed to allocate the deferred render targets. ");
+}
+
+void ow::deferred_renderer::_destroy_targets() {
+	auto& state = gl_state::current();
+	if (m_gbuffer != 0) {
+		state.delete_framebuffer(m_gbuffer);
+		for (auto texture : m_gbuffer_textures) {
+			state.delete_texture(texture);
+		}
+		state.delete_framebuffer(m_lighting);
+		glDeleteRenderbuffers(1, &m_lit_color);
+		glDeleteRenderbuffers(1, &m_lit_depth);
+		m_gbuffer = 0;
+		m_gbuffer_textures = {};
+		m_lighting = 0;
+		m_lit_color = 0;
+		m_lit_depth = 0;
+	}
+}
@@ -0,0 +1,176 @@
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OW_CULLING_X86
+#include <immintrin.h>
+#endif
+
+#include <ow/frustum.hpp>
+
+namespace {
+	// visibility of spheres [begin, end), returns the number of visible ones.
+	std::size_t cull_scalar(const std::array<glm::vec4, 6>& planes, const ow::sphere_batch& spheres,
+							std::size_t begin, std::size_t end, unsigned char* visibility) {
+		std::size_t visible = 0;
+		for (std::size_t i = begin; i < end; ++i) {
+			bool inside = true;
+			for (auto& plane : planes) {
+				float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+				inside &= distance >= -spheres.radius[i];
+			}
+			visibility[i] = inside ? 1 : 0;
+			visible += inside ? 1 : 0;
+		}
+		return visible;
+	}
+
+#ifdef OW_CULLING_X86
+	__attribute__((target("sse2")))
+	std::size_t cull_sse(const std::array<glm::vec4, 6>& planes, const ow::sphere_batch& spheres, std::size_t count,
+						 unsigned char* visibility) {
+		std::size_t visible = 0;
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 x = _mm_loadu_ps(spheres.x.data() + i);
+			__m128 y = _mm_loadu_ps(spheres.y.data() + i);
+			__m128 z = _mm_loadu_ps(spheres.z.data() + i);
+			__m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + i));
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (auto& plane : planes) {
+				__m128 distance = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+						_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (int k = 0; k < 4; ++k) {
+				visibility[i + static_cast<std::size_t>(k)] = static_cast<unsigned char>((mask >> k) & 1);
+			}
+			visible += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned int>(mask)));
+		}
+		return visible + cull_scalar(planes, spheres, i, count, visibility);
+	}
+
+	__attribute__((target("avx2")))
+	std::size_t cull_avx2(const std::array<glm::vec4, 6>& planes, const ow::sphere_batch& spheres, std::size_t count,
+						  unsigned char* visibility) {
+		std::size_t visible = 0;
+		std::size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 x = _mm256_loadu_ps(spheres.x.data() + i);
+			__m256 y = _mm256_loadu_ps(spheres.y.data() + i);
+			__m256 z = _mm256_loadu_ps(spheres.z.data() + i);
+			__m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius.data() + i));
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (auto& plane : planes) {
+				__m256 distance = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+						_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, neg_radius, _CMP_GE_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (int k = 0; k < 8; ++k) {
+				visibility[i + static_cast<std::size_t>(k)] = static_cast<unsigned char>((mask >> k) & 1);
+			}
+			visible += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned int>(mask)));
+		}
+		return visible + cull_scalar(planes, spheres, i, count, visibility);
+	}
+#endif
+}
+
+ow::frustum::frustum(const glm::mat4& proj, const glm::mat4& view) : m_planes() {
+	glm::mat4 m = proj * view;
+
+	// rows of the matrix (glm is column major).
+	auto row = [&m] (int r) { return glm::vec4{m[0][r], m[1][r], m[2][r], m[3][r]}; };
+	m_planes[0] = row(3) + row(0); // left
+	m_planes[1] = row(3) - row(0); // right
+	m_planes[2] = row(3) + row(1); // bottom
+	m_planes[3] = row(3) - row(1); // top
+	m_planes[4] = row(3) + row(2); // near
+	m_planes[5] = row(3) - row(2); // far
+
+	for (auto& plane : m_planes) {
+		plane /= glm::length(glm::vec3{plane});
+	}
+}
+
+bool ow::frustum::intersects(const bounding_sphere& sphere) const {
+	for (auto& plane : m_planes) {
+		if (glm::dot(glm::vec3{plane}, sphere.center) + plane.w < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ow::frustum::intersects(const aabb& box) const {
+	for (auto& plane : m_planes) {
+		// corner the farthest along the plane normal.
+		glm::vec3 positive{
+			plane.x >= 0.f ? box.max.x : box.min.x,
+			plane.y >= 0.f ? box.max.y : box.min.y,
+			plane.z >= 0.f ? box.max.z : box.min.z
+		};
+		if (glm::dot(glm::vec3{plane}, positive) + plane.w < 0.f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ow::frustum::contains(const aabb& box) const {
+	for (auto& plane : m_planes) {
+		// corner the farthest against the plane normal.
+		glm::vec3 negative{
+			plane.x >= 0.f ? box.min.x : box.max.x,
+			plane.y >= 0.f ? box.min.y : box.max.y,
+			plane.z >= 0.f ? box.min.z : box.max.z
+		};
+		if (glm::dot(glm::vec3{plane}, negative) + plane.w < 0.f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+ow::culling_kernel ow::best_culling_kernel() noexcept {
+#ifdef OW_CULLING_X86
+	static const culling_kernel best = __builtin_cpu_supports("avx2") ? culling_kernel::avx2
+			: __builtin_cpu_supports("sse2") ? culling_kernel::sse
+			: culling_kernel::scalar;
+	return best;
+#else
+	return culling_kernel::scalar;
+#endif
+}
+
+ow::culling_stats ow::cull_spheres(const frustum& view_frustum, const sphere_batch& spheres,
+								   std::vector<unsigned char>* visibility, culling_kernel kernel) {
+	const std::size_t count = spheres.size();
+	assert(spheres.y.size() == count && spheres.z.size() == count && spheres.radius.size() == count);
+	visibility->resize(count);
+
+	culling_kernel best = best_culling_kernel();
+	if (kernel == culling_kernel::automatic || kernel > best) {
+		kernel = best;
+	}
+
+	std::size_t visible = 0;
+#ifdef OW_CULLING_X86
+	if (kernel == culling_kernel::avx2) {
+		visible = cull_avx2(view_frustum.planes(), spheres, count, visibility->data());
+	} else if (kernel == culling_kernel::sse) {
+		visible = cull_sse(view_frustum.planes(), spheres, count, visibility->data());
+	} else
+#endif
+	{
+		visible = cull_scalar(view_frustum.planes(), spheres, 0, count, visibility->data());
+	}
+	return {visible, count - visible};
+}
@@ -0,0 +1,93 @@
+#include <ow/gl_extensions.hpp>
+
+namespace {
+	ow::gl_extensions extensions{};
+
+	template <typename Proc>
+	Proc load_proc(GLADloadproc load, const char* name) {
+		return reinterpret_cast<Proc>(load(name));
+	}
+}
+
+const ow::gl_extensions& ow::gl_extensions::current() noexcept {
+	return extensions;
+}
+
+bool ow::load_gl_extensions(GLADloadproc load) {
+	extensions = gl_extensions{};
+	if (glGetIntegerv == nullptr || glGetString(GL_VERSION) == nullptr) {
+		return false;
+	}
+
+	glGetIntegerv(GL_MAJOR_VERSION, &extensions.major_version);
+	glGetIntegerv(GL_MINOR_VERSION, &extensions.minor_version);
+
+	// the ARB extension names its functions like the core ones.
+	if (extensions.version(4, 1) || has_gl_extension("GL_ARB_get_program_binary")) {
+		extensions.GetProgramBinary = load_proc<get_program_binary_proc>(load, "glGetProgramBinary");
+		extensions.ProgramBinary = load_proc<program_binary_proc>(load, "glProgramBinary");
+		extensions.ProgramParameteri = load_proc<program_parameteri_proc>(load, "glProgramParameteri");
+
+		// drivers may support the extension without any format, MESA did for a while.
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		extensions.program_binary = formats > 0 && extensions.GetProgramBinary != nullptr
+				&& extensions.ProgramBinary != nullptr && extensions.ProgramParameteri != nullptr;
+	}
+
+	if (extensions.version(4, 1) || has_gl_extension("GL_ARB_separate_shader_objects")) {
+		auto& e = extensions;
+		e.GenProgramPipelines = load_proc<gen_program_pipelines_proc>(load, "glGenProgramPipelines");
+		e.DeleteProgramPipelines = load_proc<delete_program_pipelines_proc>(load, "glDeleteProgramPipelines");
+		e.BindProgramPipeline = load_proc<bind_program_pipeline_proc>(load, "glBindProgramPipeline");
+		e.UseProgramStages = load_proc<use_program_stages_proc>(load, "glUseProgramStages");
+		e.ProgramUniform1i = load_proc<program_uniform_1i_proc>(load, "glProgramUniform1i");
+		e.ProgramUniform1ui = load_proc<program_uniform_1ui_proc>(load, "glProgramUniform1ui");
+		e.ProgramUniform1f = load_proc<program_uniform_1f_proc>(load, "glProgramUniform1f");
+		e.ProgramUniform2f = load_proc<program_uniform_2f_proc>(load, "glProgramUniform2f");
+		e.ProgramUniform3f = load_proc<program_uniform_3f_proc>(load, "glProgramUniform3f");
+		e.ProgramUniform4f = load_proc<program_uniform_4f_proc>(load, "glProgramUniform4f");
+		e.ProgramUniform2fv = load_proc<program_uniform_fv_proc>(load, "glProgramUniform2fv");
+		e.ProgramUniform3fv = load_proc<program_uniform_fv_proc>(load, "glProgramUniform3fv");
+		e.ProgramUniform4fv = load_proc<program_uniform_fv_proc>(load, "glProgramUniform4fv");
+		e.ProgramUniformMatrix2fv = load_proc<program_uniform_matrix_fv_proc>(load, "glProgramUniformMatrix2fv");
+		e.ProgramUniformMatrix3fv = load_proc<program_uniform_matrix_fv_proc>(load, "glProgramUniformMatrix3fv");
+		e.ProgramUniformMatrix4fv = load_proc<program_uniform_matrix_fv_proc>(load, "glProgramUniformMatrix4fv");
+		if (e.ProgramParameteri == nullptr) {
+			e.ProgramParameteri = load_proc<program_parameteri_proc>(load, "glProgramParameteri");
+		}
+
+		e.separate_shader_objects = e.GenProgramPipelines != nullptr && e.DeleteProgramPipelines != nullptr
+				&& e.BindProgramPipeline != nullptr && e.UseProgramStages != nullptr && e.ProgramParameteri != nullptr
+				&& e.ProgramUniform1i != nullptr && e.ProgramUniform1ui != nullptr && e.ProgramUniform1f != nullptr
+				&& e.ProgramUniform2f != nullptr && e.ProgramUniform3f != nullptr && e.ProgramUniform4f != nullptr
+				&& e.ProgramUniform2fv != nullptr && e.ProgramUniform3fv != nullptr && e.ProgramUniform4fv != nullptr
+				&& e.ProgramUniformMatrix2fv != nullptr && e.ProgramUniformMatrix3fv != nullptr
+				&& e.ProgramUniformMatrix4fv != nullptr;
+	}
+
+	// the KHR and ARB extensions only differ by their suffixes.
+	if (has_gl_extension("GL_KHR_parallel_shader_compile")) {
+		extensions.MaxShaderCompilerThreads = load_proc<max_shader_compiler_threads_proc>(load, "glMaxShaderCompilerThreadsKHR");
+	} else if (has_gl_extension("GL_ARB_parallel_shader_compile")) {
+		extensions.MaxShaderCompilerThreads = load_proc<max_shader_compiler_threads_proc>(load, "glMaxShaderCompilerThreadsARB");
+	}
+	extensions.parallel_shader_compile = extensions.MaxShaderCompilerThreads != nullptr;
+	if (extensions.parallel_shader_compile) {
+		// as many threads as the driver wants, some default to none.
+		extensions.MaxShaderCompilerThreads(0xFFFFFFFF);
+	}
+	return true;
+}
+
+bool ow::has_gl_extension(std::string_view name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		if (extension != nullptr && name == extension) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,455 @@
+#include <string>
+
+#include <ow/gl_extensions.hpp>
+#include <ow/gl_state.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	GLuint get_uint(GLenum name) {
+		GLint value = 0;
+		glGetIntegerv(name, &value);
+		return static_cast<GLuint>(value);
+	}
+
+	std::array<GLint, 4> get_rect(GLenum name) {
+		std::array<GLint, 4> rect{};
+		glGetIntegerv(name, rect.data());
+		return rect;
+	}
+
+	GLenum buffer_binding_name(GLenum target) {
+		switch (target) {
+		case GL_ARRAY_BUFFER:          return GL_ARRAY_BUFFER_BINDING;
+		case GL_ELEMENT_ARRAY_BUFFER:  return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+		case GL_PIXEL_UNPACK_BUFFER:   return GL_PIXEL_UNPACK_BUFFER_BINDING;
+		case GL_UNIFORM_BUFFER:        return GL_UNIFORM_BUFFER_BINDING;
+		default:                       return target; // copy and texture buffers are queried with the target itself
+		}
+	}
+
+	GLenum texture_binding_name(GLenum target) {
+		switch (target) {
+		case GL_TEXTURE_CUBE_MAP:      return GL_TEXTURE_BINDING_CUBE_MAP;
+		case GL_TEXTURE_BUFFER:        return GL_TEXTURE_BINDING_BUFFER;
+		default:                       return GL_TEXTURE_BINDING_2D;
+		}
+	}
+
+	template <typename T, typename Read>
+	const T& known_or_read(std::optional<T>* known, Read&& read) {
+		if (!*known) {
+			*known = read();
+		}
+		return **known;
+	}
+
+	// logs a difference between the tracker and OpenGL.
+	template <typename T>
+	bool same(const char* what, const std::optional<T>& known, const T& actual) {
+		if (known && *known != actual) {
+			ow::logger << "gl_state: " << what << " is stale.\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+ow::gl_state& ow::gl_state::current() {
+	static gl_state state;
+	return state;
+}
+
+ow::gl_state::gl_state()
+		: m_program(), m_program_pipeline(), m_vertex_array(), m_draw_framebuffer(), m_read_framebuffer(), m_buffers()
+		, m_uniform_bindings(), m_active_texture(), m_textures(), m_capabilities(), m_blend_func(), m_blend_equation()
+		, m_depth_mask(), m_depth_func(), m_cull_face(), m_viewport(), m_scissor()
+		, m_validation{false}, m_stats{} {}
+
+void ow::gl_state::use_program(GLuint program) {
+	if (_change(&m_program, program)) {
+		glUseProgram(program);
+		_changed();
+	}
+}
+
+GLuint ow::gl_state::program() {
+	return known_or_read(&m_program, [] { return get_uint(GL_CURRENT_PROGRAM); });
+}
+
+void ow::gl_state::bind_program_pipeline(GLuint pipeline) {
+	if (_change(&m_program_pipeline, pipeline)) {
+		gl_extensions::current().BindProgramPipeline(pipeline);
+		_changed();
+	}
+}
+
+GLuint ow::gl_state::program_pipeline() {
+	return known_or_read(&m_program_pipeline, [] {
+		return gl_extensions::current().separate_shader_objects ? get_uint(GL_PROGRAM_PIPELINE_BINDING) : 0u;
+	});
+}
+
+void ow::gl_state::bind_vertex_array(GLuint vertex_array) {
+	if (_change(&m_vertex_array, vertex_array)) {
+		glBindVertexArray(vertex_array);
+		m_buffers[_index(GL_ELEMENT_ARRAY_BUFFER, BUFFER_TARGETS.data(), BUFFER_TARGETS.size())].reset();
+		_changed();
+	}
+}
+
+GLuint ow::gl_state::vertex_array() {
+	return known_or_read(&m_vertex_array, [] { return get_uint(GL_VERTEX_ARRAY_BINDING); });
+}
+
+void ow::gl_state::bind_buffer(GLenum target, GLuint buffer) {
+	std::size_t i = _index(target, BUFFER_TARGETS.data(), BUFFER_TARGETS.size());
+	if (i == BUFFER_TARGETS.size()) {
+		++m_stats.issued;
+		glBindBuffer(target, buffer);
+	} else if (_change(&m_buffers[i], buffer)) {
+		glBindBuffer(target, buffer);
+		_changed();
+	}
+}
+
+void ow::gl_state::bind_buffer_base(GLenum target, GLuint index, GLuint buffer) {
+	if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+		++m_stats.issued;
+	} else if (!_change(&m_uniform_bindings[index], buffer)) {
+		return;
+	}
+	glBindBufferBase(target, index, buffer);
+	std::size_t i = _index(target, BUFFER_TARGETS.data(), BUFFER_TARGETS.size());
+	if (i < BUFFER_TARGETS.size()) {
+		m_buffers[i] = buffer;
+	}
+	_changed();
+}
+
+GLuint ow::gl_state::buffer(GLenum target) {
+	std::size_t i = _index(target, BUFFER_TARGETS.data(), BUFFER_TARGETS.size());
+	if (i == BUFFER_TARGETS.size()) {
+		return get_uint(buffer_binding_name(target));
+	}
+	return known_or_read(&m_buffers[i], [target] { return get_uint(buffer_binding_name(target)); });
+}
+
+void ow::gl_state::bind_framebuffer(GLenum target, GLuint framebuffer) {
+	bool draw = target != GL_READ_FRAMEBUFFER;
+	bool read = target != GL_DRAW_FRAMEBUFFER;
+	if ((!draw || m_draw_framebuffer == framebuffer) && (!read || m_read_framebuffer == framebuffer)) {
+		++m_stats.skipped;
+		return;
+	}
+	glBindFramebuffer(target, framebuffer);
+	if (draw) {
+		m_draw_framebuffer = framebuffer;
+	}
+	if (read) {
+		m_read_framebuffer = framebuffer;
+	}
+	++m_stats.issued;
+	_changed();
+}
+
+GLuint ow::gl_state::framebuffer(GLenum target) {
+	if (target == GL_READ_FRAMEBUFFER) {
+		return known_or_read(&m_read_framebuffer, [] { return get_uint(GL_READ_FRAMEBUFFER_BINDING); });
+	}
+	return known_or_read(&m_draw_framebuffer, [] { return get_uint(GL_DRAW_FRAMEBUFFER_BINDING); });
+}
+
+void ow::gl_state::active_texture(GLuint unit) {
+	if (_change(&m_active_texture, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		_changed();
+	}
+}
+
+GLuint ow::gl_state::active_texture() {
+	return known_or_read(&m_active_texture, [] { return get_uint(GL_ACTIVE_TEXTURE) - GL_TEXTURE0; });
+}
+
+void ow::gl_state::bind_texture(GLenum target, GLuint texture) {
+	GLuint unit = active_texture();
+	std::size_t i = _index(target, TEXTURE_TARGETS.data(), TEXTURE_TARGETS.size());
+	if (unit >= MAX_TEXTURE_UNITS || i == TEXTURE_TARGETS.size()) {
+		++m_stats.issued;
+		glBindTexture(target, texture);
+	} else if (_change(&m_textures[unit][i], texture)) {
+		glBindTexture(target, texture);
+		_changed();
+	}
+}
+
+void ow::gl_state::bind_texture(GLuint unit, GLenum target, GLuint texture) {
+	std::size_t i = _index(target, TEXTURE_TARGETS.data(), TEXTURE_TARGETS.size());
+	if (unit < MAX_TEXTURE_UNITS && i < TEXTURE_TARGETS.size() && m_textures[unit][i] == texture) {
+		++m_stats.skipped;
+		return;
+	}
+	active_texture(unit);
+	bind_texture(target, texture);
+}
+
+GLuint ow::gl_state::texture(GLuint unit, GLenum target) {
+	std::size_t i = _index(target, TEXTURE_TARGETS.data(), TEXTURE_TARGETS.size());
+	if (unit >= MAX_TEXTURE_UNITS || i == TEXTURE_TARGETS.size()) {
+		active_texture(unit);
+		return get_uint(texture_binding_name(target));
+	}
+	return known_or_read(&m_textures[unit][i], [this, unit, target] {
+		active_texture(unit);
+		return get_uint(texture_binding_name(target));
+	});
+}
+
+void ow::gl_state::set_enabled(GLenum capability, bool enabled) {
+	std::size_t i = _index(capability, CAPABILITIES.data(), CAPABILITIES.size());
+	if (i == CAPABILITIES.size()) {
+		++m_stats.issued;
+	} else if (!_change(&m_capabilities[i], enabled)) {
+		return;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+	_changed();
+}
+
+bool ow::gl_state::is_enabled(GLenum capability) {
+	std::size_t i = _index(capability, CAPABILITIES.data(), CAPABILITIES.size());
+	if (i == CAPABILITIES.size()) {
+		return glIsEnabled(capability) == GL_TRUE;
+	}
+	return known_or_read(&m_capabilities[i], [capability] { return glIsEnabled(capability) == GL_TRUE; });
+}
+
+void ow::gl_state::blend_func(GLenum src, GLenum dst) {
+	if (_change(&m_blend_func, std::array<GLenum, 2>{src, dst})) {
+		glBlendFunc(src, dst);
+		_changed();
+	}
+}
+
+void ow::gl_state::blend_equation(GLenum equation_rgb, GLenum equation_alpha) {
+	if (_change(&m_blend_equation, std::array<GLenum, 2>{equation_rgb, equation_alpha})) {
+		glBlendEquationSeparate(equation_rgb, equation_alpha);
+		_changed();
+	}
+}
+
+ow::gl_state::blend_state ow::gl_state::blend() {
+	auto& func = known_or_read(&m_blend_func, [] {
+		return std::array<GLenum, 2>{get_uint(GL_BLEND_SRC_RGB), get_uint(GL_BLEND_DST_RGB)};
+	});
+	auto& equation = known_or_read(&m_blend_equation, [] {
+		return std::array<GLenum, 2>{get_uint(GL_BLEND_EQUATION_RGB), get_uint(GL_BLEND_EQUATION_ALPHA)};
+	});
+	return {func[0], func[1], equation[0], equation[1]};
+}
+
+void ow::gl_state::depth_mask(bool write) {
+	if (_change(&m_depth_mask, write)) {
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+		_changed();
+	}
+}
+
+bool ow::gl_state::depth_mask() {
+	return known_or_read(&m_depth_mask, [] {
+		GLboolean write = GL_TRUE;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &write);
+		return write == GL_TRUE;
+	});
+}
+
+void ow::gl_state::depth_func(GLenum func) {
+	if (_change(&m_depth_func, func)) {
+		glDepthFunc(func);
+		_changed();
+	}
+}
+
+GLenum ow::gl_state::depth_func() {
+	return known_or_read(&m_depth_func, [] { return get_uint(GL_DEPTH_FUNC); });
+}
+
+void ow::gl_state::cull_face(GLenum face) {
+	if (_change(&m_cull_face, face)) {
+		glCullFace(face);
+		_changed();
+	}
+}
+
+GLenum ow::gl_state::cull_face() {
+	return known_or_read(&m_cull_face, [] { return get_uint(GL_CULL_FACE_MODE); });
+}
+
+void ow::gl_state::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if (_change(&m_viewport, std::array<GLint, 4>{x, y, width, height})) {
+		glViewport(x, y, width, height);
+		_changed();
+	}
+}
+
+std::array<GLint, 4> ow::gl_state::viewport() {
+	return known_or_read(&m_viewport, [] { return get_rect(GL_VIEWPORT); });
+}
+
+void ow::gl_state::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if (_change(&m_scissor, std::array<GLint, 4>{x, y, width, height})) {
+		glScissor(x, y, width, height);
+		_changed();
+	}
+}
+
+std::array<GLint, 4> ow::gl_state::scissor() {
+	return known_or_read(&m_scissor, [] { return get_rect(GL_SCISSOR_BOX); });
+}
+
+void ow::gl_state::delete_program(GLuint program) {
+	glDeleteProgram(program);
+	// a program in use is only deleted once unused: it stays current.
+}
+
+void ow::gl_state::delete_program_pipeline(GLuint pipeline) {
+	gl_extensions::current().DeleteProgramPipelines(1, &pipeline);
+	if (pipeline != 0 && m_program_pipeline == pipeline) {
+		m_program_pipeline = 0u;
+	}
+}
+
+void ow::gl_state::delete_vertex_array(GLuint vertex_array) {
+	glDeleteVertexArrays(1, &vertex_array);
+	if (vertex_array != 0 && m_vertex_array == vertex_array) {
+		m_vertex_array = 0u;
+		m_buffers[_index(GL_ELEMENT_ARRAY_BUFFER, BUFFER_TARGETS.data(), BUFFER_TARGETS.size())].reset();
+	}
+}
+
+void ow::gl_state::delete_buffer(GLuint buffer) {
+	glDeleteBuffers(1, &buffer);
+	for (auto& bound : m_buffers) {
+		if (buffer != 0 && bound == buffer) {
+			bound = 0u;
+		}
+	}
+	// whether the binding points are reset too depends on the driver.
+	for (auto& bound : m_uniform_bindings) {
+		if (buffer != 0 && bound == buffer) {
+			bound.reset();
+		}
+	}
+}
+
+void ow::gl_state::delete_texture(GLuint texture) {
+	glDeleteTextures(1, &texture);
+	for (auto& unit : m_textures) {
+		for (auto& bound : unit) {
+			if (texture != 0 && bound == texture) {
+				bound = 0u;
+			}
+		}
+	}
+}
+
+void ow::gl_state::delete_framebuffer(GLuint framebuffer) {
+	glDeleteFramebuffers(1, &framebuffer);
+	if (framebuffer != 0 && m_draw_framebuffer == framebuffer) {
+		m_draw_framebuffer = 0u;
+	}
+	if (framebuffer != 0 && m_read_framebuffer == framebuffer) {
+		m_read_framebuffer = 0u;
+	}
+}
+
+void ow::gl_state::invalidate() {
+	m_program.reset();
+	m_program_pipeline.reset();
+	m_vertex_array.reset();
+	m_draw_framebuffer.reset();
+	m_read_framebuffer.reset();
+	m_buffers = {};
+	m_uniform_bindings = {};
+	m_active_texture.reset();
+	m_textures = {};
+	m_capabilities = {};
+	m_blend_func.reset();
+	m_blend_equation.reset();
+	m_depth_mask.reset();
+	m_depth_func.reset();
+	m_cull_face.reset();
+	m_viewport.reset();
+	m_scissor.reset();
+}
+
+bool ow::gl_state::validate() {
+	bool valid = same("program", m_program, get_uint(GL_CURRENT_PROGRAM));
+	if (gl_extensions::current().separate_shader_objects) {
+		valid &= same("program pipeline", m_program_pipeline, get_uint(GL_PROGRAM_PIPELINE_BINDING));
+	}
+	valid &= same("vertex array", m_vertex_array, get_uint(GL_VERTEX_ARRAY_BINDING));
+	valid &= same("draw framebuffer", m_draw_framebuffer, get_uint(GL_DRAW_FRAMEBUFFER_BINDING));
+	valid &= same("read framebuffer", m_read_framebuffer, get_uint(GL_READ_FRAMEBUFFER_BINDING));
+	for (std::size_t i = 0; i < BUFFER_TARGETS.size(); ++i) {
+		valid &= same(("buffer binding " + std::to_string(BUFFER_TARGETS[i])).c_str(), m_buffers[i],
+					  get_uint(buffer_binding_name(BUFFER_TARGETS[i])));
+	}
+	for (GLuint i = 0; i < MAX_UNIFORM_BINDINGS; ++i) {
+		if (m_uniform_bindings[i]) {
+			GLint bound = 0;
+			glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &bound);
+			valid &= same(("uniform buffer binding " + std::to_string(i)).c_str(), m_uniform_bindings[i],
+						  static_cast<GLuint>(bound));
+		}
+	}
+
+	GLuint active = get_uint(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+	valid &= same("active texture", m_active_texture, active);
+	for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+		for (std::size_t i = 0; i < TEXTURE_TARGETS.size(); ++i) {
+			if (m_textures[unit][i]) {
+				glActiveTexture(GL_TEXTURE0 + unit);
+				valid &= same(("texture unit " + std::to_string(unit)).c_str(), m_textures[unit][i],
+							  get_uint(texture_binding_name(TEXTURE_TARGETS[i])));
+			}
+		}
+	}
+	glActiveTexture(GL_TEXTURE0 + active);
+
+	for (std::size_t i = 0; i < CAPABILITIES.size(); ++i) {
+		valid &= same(("capability " + std::to_string(CAPABILITIES[i])).c_str(), m_capabilities[i],
+					  glIsEnabled(CAPABILITIES[i]) == GL_TRUE);
+	}
+	valid &= same("blend function", m_blend_func, std::array<GLenum, 2>{get_uint(GL_BLEND_SRC_RGB), get_uint(GL_BLEND_DST_RGB)});
+	valid &= same("blend equation", m_blend_equation,
+				  std::array<GLenum, 2>{get_uint(GL_BLEND_EQUATION_RGB), get_uint(GL_BLEND_EQUATION_ALPHA)});
+	GLboolean depth_write = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_write);
+	valid &= same("depth mask", m_depth_mask, depth_write == GL_TRUE);
+	valid &= same("depth function", m_depth_func, get_uint(GL_DEPTH_FUNC));
+	valid &= same("cull face", m_cull_face, get_uint(GL_CULL_FACE_MODE));
+	valid &= same("viewport", m_viewport, get_rect(GL_VIEWPORT));
+	valid &= same("scissor", m_scissor, get_rect(GL_SCISSOR_BOX));
+	check_errors("error while validating the GL state. ");
+	return valid;
+}
+
+void ow::gl_state::_changed() {
+	if (m_validation && !validate()) {
+		logger << "gl_state: OpenGL was changed without going through the tracker." << std::endl;
+	}
+}
+
+std::size_t ow::gl_state::_index(GLenum value, const GLenum* values, std::size_t count) {
+	std::size_t i = 0;
+	while (i < count && values[i] != value) {
+		++i;
+	}
+	return i;
+}
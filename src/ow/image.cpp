@@ -0,0 +1,39 @@
+#include <algorithm>
+#include <utility>
+
+#include <stb_image.h>
+
+#include <ow/image.hpp>
+
+ow::image::image(image&& other) noexcept
+		: data{std::exchange(other.data, nullptr)}
+		, width{std::exchange(other.width, 0)}
+		, height{std::exchange(other.height, 0)}
+		, channels{std::exchange(other.channels, 0)} {}
+
+ow::image::~image() {
+	stbi_image_free(data);
+}
+
+ow::image& ow::image::operator=(image&& other) noexcept {
+	std::swap(data, other.data);
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	std::swap(channels, other.channels);
+	return *this;
+}
+
+ow::image ow::image::load(const std::string& filename, bool flip_vertically) {
+	image img;
+	// stbi_set_flip_vertically_on_load is process-wide: rows are flipped here instead.
+	img.data = stbi_load(filename.c_str(), &img.width, &img.height, &img.channels, 0);
+	if (img.data && flip_vertically) {
+		auto row_size = static_cast<std::size_t>(img.width) * static_cast<std::size_t>(img.channels);
+		unsigned char* top = img.data;
+		unsigned char* bottom = img.data + row_size * static_cast<std::size_t>(img.height - 1);
+		for (; top < bottom; top += row_size, bottom -= row_size) {
+			std::swap_ranges(top, top + row_size, bottom);
+		}
+	}
+	return img;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <ow/index_type.hpp>
+
+namespace {
+	template <typename T>
+	void narrow_indices(const std::vector<unsigned int>& indices, unsigned char* out) {
+		for (auto idx : indices) {
+			assert(idx <= std::numeric_limits<T>::max());
+			auto narrowed = static_cast<T>(idx);
+			std::memcpy(out, &narrowed, sizeof(T));
+			out += sizeof(T);
+		}
+	}
+}
+
+ow::index_type ow::index_type_for(std::size_t vertex_count, index_type minimum) noexcept {
+	index_type type = index_type::u32;
+	if (vertex_count <= std::size_t{std::numeric_limits<std::uint8_t>::max()} + 1) {
+		type = index_type::u8;
+	} else if (vertex_count <= std::size_t{std::numeric_limits<std::uint16_t>::max()} + 1) {
+		type = index_type::u16;
+	}
+	return std::max(type, minimum);
+}
+
+std::size_t ow::index_type_size(index_type type) noexcept {
+	switch (type) {
+	case index_type::u8:
+		return sizeof(std::uint8_t);
+	case index_type::u16:
+		return sizeof(std::uint16_t);
+	case index_type::u32:
+	default:
+		return sizeof(std::uint32_t);
+	}
+}
+
+GLenum ow::index_type_to_gl(index_type type) noexcept {
+	switch (type) {
+	case index_type::u8:
+		return GL_UNSIGNED_BYTE;
+	case index_type::u16:
+		return GL_UNSIGNED_SHORT;
+	case index_type::u32:
+	default:
+		return GL_UNSIGNED_INT;
+	}
+}
+
+std::vector<unsigned char> ow::pack_indices(const std::vector<unsigned int>& indices, index_type type) {
+	std::vector<unsigned char> packed(indices.size() * index_type_size(type));
+	switch (type) {
+	case index_type::u8:
+		narrow_indices<std::uint8_t>(indices, packed.data());
+		break;
+	case index_type::u16:
+		narrow_indices<std::uint16_t>(indices, packed.data());
+		break;
+	case index_type::u32:
+		narrow_indices<std::uint32_t>(indices, packed.data());
+		break;
+	default:
+		throw std::invalid_argument("Unknown index type " + std::to_string(static_cast<int>(type)) + '.');
+	}
+	return packed;
+}
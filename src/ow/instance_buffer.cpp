@@ -0,0 +1,49 @@
+#include <utility>
+
+#include <ow/gl_state.hpp>
+#include <ow/instance_buffer.hpp>
+#include <ow/opengl_codes.hpp>
+
+ow::instance_buffer::instance_buffer()
+		: m_buffer{0}, m_size{0}, m_capacity{0} {
+	glGenBuffers(1, &m_buffer);
+	check_errors("error while generating instance buffer. ");
+}
+
+ow::instance_buffer::instance_buffer(instance_buffer&& other) noexcept
+		: m_buffer{std::exchange(other.m_buffer, 0)}
+		, m_size{std::exchange(other.m_size, 0)}
+		, m_capacity{std::exchange(other.m_capacity, 0)} {}
+
+ow::instance_buffer::~instance_buffer() {
+	gl_state::current().delete_buffer(m_buffer);
+	check_errors("error while deleting instance buffer. ");
+}
+
+void ow::instance_buffer::set_data(const std::vector<instance>& instances) {
+	gl_state::current().bind_buffer(GL_ARRAY_BUFFER, m_buffer);
+	check_errors("Failed to bind instance buffer. ");
+
+	auto bytes = static_cast<GLsizeiptr>(instances.size() * sizeof(instance));
+	if (instances.size() > m_capacity) {
+		m_capacity = instances.size();
+		glBufferData(GL_ARRAY_BUFFER, bytes, instances.data(), GL_STREAM_DRAW);
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity * sizeof(instance)), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+	}
+	check_errors("Failed to set instance buffer data. ");
+	m_size = instances.size();
+}
+
+void ow::instance_buffer::attach() const {
+	gl_state::current().bind_buffer(GL_ARRAY_BUFFER, m_buffer);
+	check_errors("Failed to bind instance buffer. ");
+	instance::format::setup(FIRST_LOCATION, 1);
+	check_errors("Failed to set instance attributes. ");
+}
+
+void ow::instance_buffer::detach() {
+	instance::format::disable(FIRST_LOCATION);
+	check_errors("Failed to disable instance attributes. ");
+}
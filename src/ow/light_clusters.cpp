@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OW_CLUSTERS_X86
+#include <immintrin.h>
+#endif
+
+#include <ow/light_clusters.hpp>
+#include <ow/thread_pool.hpp>
+
+namespace {
+	// spheres processed at once by the widest kernel, slices are padded to a multiple of it.
+	constexpr std::size_t LANES = 8;
+
+	// squared distances along x of every column (dz^2 folded in), and along y of every row,
+	// stored lane by lane: value of column i for candidate l at [i * kernel width + l].
+	struct tile_distances {
+		std::vector<float> dx2{};
+		std::vector<float> dy2{};
+	};
+
+	float axis_distance(float value, float min, float max) {
+		return std::max({min - value, value - max, 0.f});
+	}
+
+	// bounds of the tiles of a slice along an axis: tile t covers [*min_t, *max_t].
+	void tile_bounds(const std::vector<float>& tiles, float near_depth, float far_depth,
+					 std::vector<float>* min, std::vector<float>* max) {
+		min->resize(tiles.size() - 1);
+		max->resize(tiles.size() - 1);
+		for (std::size_t t = 0; t + 1 < tiles.size(); ++t) {
+			(*min)[t] = std::min(tiles[t] * near_depth, tiles[t] * far_depth);
+			(*max)[t] = std::max(tiles[t + 1] * near_depth, tiles[t + 1] * far_depth);
+		}
+	}
+
+	void assign_scalar(const std::vector<float>& x_min, const std::vector<float>& x_max,
+					   const std::vector<float>& y_min, const std::vector<float>& y_max,
+					   const float* x, const float* y, const float* dz2, const float* r2, const std::uint16_t* light,
+					   std::size_t count, std::vector<float>* dx2, std::vector<std::vector<std::uint16_t>>* clusters) {
+		const std::size_t columns = x_min.size();
+		const std::size_t rows = y_min.size();
+		dx2->resize(columns);
+		for (std::size_t l = 0; l < count; ++l) {
+			for (std::size_t i = 0; i < columns; ++i) {
+				float d = axis_distance(x[l], x_min[i], x_max[i]);
+				(*dx2)[i] = d * d + dz2[l];
+			}
+			for (std::size_t j = 0; j < rows; ++j) {
+				float d = axis_distance(y[l], y_min[j], y_max[j]);
+				float remaining = r2[l] - d * d;
+				if (remaining < 0.f) {
+					continue;
+				}
+				for (std::size_t i = 0; i < columns; ++i) {
+					if ((*dx2)[i] <= remaining) {
+						(*clusters)[j * columns + i].push_back(light[l]);
+					}
+				}
+			}
+		}
+	}
+
+	void push_hits(int mask, const std::uint16_t* light, std::vector<std::uint16_t>* cluster) {
+		auto bits = static_cast<unsigned int>(mask);
+		while (bits != 0) {
+			cluster->push_back(light[__builtin_ctz(bits)]);
+			bits &= bits - 1;
+		}
+	}
+
+#ifdef OW_CLUSTERS_X86
+	__attribute__((target("sse2")))
+	__m128 axis_distance2_sse(__m128 value, float min, float max) {
+		__m128 d = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(min), value), _mm_sub_ps(value, _mm_set1_ps(max))),
+							  _mm_setzero_ps());
+		return _mm_mul_ps(d, d);
+	}
+
+	__attribute__((target("sse2")))
+	void assign_sse(const std::vector<float>& x_min, const std::vector<float>& x_max,
+					const std::vector<float>& y_min, const std::vector<float>& y_max,
+					const float* x, const float* y, const float* dz2, const float* r2, const std::uint16_t* light,
+					std::size_t count, tile_distances* distances, std::vector<std::vector<std::uint16_t>>* clusters) {
+		const std::size_t columns = x_min.size();
+		const std::size_t rows = y_min.size();
+		distances->dx2.resize(columns * 4);
+		distances->dy2.resize(rows * 4);
+		for (std::size_t l = 0; l < count; l += 4) {
+			__m128 vx = _mm_loadu_ps(x + l);
+			__m128 vy = _mm_loadu_ps(y + l);
+			__m128 vdz2 = _mm_loadu_ps(dz2 + l);
+			__m128 vr2 = _mm_loadu_ps(r2 + l);
+			for (std::size_t i = 0; i < columns; ++i) {
+				_mm_storeu_ps(distances->dx2.data() + i * 4, _mm_add_ps(axis_distance2_sse(vx, x_min[i], x_max[i]), vdz2));
+			}
+			for (std::size_t j = 0; j < rows; ++j) {
+				_mm_storeu_ps(distances->dy2.data() + j * 4, axis_distance2_sse(vy, y_min[j], y_max[j]));
+			}
+
+			for (std::size_t j = 0; j < rows; ++j) {
+				__m128 remaining = _mm_sub_ps(vr2, _mm_loadu_ps(distances->dy2.data() + j * 4));
+				if (_mm_movemask_ps(_mm_cmpge_ps(remaining, _mm_setzero_ps())) == 0) {
+					continue;
+				}
+				for (std::size_t i = 0; i < columns; ++i) {
+					int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(distances->dx2.data() + i * 4), remaining));
+					push_hits(mask, light + l, &(*clusters)[j * columns + i]);
+				}
+			}
+		}
+	}
+
+	__attribute__((target("avx2")))
+	__m256 axis_distance2_avx2(__m256 value, float min, float max) {
+		__m256 d = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(min), value),
+											   _mm256_sub_ps(value, _mm256_set1_ps(max))),
+								 _mm256_setzero_ps());
+		return _mm256_mul_ps(d, d);
+	}
+
+	__attribute__((target("avx2")))
+	void assign_avx2(const std::vector<float>& x_min, const std::vector<float>& x_max,
+					 const std::vector<float>& y_min, const std::vector<float>& y_max,
+					 const float* x, const float* y, const float* dz2, const float* r2, const std::uint16_t* light,
+					 std::size_t count, tile_distances* distances, std::vector<std::vector<std::uint16_t>>* clusters) {
+		const std::size_t columns = x_min.size();
+		const std::size_t rows = y_min.size();
+		distances->dx2.resize(columns * 8);
+		distances->dy2.resize(rows * 8);
+		for (std::size_t l = 0; l < count; l += 8) {
+			__m256 vx = _mm256_loadu_ps(x + l);
+			__m256 vy = _mm256_loadu_ps(y + l);
+			__m256 vdz2 = _mm256_loadu_ps(dz2 + l);
+			__m256 vr2 = _mm256_loadu_ps(r2 + l);
+			for (std::size_t i = 0; i < columns; ++i) {
+				_mm256_storeu_ps(distances->dx2.data() + i * 8,
+								 _mm256_add_ps(axis_distance2_avx2(vx, x_min[i], x_max[i]), vdz2));
+			}
+			for (std::size_t j = 0; j < rows; ++j) {
+				_mm256_storeu_ps(distances->dy2.data() + j * 8, axis_distance2_avx2(vy, y_min[j], y_max[j]));
+			}
+
+			for (std::size_t j = 0; j < rows; ++j) {
+				__m256 remaining = _mm256_sub_ps(vr2, _mm256_loadu_ps(distances->dy2.data() + j * 8));
+				if (_mm256_movemask_ps(_mm256_cmp_ps(remaining, _mm256_setzero_ps(), _CMP_GE_OQ)) == 0) {
+					continue;
+				}
+				for (std::size_t i = 0; i < columns; ++i) {
+					__m256 hit = _mm256_cmp_ps(_mm256_loadu_ps(distances->dx2.data() + i * 8), remaining, _CMP_LE_OQ);
+					push_hits(_mm256_movemask_ps(hit), light + l, &(*clusters)[j * columns + i]);
+				}
+			}
+		}
+	}
+#endif
+}
+
+ow::light_clusters::light_clusters(cluster_grid grid)
+		: m_grid{grid}, m_proj(0.f), m_near{0.f}, m_far{0.f}, m_depth_scale{0.f}, m_depth_bias{0.f}
+		, m_tile_x(), m_tile_y(), m_slice_depth(), m_slices(grid.z), m_ranges(), m_indices(), m_stats{} {
+	assert(grid.x > 0 && grid.y > 0 && grid.z > 0);
+	for (auto& s : m_slices) {
+		s.clusters.resize(std::size_t{grid.x} * grid.y);
+	}
+}
+
+void ow::light_clusters::set_projection(const glm::mat4& proj) {
+	if (proj == m_proj) {
+		return;
+	}
+	m_proj = proj;
+
+	// inverse of glm::perspective.
+	m_near = proj[3][2] / (proj[2][2] - 1.f);
+	m_far = proj[3][2] / (proj[2][2] + 1.f);
+	float tan_x = 1.f / proj[0][0];
+	float tan_y = 1.f / proj[1][1];
+	assert(m_near > 0.f && m_far > m_near);
+
+	m_tile_x.resize(m_grid.x + 1);
+	for (std::uint32_t i = 0; i <= m_grid.x; ++i) {
+		m_tile_x[i] = (-1.f + 2.f * static_cast<float>(i) / static_cast<float>(m_grid.x)) * tan_x;
+	}
+	m_tile_y.resize(m_grid.y + 1);
+	for (std::uint32_t j = 0; j <= m_grid.y; ++j) {
+		m_tile_y[j] = (-1.f + 2.f * static_cast<float>(j) / static_cast<float>(m_grid.y)) * tan_y;
+	}
+
+	float log_ratio = std::log(m_far / m_near);
+	m_depth_scale = static_cast<float>(m_grid.z) / log_ratio;
+	m_depth_bias = -static_cast<float>(m_grid.z) * std::log(m_near) / log_ratio;
+	m_slice_depth.resize(m_grid.z + 1);
+	for (std::uint32_t k = 0; k <= m_grid.z; ++k) {
+		m_slice_depth[k] = m_near * std::pow(m_far / m_near, static_cast<float>(k) / static_cast<float>(m_grid.z));
+	}
+}
+
+std::uint32_t ow::light_clusters::slice(float depth) const {
+	if (depth <= m_near) {
+		return 0;
+	}
+	float k = std::floor(std::log(depth) * m_depth_scale + m_depth_bias);
+	if (!(k > 0.f)) {
+		return 0;
+	}
+	return k < static_cast<float>(m_grid.z - 1) ? static_cast<std::uint32_t>(k) : m_grid.z - 1;
+}
+
+ow::cluster_stats ow::light_clusters::assign(const sphere_batch& lights, culling_kernel kernel, std::size_t max_indices) {
+	const std::size_t count = std::min(lights.size(), MAX_LIGHTS);
+	assert(lights.y.size() == lights.size() && lights.z.size() == lights.size() && lights.radius.size() == lights.size());
+	assert(!m_slice_depth.empty() && "set_projection must be called first");
+
+	culling_kernel best = best_culling_kernel();
+	if (kernel == culling_kernel::automatic || kernel > best) {
+		kernel = best;
+	}
+
+	for (auto& s : m_slices) {
+		s.x.clear();
+		s.y.clear();
+		s.dz2.clear();
+		s.r2.clear();
+		s.light.clear();
+	}
+
+	// candidates of each slice the sphere overlaps in depth.
+	m_stats = {};
+	for (std::size_t l = 0; l < count; ++l) {
+		float depth = -lights.z[l];
+		float radius = lights.radius[l];
+		if (!(radius > 0.f) || depth + radius < m_near || depth - radius > m_far) {
+			continue;
+		}
+		++m_stats.lights;
+
+		float r2 = std::isinf(radius) ? std::numeric_limits<float>::max() : radius * radius;
+		for (std::uint32_t k = slice(depth - radius), last = slice(depth + radius); k <= last; ++k) {
+			float dz = axis_distance(depth, m_slice_depth[k], m_slice_depth[k + 1]);
+			auto& s = m_slices[k];
+			s.x.push_back(lights.x[l]);
+			s.y.push_back(lights.y[l]);
+			s.dz2.push_back(dz * dz);
+			s.r2.push_back(r2);
+			s.light.push_back(static_cast<std::uint16_t>(l));
+		}
+	}
+	for (auto& s : m_slices) {
+		// a negative squared radius never hits.
+		std::size_t padded = (s.x.size() + LANES - 1) / LANES * LANES;
+		s.x.resize(padded, 0.f);
+		s.y.resize(padded, 0.f);
+		s.dz2.resize(padded, 0.f);
+		s.r2.resize(padded, -1.f);
+		s.light.resize(padded, 0);
+	}
+
+	thread_pool::global().parallel_for(m_grid.z, [this, kernel] (std::size_t k) {
+		_assign_slice(static_cast<std::uint32_t>(k), kernel);
+	});
+
+	m_ranges.resize(m_grid.size());
+	m_indices.clear();
+	std::size_t cluster = 0;
+	for (auto& s : m_slices) {
+		for (auto& list : s.clusters) {
+			std::size_t kept = std::min(list.size(), max_indices - std::min(max_indices, m_indices.size()));
+			m_ranges[cluster++] = {static_cast<std::uint32_t>(m_indices.size()), static_cast<std::uint32_t>(kept)};
+			m_indices.insert(m_indices.end(), list.begin(), list.begin() + static_cast<std::ptrdiff_t>(kept));
+			m_stats.dropped += list.size() - kept;
+			m_stats.max_per_cluster = std::max(m_stats.max_per_cluster, list.size());
+		}
+	}
+	m_stats.indices = m_indices.size();
+	return m_stats;
+}
+
+std::vector<std::uint16_t> ow::light_clusters::lights_of(std::uint32_t i, std::uint32_t j, std::uint32_t k) const {
+	auto& range = m_ranges.at(i + m_grid.x * (j + std::size_t{m_grid.y} * k));
+	auto begin = m_indices.begin() + range.offset;
+	return {begin, begin + range.count};
+}
+
+void ow::light_clusters::_assign_slice(std::uint32_t k, culling_kernel kernel) {
+	auto& s = m_slices[k];
+	for (auto& list : s.clusters) {
+		list.clear();
+	}
+	if (s.x.empty()) {
+		return;
+	}
+
+	// scratch buffers of the calling thread, kept from frame to frame.
+	thread_local std::vector<float> x_min, x_max, y_min, y_max;
+	thread_local tile_distances distances;
+	tile_bounds(m_tile_x, m_slice_depth[k], m_slice_depth[k + 1], &x_min, &x_max);
+	tile_bounds(m_tile_y, m_slice_depth[k], m_slice_depth[k + 1], &y_min, &y_max);
+
+	const std::size_t count = s.x.size();
+#ifdef OW_CLUSTERS_X86
+	if (kernel == culling_kernel::avx2) {
+		assign_avx2(x_min, x_max, y_min, y_max, s.x.data(), s.y.data(), s.dz2.data(), s.r2.data(), s.light.data(),
+					count, &distances, &s.clusters);
+		return;
+	}
+	if (kernel == culling_kernel::sse) {
+		assign_sse(x_min, x_max, y_min, y_max, s.x.data(), s.y.data(), s.dz2.data(), s.r2.data(), s.light.data(),
+				   count, &distances, &s.clusters);
+		return;
+	}
+#else
+	static_cast<void>(kernel);
+#endif
+	assign_scalar(x_min, x_max, y_min, y_max, s.x.data(), s.y.data(), s.dz2.data(), s.r2.data(), s.light.data(),
+				  count, &distances.dx2, &s.clusters);
+}
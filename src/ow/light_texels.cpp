@@ -0,0 +1,45 @@
+#include <algorithm>
+
+#include <ow/light_texels.hpp>
+
+std::size_t ow::pack_light_texels(const lights_set& lights, const glm::mat4& view, std::size_t max_lights,
+								  std::vector<glm::vec4>* texels, sphere_batch* bounds) {
+	const auto& point_lights = lights.get_point_lights();
+	const auto& spotlights = lights.get_spotlights();
+	std::size_t point_count = std::min(point_lights.size(), max_lights);
+	std::size_t spot_count = std::min(spotlights.size(), max_lights - point_count);
+
+	texels->clear();
+	texels->reserve((point_count + spot_count) * LIGHT_TEXELS);
+	bounds->clear();
+	for (std::size_t i = 0; i < point_count; ++i) {
+		auto& light = *point_lights[i];
+		auto packed = light.to_block(view);
+		auto sphere = transform(light.bounds(), view);
+		// clamp((theta - outer) / (cutoff - outer)) is 1 for any theta.
+		texels->insert(texels->end(), {
+			glm::vec4(packed.position, packed.attenuation_constant),
+			glm::vec4(packed.diffuse, packed.attenuation_linear),
+			glm::vec4(packed.specular, packed.attenuation_quadratic),
+			glm::vec4(0.f, 0.f, -1.f, -1.f),
+			glm::vec4(-2.f, 0.f, 0.f, 0.f),
+			glm::vec4(sphere.center, sphere.radius)
+		});
+		bounds->push_back(sphere);
+	}
+	for (std::size_t i = 0; i < spot_count; ++i) {
+		auto& light = *spotlights[i];
+		auto packed = light.to_block(view);
+		auto sphere = transform(light.bounds(), view);
+		texels->insert(texels->end(), {
+			glm::vec4(packed.position, packed.attenuation_constant),
+			glm::vec4(packed.diffuse, packed.attenuation_linear),
+			glm::vec4(packed.specular, packed.attenuation_quadratic),
+			glm::vec4(packed.direction, packed.cutoff),
+			glm::vec4(packed.outer_cutoff, 0.f, 0.f, 0.f),
+			glm::vec4(sphere.center, sphere.radius)
+		});
+		bounds->push_back(sphere);
+	}
+	return point_count + spot_count;
+}
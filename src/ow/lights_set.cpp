@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <ow/gl_state.hpp>
+#include <ow/lights_set.hpp>
+#include <ow/opengl_codes.hpp>
+
+namespace {
+	// bytes of the block to upload.
+	struct byte_range {
+		std::size_t first = std::numeric_limits<std::size_t>::max();
+		std::size_t last = 0;
+
+		void add(std::size_t offset, std::size_t size) {
+			first = std::min(first, offset);
+			last = std::max(last, offset + size);
+		}
+
+		bool empty() const {
+			return first >= last;
+		}
+	};
+
+	// packs the first count lights which changed since their uploaded version (all of them
+	// when the view changed) and returns how many were.
+	template <typename Light, typename Packed>
+	std::size_t pack_changed(const std::vector<std::shared_ptr<Light>>& lights, std::size_t count,
+							 std::vector<std::uint64_t>* versions, Packed* packed, const std::byte* block,
+							 bool view_changed, const glm::mat4& view, byte_range* dirty) {
+		versions->resize(count, 0);
+		std::size_t changed = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			auto version = lights[i]->version();
+			if (view_changed || (*versions)[i] != version) {
+				packed[i] = lights[i]->to_block(view);
+				(*versions)[i] = version;
+				dirty->add(static_cast<std::size_t>(reinterpret_cast<const std::byte*>(&packed[i]) - block), sizeof(Packed));
+				++changed;
+			}
+		}
+		return changed;
+	}
+
+	template <typename T>
+	void set_count(T* count, std::size_t value, byte_range* dirty, const std::byte* block) {
+		if (*count != static_cast<T>(value)) {
+			*count = static_cast<T>(value);
+			dirty->add(static_cast<std::size_t>(reinterpret_cast<const std::byte*>(count) - block), sizeof(T));
+		}
+	}
+}
+
+ow::lights_set::lights_set(lights_set&& other) noexcept
+		: m_buffer{std::exchange(other.m_buffer, 0)}
+		, m_block(std::move(other.m_block))
+		, m_view(std::exchange(other.m_view, std::nullopt))
+		, m_dir_lights(std::move(other.m_dir_lights))
+		, m_point_lights(std::move(other.m_point_lights))
+		, m_spotlights(std::move(other.m_spotlights))
+		, m_dir_versions(std::move(other.m_dir_versions))
+		, m_point_versions(std::move(other.m_point_versions))
+		, m_spot_versions(std::move(other.m_spot_versions))
+		, m_stats{other.m_stats} {}
+
+ow::lights_set::~lights_set() {
+	if (m_buffer != 0) {
+		gl_state::current().delete_buffer(m_buffer);
+		check_errors("error while deleting lights buffer. ");
+	}
+}
+
+ow::shader_defines ow::lights_set::count_defines() const {
+	shader_defines defines;
+	defines.set("DIR_LIGHTS", static_cast<long>(std::min(m_dir_lights.size(), MAX_DIR_LIGHTS)));
+	defines.set("POINT_LIGHTS", static_cast<long>(std::min(m_point_lights.size(), MAX_POINT_LIGHTS)));
+	defines.set("SPOTLIGHTS", static_cast<long>(std::min(m_spotlights.size(), MAX_SPOTLIGHTS)));
+	return defines;
+}
+
+void ow::lights_set::upload(const glm::mat4& view) {
+	auto& state = gl_state::current();
+	if (m_buffer == 0) {
+		m_block = std::make_unique<std140_lights_block>();
+		glGenBuffers(1, &m_buffer);
+		check_errors("error while generating lights buffer. ");
+		state.bind_buffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(std140_lights_block), m_block.get(), GL_DYNAMIC_DRAW);
+		check_errors("Failed to allocate lights buffer. ");
+	}
+
+	auto& block = *m_block;
+	auto block_bytes = reinterpret_cast<const std::byte*>(&block);
+	auto dir_count = std::min(m_dir_lights.size(), MAX_DIR_LIGHTS);
+	auto point_count = std::min(m_point_lights.size(), MAX_POINT_LIGHTS);
+	auto spot_count = std::min(m_spotlights.size(), MAX_SPOTLIGHTS);
+
+	// everything is in view space: a new view changes every light.
+	bool view_changed = !m_view || *m_view != view;
+	m_view = view;
+
+	byte_range dirty;
+	set_count(&block.nbr_dir_lights, dir_count, &dirty, block_bytes);
+	set_count(&block.nbr_point_lights, point_count, &dirty, block_bytes);
+	set_count(&block.nbr_spotlights, spot_count, &dirty, block_bytes);
+	m_stats.dirty_lights =
+			pack_changed(m_dir_lights, dir_count, &m_dir_versions, block.dir_lights, block_bytes, view_changed, view, &dirty)
+			+ pack_changed(m_point_lights, point_count, &m_point_versions, block.point_lights, block_bytes, view_changed,
+						   view, &dirty)
+			+ pack_changed(m_spotlights, spot_count, &m_spot_versions, block.spotlights, block_bytes, view_changed, view,
+						   &dirty);
+
+	// one update covering every change: the lights arrays are contiguous.
+	m_stats.uploaded_bytes = dirty.empty() ? 0 : dirty.last - dirty.first;
+	if (!dirty.empty()) {
+		state.bind_buffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(dirty.first), static_cast<GLsizeiptr>(m_stats.uploaded_bytes),
+						block_bytes + dirty.first);
+		check_errors("Failed to set lights buffer data. ");
+	}
+
+	state.bind_buffer_base(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, m_buffer);
+	check_errors("Failed to bind lights buffer. ");
+}
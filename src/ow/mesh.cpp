@@ -1,8 +1,7 @@
-#include <cstddef> // offsetof
-
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
+#include <ow/gl_state.hpp>
 #include <ow/shader_program.hpp>
 #include <ow/texture.hpp>
 #include <ow/vertex.hpp>
@@ -11,8 +10,10 @@
 ow::mesh::mesh(std::vector<ow::vertex> vertices, std::vector<unsigned int> indices,
 			   std::vector<std::shared_ptr<ow::texture>> diffuse_maps,
 			   std::vector<std::shared_ptr<ow::texture>> specular_maps,
-			   std::vector<std::shared_ptr<ow::texture>> emission_maps)
-		: m_VAO{}, m_EBO{}, m_VBO{}
+			   std::vector<std::shared_ptr<ow::texture>> emission_maps,
+			   vertex_packing packing)
+		: m_VAO{}, m_EBO{}, m_VBO{}, m_index_type{index_type::u32}
+		, m_vertex_packing{packing}, m_dequantization{1.f}, m_lods(), m_aabb(), m_bounding_sphere(), m_bvh(), m_instances()
 		, m_vertices(std::move(vertices))
 		, m_indices(std::move(indices))
 		, m_diffuse_maps(std::move(diffuse_maps))
@@ -21,8 +22,10 @@ ow::mesh::mesh(std::vector<ow::vertex> vertices, std::vector<unsigned int> indic
 	_setup_mesh();
 }
 
-ow::mesh::mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices, std::vector<std::shared_ptr<texture>> textures)
-		: m_VAO{}, m_EBO{}, m_VBO{}
+ow::mesh::mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices, std::vector<std::shared_ptr<texture>> textures,
+			   vertex_packing packing)
+		: m_VAO{}, m_EBO{}, m_VBO{}, m_index_type{index_type::u32}
+		, m_vertex_packing{packing}, m_dequantization{1.f}, m_lods(), m_aabb(), m_bounding_sphere(), m_bvh(), m_instances()
 		, m_vertices(std::move(vertices))
 		, m_indices(std::move(indices))
 		, m_diffuse_maps()
@@ -34,8 +37,9 @@ ow::mesh::mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices,
 	_setup_mesh();
 }
 
-ow::mesh::mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices)
-		: m_VAO{}, m_EBO{}, m_VBO{}
+ow::mesh::mesh(std::vector<vertex> vertices, std::vector<unsigned int> indices, vertex_packing packing)
+		: m_VAO{}, m_EBO{}, m_VBO{}, m_index_type{index_type::u32}
+		, m_vertex_packing{packing}, m_dequantization{1.f}, m_lods(), m_aabb(), m_bounding_sphere(), m_bvh(), m_instances()
 		, m_vertices(std::move(vertices))
 		, m_indices(std::move(indices))
 		, m_diffuse_maps()
@@ -48,6 +52,14 @@ ow::mesh::mesh(mesh&& other) noexcept(noexcept(std::vector<vertex>{std::vector<v
 		: m_VAO{std::exchange(other.m_VAO, 0)}
 		, m_EBO{std::exchange(other.m_EBO, 0)}
 		, m_VBO{std::move(other.m_VBO)}
+		, m_index_type{other.m_index_type}
+		, m_vertex_packing{other.m_vertex_packing}
+		, m_dequantization{other.m_dequantization}
+		, m_lods(std::move(other.m_lods))
+		, m_aabb(other.m_aabb)
+		, m_bounding_sphere(other.m_bounding_sphere)
+		, m_bvh(std::move(other.m_bvh))
+		, m_instances(std::move(other.m_instances))
 		, m_vertices{std::move(other.m_vertices)}
 		, m_indices{std::move(other.m_indices)}
 		, m_diffuse_maps(std::move(other.m_diffuse_maps))
@@ -55,36 +67,103 @@ ow::mesh::mesh(mesh&& other) noexcept(noexcept(std::vector<vertex>{std::vector<v
 		, m_emission_maps(std::move(other.m_emission_maps)) {}
 
 ow::mesh::~mesh() {
-	glDeleteVertexArrays(1, &m_VAO);
+	gl_state::current().delete_vertex_array(m_VAO);
 	check_errors("error while deleting VAO. ");
-	glDeleteBuffers(1, &m_EBO);
+	gl_state::current().delete_buffer(m_EBO);
 	check_errors("error while deleting EBO. ");
 }
 
 void ow::mesh::draw(const shader_program& prog) const {
+	draw(prog, 0);
+}
+
+void ow::mesh::draw(const shader_program& prog, std::size_t lod) const {
+	_draw(prog, lod, nullptr);
+}
+
+void ow::mesh::draw_instanced(const shader_program& prog, const std::vector<instance>& instances, std::size_t lod) const {
+	if (instances.empty()) {
+		return;
+	}
+	if (!m_instances) {
+		m_instances = std::make_unique<instance_buffer>();
+	}
+	m_instances->set_data(instances);
+	_draw(prog, lod, m_instances.get());
+}
+
+void ow::mesh::draw_instanced(const shader_program& prog, const instance_buffer& instances, std::size_t lod) const {
+	if (instances.size() > 0) {
+		_draw(prog, lod, &instances);
+	}
+}
+
+void ow::mesh::bind_textures(const shader_program& prog) const {
+	_bind_textures(prog, 0);
+}
+
+void ow::mesh::draw_elements(std::size_t lod, const instance_buffer* instances) const {
+	assert(lod < m_lods.size());
+	const lod_range& range = m_lods[lod];
+	assert(m_VAO != 0);
+	assert(range.index_count > 0);
+	assert(range.index_count % 3 == 0);
+
+	auto offset = reinterpret_cast<void*>(range.first_index * index_type_size(m_index_type));
+	if (instances) {
+		glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(range.index_count), index_type_to_gl(m_index_type),
+								offset, static_cast<GLsizei>(instances->size()));
+	} else {
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(range.index_count), index_type_to_gl(m_index_type), offset);
+	}
+	check_errors("failed to draw VAO elements. ");
+}
+
+ow::shader_defines ow::mesh::material_defines() const {
+	shader_defines defines;
+	defines.set("HAS_DIFFUSE_MAP", m_diffuse_maps.empty() ? 0 : 1);
+	defines.set("HAS_SPECULAR_MAP", m_specular_maps.empty() ? 0 : 1);
+	defines.set("HAS_EMISSION_MAP", m_emission_maps.empty() ? 0 : 1);
+	return defines;
+}
+
+void ow::mesh::_bind_textures(const shader_program& prog, unsigned int pass) const {
+	int next_unit_to_activate = 0;
+	activate_next_texture_unit(prog, &next_unit_to_activate, pass, m_diffuse_maps, texture_type::diffuse);
+	activate_next_texture_unit(prog, &next_unit_to_activate, pass, m_specular_maps, texture_type::specular);
+	activate_next_texture_unit(prog, &next_unit_to_activate, pass, m_emission_maps, texture_type::emission);
+}
+
+void ow::mesh::_draw(const shader_program& prog, std::size_t lod, const instance_buffer* instances) const {
+	assert(lod < m_lods.size());
+
 	prog.use();
 
-	glBindVertexArray(m_VAO);
+	gl_state::current().bind_vertex_array(m_VAO);
 	check_errors("failed to bind VAO. ");
+	if (m_vertex_packing == vertex_packing::packed) {
+		prog.set("dequantization", m_dequantization);
+	}
+	if (instances) {
+		instances->attach();
+		prog.set("instanced", true);
+	}
+
 	size_t number_of_passes = std::max(std::max(m_diffuse_maps.size(), m_specular_maps.size()), m_emission_maps.size());
 	assert(number_of_passes <= 1); // multiple passes not yet functional.
 	for (unsigned int i = 0; i < number_of_passes; ++i) {
-		int next_unit_to_activate = 0;
-		_activate_next_texture_unit(prog, &next_unit_to_activate, i, m_diffuse_maps, texture_type::diffuse);
-		_activate_next_texture_unit(prog, &next_unit_to_activate, i, m_specular_maps, texture_type::specular);
-		_activate_next_texture_unit(prog, &next_unit_to_activate, i, m_emission_maps, texture_type::emission);
-
-		assert(m_VAO != 0);
-		assert(!m_indices.empty());
-		assert(m_indices.size() % 3 == 0);
-		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
-		check_errors("failed to draw VAO elements. ");
+		_bind_textures(prog, i);
+		draw_elements(lod, instances);
 	}
 	// reset
-	glActiveTexture(GL_TEXTURE0);
-	check_errors("error while activating texture " + std::to_string(GL_TEXTURE0) + ". ");
-	glBindVertexArray(0);
-	check_errors("failed to unbind VAO. ");
+	if (m_vertex_packing == vertex_packing::packed) {
+		prog.set("dequantization", glm::mat4{1.f});
+	}
+	if (instances) {
+		instance_buffer::detach();
+		prog.set("instanced", false);
+	}
+	// the VAO and the texture units stay bound: the next draws only change what differs.
 }
 
 void ow::mesh::add_texture(std::shared_ptr<ow::texture> texture) {
@@ -104,56 +183,122 @@ void ow::mesh::add_texture(std::shared_ptr<ow::texture> texture) {
 }
 
 void ow::mesh::_setup_mesh() {
+	m_aabb = compute_aabb(m_vertices);
+	m_bounding_sphere = compute_bounding_sphere(m_vertices);
+
 	glGenVertexArrays(1, &m_VAO);
 	check_errors("error while generating VAO. ");
 	glGenBuffers(1, &m_EBO);
 	check_errors("error while generating EBO. ");
 
-	glBindVertexArray(m_VAO);
+	gl_state::current().bind_vertex_array(m_VAO);
 	check_errors("Failed to bind VAO. ");
 
-	m_VBO.set_data(m_vertices);
+	if (m_vertex_packing == vertex_packing::packed) {
+		_upload_vertices(pack_vertices(m_vertices, &m_dequantization));
+	} else {
+		_upload_vertices(m_vertices);
+	}
+
+	m_index_type = index_type_for(m_vertices.size());
+	_upload_indices({});
+
+	gl_state::current().bind_vertex_array(0); // unbind the VAO
+	check_errors("Failed to unbind VAO. ");
+}
+
+void ow::mesh::generate_lods(const lod_settings& settings) {
+	auto levels = build_lod_chain(m_vertices, m_indices, settings);
+	levels.erase(levels.begin()); // level 0 is m_indices
+
+	gl_state::current().bind_vertex_array(m_VAO);
+	check_errors("Failed to bind VAO. ");
+	_upload_indices(levels);
+	gl_state::current().bind_vertex_array(0);
+	check_errors("Failed to unbind VAO. ");
+}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+const ow::triangle_bvh& ow::mesh::build_bvh() {
+	if (!m_bvh) {
+		m_bvh = std::make_unique<triangle_bvh>(m_vertices, m_indices);
+	}
+	return *m_bvh;
+}
+
+std::size_t ow::mesh::select_lod(float distance, float fov, float viewport_height, float max_pixel_error) const {
+	std::size_t lod = 0;
+	while (lod + 1 < m_lods.size() && projected_error(m_lods[lod + 1].error, distance, fov, viewport_height) <= max_pixel_error) {
+		++lod;
+	}
+	return lod;
+}
+
+void ow::mesh::_upload_indices(const std::vector<lod_level>& levels) {
+	// m_indices keeps 32 bits indices for the CPU side, the GPU gets the narrowest type.
+	m_lods.assign(1, {0, m_indices.size(), 0.f});
+	std::vector<unsigned int> all_indices;
+	const std::vector<unsigned int>* uploaded = &m_indices;
+	if (!levels.empty()) {
+		all_indices = m_indices;
+		for (auto& level : levels) {
+			m_lods.push_back({all_indices.size(), level.indices.size(), level.error});
+			all_indices.insert(all_indices.end(), level.indices.begin(), level.indices.end());
+		}
+		uploaded = &all_indices;
+	}
+	auto packed_indices = pack_indices(*uploaded, m_index_type);
+
+	// the VAO must be bound: it records the element buffer.
+	gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 	check_errors("Failed to bind EBO. ");
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed_indices.size()), packed_indices.data(), GL_STATIC_DRAW);
 	check_errors("Failed to set EBO data. ");
+}
 
-	// vertex positions
-	m_VBO.attribs().layout_size = 3u;
-	m_VBO.attribs().stride = 1;
-	m_VBO.flush_layout_attribs();
-
-	// vertex normals
-	m_VBO.attribs().layout_index = 1u;
-	m_VBO.attribs().layout_offset = offsetof(vertex, normal);
-	m_VBO.flush_layout_attribs();
+template <typename Vertex>
+void ow::mesh::_upload_vertices(const std::vector<Vertex>& vertices) {
+	m_VBO.set_bytes(vertices.data(), vertices.size() * sizeof(Vertex));
+	Vertex::format::setup(); // the VBO is still bound
+	check_errors("Failed to set vertex attributes. ");
+}
 
-	// vertex texture coords
-	m_VBO.attribs().layout_index = 2u;
-	m_VBO.attribs().layout_size = 2u;
-	m_VBO.attribs().layout_offset = offsetof(vertex, tex_coords);
-	m_VBO.flush_layout_attribs();
+namespace {
+	struct texture_uniforms {
+		std::string_view has_map;
+		std::string_view map;
+	};
 
-	glBindVertexArray(0); // unbind the VAO
-	check_errors("Failed to unbind VAO. ");
+	// literal names: setting them doesn't build strings every draw.
+	texture_uniforms uniforms_of(ow::texture_type type) {
+		switch (type) {
+		case ow::texture_type::diffuse:
+			return {"has_diffuse_map", "diffuse_map"};
+		case ow::texture_type::specular:
+			return {"has_specular_map", "specular_map"};
+		case ow::texture_type::emission:
+			return {"has_emission_map", "emission_map"};
+		default:
+			assert(false && "unknown texture type");
+			return {}; // empty names match no uniform
+		}
+	}
 }
 
-void ow::mesh::_activate_next_texture_unit(const shader_program& prog, int* next_unit_to_activate,
-										   unsigned int current_pass,
-										   std::vector<std::shared_ptr<ow::texture>> textures,
-										   ow::texture_type tex_type) const {
+void ow::activate_next_texture_unit(const shader_program& prog, int* next_unit_to_activate,
+									unsigned int current_pass,
+									const std::vector<std::shared_ptr<ow::texture>>& textures,
+									ow::texture_type tex_type) {
 	if (current_pass < textures.size()) {
-		glActiveTexture(GL_TEXTURE0 + static_cast<GLuint>(*next_unit_to_activate));
-		check_errors("error while activating texture unit " + std::to_string(GL_TEXTURE0 + (*next_unit_to_activate)) + ". ");
-		glBindTexture(GL_TEXTURE_2D, textures[current_pass]->id);
+		gl_state::current().bind_texture(static_cast<GLuint>(*next_unit_to_activate), GL_TEXTURE_2D,
+										 textures[current_pass]->id);
 		check_errors("error while binding texture " + std::to_string(textures[current_pass]->id) + ". ");
 
-		prog.set("has_" + textures[current_pass]->type_to_string() + "_map", true);
-		prog.set(textures[current_pass]->type_to_string() + "_map", *next_unit_to_activate);
+		auto uniforms = uniforms_of(textures[current_pass]->type);
+		prog.set(uniforms.has_map, true);
+		prog.set(uniforms.map, *next_unit_to_activate);
 
 		++(*next_unit_to_activate);
 	} else {
-		prog.set("has_" + texture_type_to_string(tex_type) + "_map", false);
+		prog.set(uniforms_of(tex_type).has_map, false);
 	}
 }
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+#include <glad/glad.h>
+
+#include <ow/gl_state.hpp>
+#include <ow/mesh.hpp>
+#include <ow/mesh_arena.hpp>
+#include <ow/opengl_codes.hpp>
+
+namespace {
+	// reallocate *buffer with room for new_size bytes, keeping its first used bytes.
+	void grow_buffer(GLuint* buffer, std::size_t used, std::size_t new_size) {
+		GLuint grown = 0;
+		glGenBuffers(1, &grown);
+		ow::check_errors("error while generating buffer. ");
+		auto& state = ow::gl_state::current();
+		state.bind_buffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_size), nullptr, GL_STATIC_DRAW);
+		ow::check_errors("error while allocating buffer. ");
+
+		if (used > 0) {
+			state.bind_buffer(GL_COPY_READ_BUFFER, *buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(used));
+			ow::check_errors("error while copying buffer. ");
+			state.bind_buffer(GL_COPY_READ_BUFFER, 0);
+		}
+		state.bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+		state.delete_buffer(*buffer);
+		*buffer = grown;
+	}
+}
+
+ow::mesh_arena::mesh_arena()
+		: m_VAO{}, m_VBO{}, m_EBO{}
+		, m_vertex_capacity{0}, m_index_capacity{0}
+		, m_vertex_count{0}, m_index_count{0}
+		, m_submeshes() {
+	glGenVertexArrays(1, &m_VAO);
+	check_errors("error while generating VAO. ");
+}
+
+ow::mesh_arena::mesh_arena(mesh_arena&& other) noexcept
+		: m_VAO{std::exchange(other.m_VAO, 0)}
+		, m_VBO{std::exchange(other.m_VBO, 0)}
+		, m_EBO{std::exchange(other.m_EBO, 0)}
+		, m_vertex_capacity{std::exchange(other.m_vertex_capacity, 0)}
+		, m_index_capacity{std::exchange(other.m_index_capacity, 0)}
+		, m_vertex_count{std::exchange(other.m_vertex_count, 0)}
+		, m_index_count{std::exchange(other.m_index_count, 0)}
+		, m_submeshes(std::move(other.m_submeshes)) {}
+
+ow::mesh_arena::~mesh_arena() {
+	gl_state::current().delete_vertex_array(m_VAO);
+	check_errors("error while deleting VAO. ");
+	gl_state::current().delete_buffer(m_VBO);
+	check_errors("error while deleting VBO. ");
+	gl_state::current().delete_buffer(m_EBO);
+	check_errors("error while deleting EBO. ");
+}
+
+void ow::mesh_arena::reserve(std::size_t vertex_capacity, std::size_t index_capacity) {
+	bool grown = false;
+	if (vertex_capacity > m_vertex_capacity) {
+		grow_buffer(&m_VBO, m_vertex_count * sizeof(vertex), vertex_capacity * sizeof(vertex));
+		m_vertex_capacity = vertex_capacity;
+		grown = true;
+	}
+	if (index_capacity > m_index_capacity) {
+		grow_buffer(&m_EBO, m_index_count * sizeof(unsigned int), index_capacity * sizeof(unsigned int));
+		m_index_capacity = index_capacity;
+		grown = true;
+	}
+
+	if (grown) {
+		_setup_attribs(); // the VAO still refers to the old buffers.
+	}
+}
+
+void ow::mesh_arena::add_mesh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices, texture_maps maps) {
+	add_mesh(vertices.data(), vertices.size(), indices.data(), indices.size(), std::move(maps));
+}
+
+void ow::mesh_arena::add_mesh(const vertex* vertices, std::size_t vertex_count, const unsigned int* indices,
+							  std::size_t index_count, texture_maps maps) {
+	assert(index_count > 0);
+	assert(index_count % 3 == 0);
+
+	// grow geometrically so that adding meshes one by one stays linear.
+	auto grown_capacity = [] (std::size_t capacity, std::size_t needed) {
+		return needed > capacity ? std::max(needed, 2 * capacity) : capacity;
+	};
+	reserve(grown_capacity(m_vertex_capacity, m_vertex_count + vertex_count),
+			grown_capacity(m_index_capacity, m_index_count + index_count));
+
+	gl_state::current().bind_vertex_array(m_VAO);
+	check_errors("failed to bind VAO. ");
+
+	gl_state::current().bind_buffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(m_vertex_count * sizeof(vertex)),
+					static_cast<GLsizeiptr>(vertex_count * sizeof(vertex)), vertices);
+	check_errors("Failed to set VBO data. ");
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(m_index_count * sizeof(unsigned int)),
+					static_cast<GLsizeiptr>(index_count * sizeof(unsigned int)), indices);
+	check_errors("Failed to set EBO data. ");
+
+	gl_state::current().bind_vertex_array(0);
+	check_errors("Failed to unbind VAO. ");
+
+	m_submeshes.push_back({
+		m_index_count,
+		static_cast<GLsizei>(index_count),
+		static_cast<GLint>(m_vertex_count),
+		std::move(maps),
+		compute_bounding_sphere(vertices, vertex_count)
+	});
+	m_vertex_count += vertex_count;
+	m_index_count += index_count;
+}
+
+void ow::mesh_arena::draw(const shader_program& prog, const unsigned char* visibility) const {
+	_draw(prog, visibility, nullptr);
+}
+
+void ow::mesh_arena::draw_instanced(const shader_program& prog, const instance_buffer& instances,
+									const unsigned char* visibility) const {
+	if (instances.size() > 0) {
+		_draw(prog, visibility, &instances);
+	}
+}
+
+void ow::mesh_arena::_draw(const shader_program& prog, const unsigned char* visibility, const instance_buffer* instances) const {
+	prog.use();
+
+	gl_state::current().bind_vertex_array(m_VAO);
+	check_errors("failed to bind VAO. ");
+	if (instances) {
+		instances->attach();
+		prog.set("instanced", true);
+	}
+
+	const texture_maps* bound_maps = nullptr;
+	for (std::size_t i = 0; i < m_submeshes.size(); ++i) {
+		if (visibility && !visibility[i]) {
+			continue;
+		}
+
+		auto& sub = m_submeshes[i];
+		// consecutive meshes often share their material: only rebind textures when it changes.
+		if (!bound_maps || *bound_maps != sub.maps) {
+			int next_unit_to_activate = 0;
+			activate_next_texture_unit(prog, &next_unit_to_activate, 0, sub.maps[0], texture_type::diffuse);
+			activate_next_texture_unit(prog, &next_unit_to_activate, 0, sub.maps[1], texture_type::specular);
+			activate_next_texture_unit(prog, &next_unit_to_activate, 0, sub.maps[2], texture_type::emission);
+			bound_maps = &sub.maps;
+		}
+
+		auto offset = reinterpret_cast<void*>(sub.first_index * sizeof(unsigned int));
+		if (instances) {
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, sub.index_count, GL_UNSIGNED_INT, offset,
+											  static_cast<GLsizei>(instances->size()), sub.base_vertex);
+		} else {
+			glDrawElementsBaseVertex(GL_TRIANGLES, sub.index_count, GL_UNSIGNED_INT, offset, sub.base_vertex);
+		}
+		check_errors("failed to draw VAO elements. ");
+	}
+
+	// reset
+	if (instances) {
+		instance_buffer::detach();
+		prog.set("instanced", false);
+	}
+}
+
+void ow::mesh_arena::_setup_attribs() {
+	gl_state::current().bind_vertex_array(m_VAO);
+	check_errors("Failed to bind VAO. ");
+
+	gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	check_errors("Failed to bind EBO. ");
+	gl_state::current().bind_buffer(GL_ARRAY_BUFFER, m_VBO);
+	check_errors("Failed to bind VBO. ");
+
+	vertex::format::setup();
+	check_errors("Failed to set vertex attributes. ");
+
+	gl_state::current().bind_vertex_array(0); // unbind the VAO
+	check_errors("Failed to unbind VAO. ");
+}
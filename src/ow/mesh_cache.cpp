@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OW_MESH_CACHE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <ow/mesh_cache.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	constexpr std::array<char, 4> MAGIC = {'O', 'W', 'M', 'C'};
+	constexpr std::uint32_t ENDIANNESS_MARKER = 0x01020304;
+
+	static_assert(std::is_trivially_copyable_v<ow::vertex>, "vertices are stored as raw bytes");
+
+	constexpr std::size_t align8(std::size_t offset) {
+		return (offset + 7u) & ~static_cast<std::size_t>(7u);
+	}
+
+	struct sections {
+		std::size_t records;
+		std::size_t vertices;
+		std::size_t indices;
+		std::size_t string_offsets;
+		std::size_t string_chars;
+		std::size_t end;
+	};
+
+	sections compute_sections(const ow::mesh_cache_header& header) {
+		sections s{};
+		s.records = align8(sizeof(ow::mesh_cache_header));
+		s.vertices = align8(s.records + header.mesh_count * sizeof(ow::mesh_cache_record));
+		s.indices = align8(s.vertices + header.vertex_count * sizeof(ow::vertex));
+		s.string_offsets = align8(s.indices + header.index_count * sizeof(unsigned int));
+		s.string_chars = s.string_offsets + (header.string_count + 1) * sizeof(std::uint64_t);
+		s.end = s.string_chars + header.string_bytes;
+		return s;
+	}
+
+	void write_at(std::ofstream& file, std::size_t offset, const void* data, std::size_t size) {
+		auto pos = static_cast<std::size_t>(file.tellp());
+		static constexpr char padding[8] = {};
+		if (pos < offset) {
+			file.write(padding, static_cast<std::streamsize>(offset - pos));
+		}
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	}
+}
+
+void ow::mesh_cache_writer::add_mesh(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+									 const std::array<std::vector<std::string>, MESH_CACHE_TEXTURE_TYPES>& texture_names) {
+	mesh_cache_record record{};
+	record.vertex_first = m_vertices.size();
+	record.vertex_count = vertices.size();
+	record.index_first = m_indices.size();
+	record.index_count = indices.size();
+	for (std::size_t type = 0; type < MESH_CACHE_TEXTURE_TYPES; ++type) {
+		record.texture_first[type] = static_cast<std::uint32_t>(m_strings.size());
+		record.texture_count[type] = static_cast<std::uint32_t>(texture_names[type].size());
+		m_strings.insert(m_strings.end(), texture_names[type].begin(), texture_names[type].end());
+	}
+
+	m_records.push_back(record);
+	m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+	m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+}
+
+bool ow::mesh_cache_writer::write(const std::string& cache_filename, std::uint64_t source_hash) const {
+	std::vector<std::uint64_t> string_offsets{0};
+	for (auto& str : m_strings) {
+		string_offsets.push_back(string_offsets.back() + str.size());
+	}
+
+	mesh_cache_header header{};
+	header.magic = MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.endianness = ENDIANNESS_MARKER;
+	header.vertex_size = sizeof(vertex);
+	header.source_hash = source_hash;
+	header.mesh_count = m_records.size();
+	header.vertex_count = m_vertices.size();
+	header.index_count = m_indices.size();
+	header.string_count = m_strings.size();
+	header.string_bytes = string_offsets.back();
+	auto s = compute_sections(header);
+
+	// write in a temporary file first so that a crash never leaves a truncated cache behind.
+	const std::string tmp_filename = cache_filename + ".tmp";
+	{
+		std::ofstream file(tmp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file) {
+			logger << "Failed to open mesh cache " << tmp_filename << " for writing.\n";
+			return false;
+		}
+
+		write_at(file, 0, &header, sizeof(header));
+		write_at(file, s.records, m_records.data(), m_records.size() * sizeof(mesh_cache_record));
+		write_at(file, s.vertices, m_vertices.data(), m_vertices.size() * sizeof(vertex));
+		write_at(file, s.indices, m_indices.data(), m_indices.size() * sizeof(unsigned int));
+		write_at(file, s.string_offsets, string_offsets.data(), string_offsets.size() * sizeof(std::uint64_t));
+		for (auto& str : m_strings) {
+			file.write(str.data(), static_cast<std::streamsize>(str.size()));
+		}
+
+		if (!file) {
+			logger << "Failed to write mesh cache " << tmp_filename << ".\n";
+			return false;
+		}
+	}
+
+	std::remove(cache_filename.c_str());
+	if (std::rename(tmp_filename.c_str(), cache_filename.c_str()) != 0) {
+		logger << "Failed to move mesh cache to " << cache_filename << ".\n";
+		std::remove(tmp_filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+ow::mesh_cache::mesh_cache(const std::string& cache_filename, std::uint64_t expected_source_hash)
+		: m_data{nullptr}
+		, m_size{0}
+		, m_mapped{false}
+		, m_buffer()
+		, m_header{nullptr}
+		, m_records{nullptr}
+		, m_vertices{nullptr}
+		, m_indices{nullptr}
+		, m_string_offsets{nullptr}
+		, m_string_chars{nullptr} {
+#ifdef OW_MESH_CACHE_MMAP
+	int fd = ::open(cache_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat file_stat{};
+	if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+		void* addr = ::mmap(nullptr, static_cast<std::size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED) {
+			m_data = static_cast<const char*>(addr);
+			m_size = static_cast<std::size_t>(file_stat.st_size);
+			m_mapped = true;
+		}
+	}
+	::close(fd);
+#else
+	std::ifstream file(cache_filename, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file) {
+		return;
+	}
+	m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()))) {
+		return;
+	}
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+#endif
+
+	if (m_data && !_validate(expected_source_hash)) {
+		_release();
+	}
+}
+
+ow::mesh_cache::mesh_cache(mesh_cache&& other) noexcept
+		: m_data{std::exchange(other.m_data, nullptr)}
+		, m_size{std::exchange(other.m_size, 0)}
+		, m_mapped{std::exchange(other.m_mapped, false)}
+		, m_buffer(std::move(other.m_buffer))
+		, m_header{std::exchange(other.m_header, nullptr)}
+		, m_records{std::exchange(other.m_records, nullptr)}
+		, m_vertices{std::exchange(other.m_vertices, nullptr)}
+		, m_indices{std::exchange(other.m_indices, nullptr)}
+		, m_string_offsets{std::exchange(other.m_string_offsets, nullptr)}
+		, m_string_chars{std::exchange(other.m_string_chars, nullptr)} {}
+
+ow::mesh_cache::~mesh_cache() {
+	_release();
+}
+
+std::size_t ow::mesh_cache::mesh_count() const {
+	return m_header ? m_header->mesh_count : 0;
+}
+
+const ow::vertex* ow::mesh_cache::vertices(std::size_t mesh_idx) const {
+	return m_vertices + _record(mesh_idx).vertex_first;
+}
+
+std::size_t ow::mesh_cache::vertex_count(std::size_t mesh_idx) const {
+	return _record(mesh_idx).vertex_count;
+}
+
+const unsigned int* ow::mesh_cache::indices(std::size_t mesh_idx) const {
+	return m_indices + _record(mesh_idx).index_first;
+}
+
+std::size_t ow::mesh_cache::index_count(std::size_t mesh_idx) const {
+	return _record(mesh_idx).index_count;
+}
+
+std::vector<std::string> ow::mesh_cache::texture_names(std::size_t mesh_idx, texture_type type) const {
+	auto& record = _record(mesh_idx);
+	auto type_idx = static_cast<std::size_t>(type);
+
+	std::vector<std::string> names;
+	names.reserve(record.texture_count[type_idx]);
+	for (std::size_t i = record.texture_first[type_idx], end = i + record.texture_count[type_idx]; i < end; ++i) {
+		names.emplace_back(m_string_chars + m_string_offsets[i], m_string_offsets[i + 1] - m_string_offsets[i]);
+	}
+	return names;
+}
+
+std::string ow::mesh_cache::cache_filename_for(const std::string& model_filename) {
+	return model_filename + ".owcache";
+}
+
+bool ow::mesh_cache::_validate(std::uint64_t expected_source_hash) {
+	if (m_size < sizeof(mesh_cache_header)) {
+		return false;
+	}
+
+	auto header = reinterpret_cast<const mesh_cache_header*>(m_data);
+	if (header->magic != MAGIC
+		|| header->version != MESH_CACHE_VERSION
+		|| header->endianness != ENDIANNESS_MARKER
+		|| header->vertex_size != sizeof(vertex)
+		|| header->source_hash != expected_source_hash) {
+		return false;
+	}
+
+	auto s = compute_sections(*header);
+	if (s.end != m_size) {
+		logger << "Mesh cache has an unexpected size, ignoring it.\n";
+		return false;
+	}
+
+	// everything read later is checked here once: a corrupted file must not read out of bounds.
+	auto records = reinterpret_cast<const mesh_cache_record*>(m_data + s.records);
+	auto indices = reinterpret_cast<const unsigned int*>(m_data + s.indices);
+	auto string_offsets = reinterpret_cast<const std::uint64_t*>(m_data + s.string_offsets);
+	for (std::size_t i = 0; i < header->mesh_count; ++i) {
+		auto& record = records[i];
+		if (record.vertex_first > header->vertex_count
+			|| record.vertex_count > header->vertex_count - record.vertex_first
+			|| record.index_first > header->index_count
+			|| record.index_count > header->index_count - record.index_first) {
+			return false;
+		}
+		auto first = indices + record.index_first;
+		if (std::any_of(first, first + record.index_count, [&record] (unsigned int index) {
+			return index >= record.vertex_count;
+		})) {
+			logger << "Mesh cache has out of range indices, ignoring it.\n";
+			return false;
+		}
+		for (std::size_t type = 0; type < MESH_CACHE_TEXTURE_TYPES; ++type) {
+			if (std::uint64_t{record.texture_first[type]} + record.texture_count[type] > header->string_count) {
+				return false;
+			}
+		}
+	}
+	for (std::size_t i = 0; i < header->string_count; ++i) {
+		if (string_offsets[i] > string_offsets[i + 1]) {
+			return false;
+		}
+	}
+	if (string_offsets[header->string_count] != header->string_bytes) {
+		return false;
+	}
+
+	m_header = header;
+	m_records = records;
+	m_vertices = reinterpret_cast<const vertex*>(m_data + s.vertices);
+	m_indices = indices;
+	m_string_offsets = string_offsets;
+	m_string_chars = m_data + s.string_chars;
+	return true;
+}
+
+void ow::mesh_cache::_release() {
+#ifdef OW_MESH_CACHE_MMAP
+	if (m_mapped && m_data) {
+		::munmap(const_cast<char*>(m_data), m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;
+	m_buffer.clear();
+	m_header = nullptr;
+	m_records = nullptr;
+	m_vertices = nullptr;
+	m_indices = nullptr;
+	m_string_offsets = nullptr;
+	m_string_chars = nullptr;
+}
+
+const ow::mesh_cache_record& ow::mesh_cache::_record(std::size_t mesh_idx) const {
+	if (mesh_idx >= mesh_count()) {
+		throw std::out_of_range(
+				"[mesh_cache] Accessing mesh " + std::to_string(mesh_idx) + " (count is " + std::to_string(mesh_count()) + ")");
+	}
+	return m_records[mesh_idx];
+}
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <ow/mesh_optimizer.hpp>
+#include <ow/thread_pool.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	// cache modeled by the scoring function, bigger than real caches on purpose.
+	constexpr std::size_t FORSYTH_CACHE_SIZE = 32;
+	constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	// below this, welding on a single thread is faster than dispatching.
+	constexpr std::size_t WELD_PARALLEL_THRESHOLD = 1u << 15;
+	constexpr std::size_t WELD_CHUNK_SIZE = 1u << 13;
+
+	// welding cells are this many tolerances wide: only vertices closer than one tolerance
+	// to a cell border have to look in the neighbouring cells.
+	constexpr double WELD_CELL_SIZE = 4.0;
+	constexpr unsigned int NO_VERTEX = std::numeric_limits<unsigned int>::max();
+
+	// position, normal and texture coordinates, in welding cells.
+	using weld_point = std::array<double, 8>;
+	using weld_key = std::array<std::int64_t, 8>;
+
+	weld_point make_weld_point(const ow::vertex& v, double inv_cell_size) {
+		auto scale = [inv_cell_size] (float component) { return static_cast<double>(component) * inv_cell_size; };
+		return {
+			scale(v.position.x), scale(v.position.y), scale(v.position.z),
+			scale(v.normal.x), scale(v.normal.y), scale(v.normal.z),
+			scale(v.tex_coords.x), scale(v.tex_coords.y)
+		};
+	}
+
+	// cells are centered on multiples of their size, so that round values such as axis
+	// aligned normals sit in the middle of a cell.
+	weld_key make_weld_key(const weld_point& point) {
+		weld_key key{};
+		for (std::size_t c = 0; c < key.size(); ++c) {
+			key[c] = static_cast<std::int64_t>(std::llround(point[c]));
+		}
+		return key;
+	}
+
+	bool within_tolerance(const ow::vertex& lhs, const ow::vertex& rhs, float tolerance) {
+		glm::vec3 position = glm::abs(lhs.position - rhs.position);
+		glm::vec3 normal = glm::abs(lhs.normal - rhs.normal);
+		glm::vec2 tex_coords = glm::abs(lhs.tex_coords - rhs.tex_coords);
+		return position.x <= tolerance && position.y <= tolerance && position.z <= tolerance
+			   && normal.x <= tolerance && normal.y <= tolerance && normal.z <= tolerance
+			   && tex_coords.x <= tolerance && tex_coords.y <= tolerance;
+	}
+
+	struct weld_key_hash {
+		std::size_t operator()(const weld_key& key) const noexcept {
+			return static_cast<std::size_t>(ow::hash_bytes(key.data(), sizeof(weld_key)));
+		}
+	};
+
+	// calls body(begin, end) over chunks of [0, count), in parallel when count is big enough.
+	template <typename F>
+	void for_each_chunk(std::size_t count, F&& body) {
+		if (count < WELD_PARALLEL_THRESHOLD) {
+			body(std::size_t{0}, count);
+			return;
+		}
+		ow::thread_pool::global().parallel_for((count + WELD_CHUNK_SIZE - 1) / WELD_CHUNK_SIZE, [&] (std::size_t chunk) {
+			body(chunk * WELD_CHUNK_SIZE, std::min(count, (chunk + 1) * WELD_CHUNK_SIZE));
+		});
+	}
+
+	float forsyth_vertex_score(int cache_position, unsigned int remaining_triangles) {
+		if (remaining_triangles == 0) {
+			return -1.f; // not used anymore.
+		}
+
+		float score = 0.f;
+		if (cache_position >= 0) {
+			if (cache_position < 3) {
+				// used by the last triangle: fixed score so that strips are not favored too much.
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			} else {
+				float scaler = 1.f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.f - static_cast<float>(cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+
+		// boost vertices with few triangles left, to get rid of lone triangles early.
+		score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -FORSYTH_VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// number of cache misses for each triangle, with the FIFO cache of simulate_vertex_cache.
+	std::vector<unsigned int> triangle_misses(const std::vector<unsigned int>& indices, std::size_t vertex_count,
+											  std::size_t cache_size) {
+		std::vector<std::size_t> timestamps(vertex_count, 0);
+		std::size_t time = cache_size + 1;
+
+		std::vector<unsigned int> misses(indices.size() / 3, 0);
+		for (std::size_t i = 0; i < misses.size() * 3; ++i) {
+			auto idx = indices[i];
+			if (time - timestamps[idx] > cache_size) {
+				timestamps[idx] = time++;
+				++misses[i / 3];
+			}
+		}
+		return misses;
+	}
+}
+
+std::size_t ow::weld_vertices(std::vector<vertex>* vertices, std::vector<unsigned int>* indices, float tolerance) {
+	assert(tolerance > 0.f);
+	const std::size_t vertex_count = vertices->size();
+	const double inv_cell_size = 1.0 / (WELD_CELL_SIZE * static_cast<double>(tolerance));
+	// a coordinate further than this from the center of its cell is within tolerance of the next cell.
+	const double border = 0.5 - 1.0 / WELD_CELL_SIZE;
+
+	std::vector<weld_key> keys(vertex_count);
+	std::vector<std::size_t> hashes(vertex_count);
+	for_each_chunk(vertex_count, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			keys[i] = make_weld_key(make_weld_point((*vertices)[i], inv_cell_size));
+			hashes[i] = weld_key_hash{}(keys[i]);
+		}
+	});
+
+	// equal keys have equal hashes: partitioning the cells by hash lets each partition be
+	// filled independently. The vertices are bucketed by partition first (counting sort,
+	// which keeps them in order) so that each partition only visits its own.
+	const std::size_t partition_count = vertex_count < WELD_PARALLEL_THRESHOLD ? 1 : thread_pool::global().size() + 1;
+	std::vector<std::size_t> partition_begin(partition_count + 1, 0);
+	for (std::size_t i = 0; i < vertex_count; ++i) {
+		++partition_begin[hashes[i] % partition_count + 1];
+	}
+	std::partial_sum(partition_begin.begin(), partition_begin.end(), partition_begin.begin());
+	std::vector<unsigned int> by_partition(vertex_count);
+	{
+		std::vector<std::size_t> fill(partition_begin.begin(), partition_begin.end() - 1);
+		for (std::size_t i = 0; i < vertex_count; ++i) {
+			by_partition[fill[hashes[i] % partition_count]++] = static_cast<unsigned int>(i);
+		}
+	}
+
+	// each cell lists the first vertex of its groups, in order: cells are a few tolerances wide,
+	// they can hold several groups. A vertex joins the first group it is within tolerance of.
+	using cell_map = std::unordered_map<weld_key, unsigned int, weld_key_hash>;
+	std::vector<cell_map> cells(partition_count);
+	std::vector<unsigned int> next_in_cell(vertex_count, NO_VERTEX);
+	std::vector<unsigned int> representative(vertex_count);
+	auto fill_partition = [&] (std::size_t partition) {
+		cell_map& partition_cells = cells[partition];
+		partition_cells.reserve(partition_begin[partition + 1] - partition_begin[partition]);
+		for (std::size_t p = partition_begin[partition]; p < partition_begin[partition + 1]; ++p) {
+			const unsigned int i = by_partition[p];
+			auto [it, inserted] = partition_cells.try_emplace(keys[i], i);
+			representative[i] = i;
+			if (inserted) {
+				continue;
+			}
+			for (unsigned int group = it->second;; group = next_in_cell[group]) {
+				if (within_tolerance((*vertices)[group], (*vertices)[i], tolerance)) {
+					representative[i] = group;
+					break;
+				}
+				if (next_in_cell[group] == NO_VERTEX) {
+					next_in_cell[group] = i; // first of a new group
+					break;
+				}
+			}
+		}
+	};
+	if (partition_count == 1) {
+		fill_partition(0);
+	} else {
+		thread_pool::global().parallel_for(partition_count, fill_partition);
+	}
+
+	// groups near a cell border probe the neighbouring cells in that direction (and their
+	// combinations) for an earlier group to merge into. Cells are only read here.
+	auto earliest_match = [&] (const weld_key& key, unsigned int vertex_index) {
+		const cell_map& partition_cells = cells[weld_key_hash{}(key) % partition_count];
+		auto it = partition_cells.find(key);
+		if (it == partition_cells.end()) {
+			return NO_VERTEX;
+		}
+		for (unsigned int group = it->second; group != NO_VERTEX && group < vertex_index; group = next_in_cell[group]) {
+			if (within_tolerance((*vertices)[group], (*vertices)[vertex_index], tolerance)) {
+				return group;
+			}
+		}
+		return NO_VERTEX;
+	};
+	for_each_chunk(vertex_count, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			if (representative[i] != i) {
+				continue;
+			}
+
+			const weld_point point = make_weld_point((*vertices)[i], inv_cell_size);
+			std::array<std::size_t, 8> near_components{};
+			std::array<std::int64_t, 8> directions{};
+			std::size_t near_count = 0;
+			for (std::size_t c = 0; c < point.size(); ++c) {
+				double offset = point[c] - static_cast<double>(keys[i][c]);
+				if (std::abs(offset) > border) {
+					near_components[near_count] = c;
+					directions[near_count++] = offset > 0.0 ? 1 : -1;
+				}
+			}
+
+			unsigned int merged = NO_VERTEX;
+			for (std::size_t mask = 1; mask < (std::size_t{1} << near_count); ++mask) {
+				weld_key neighbour = keys[i];
+				for (std::size_t n = 0; n < near_count; ++n) {
+					if ((mask >> n) & 1u) {
+						neighbour[near_components[n]] += directions[n];
+					}
+				}
+				merged = std::min(merged, earliest_match(neighbour, static_cast<unsigned int>(i)));
+			}
+			if (merged != NO_VERTEX) {
+				representative[i] = merged;
+			}
+		}
+	});
+
+	// representatives come before the vertices merged into them: compact in a single ordered pass.
+	std::vector<unsigned int> remap(vertex_count);
+	std::size_t welded_count = 0;
+	for (std::size_t i = 0; i < vertex_count; ++i) {
+		if (representative[i] == i) {
+			(*vertices)[welded_count] = (*vertices)[i];
+			remap[i] = static_cast<unsigned int>(welded_count++);
+		} else {
+			remap[i] = remap[representative[i]];
+		}
+	}
+	vertices->erase(vertices->begin() + static_cast<std::ptrdiff_t>(welded_count), vertices->end());
+
+	for_each_chunk(indices->size(), [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			(*indices)[i] = remap[(*indices)[i]];
+		}
+	});
+
+	return welded_count;
+}
+
+ow::vertex_cache_stats ow::simulate_vertex_cache(const std::vector<unsigned int>& indices, std::size_t vertex_count,
+												 std::size_t cache_size) {
+	auto misses = triangle_misses(indices, vertex_count, cache_size);
+	std::size_t transformed = std::accumulate(misses.begin(), misses.end(), std::size_t{0});
+
+	return {
+		transformed,
+		misses.empty() ? 0.f : static_cast<float>(transformed) / static_cast<float>(misses.size()),
+		vertex_count == 0 ? 0.f : static_cast<float>(transformed) / static_cast<float>(vertex_count)
+	};
+}
+
+void ow::optimize_vertex_cache(std::vector<unsigned int>* indices, std::size_t vertex_count) {
+	const std::size_t triangle_count = indices->size() / 3;
+	if (triangle_count == 0 || indices->size() % 3 != 0) {
+		return;
+	}
+
+	// triangles using each vertex
+	std::vector<unsigned int> remaining(vertex_count, 0);
+	for (auto idx : *indices) {
+		assert(idx < vertex_count);
+		++remaining[idx];
+	}
+
+	std::vector<std::size_t> adjacency_offsets(vertex_count + 1, 0);
+	for (std::size_t v = 0; v < vertex_count; ++v) {
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + remaining[v];
+	}
+
+	std::vector<std::size_t> adjacency(indices->size());
+	{
+		std::vector<std::size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (std::size_t i = 0; i < indices->size(); ++i) {
+			adjacency[fill[(*indices)[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<int> cache_position(vertex_count, -1);
+	std::vector<float> vertex_score(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v) {
+		vertex_score[v] = forsyth_vertex_score(-1, remaining[v]);
+	}
+
+	std::vector<float> triangle_score(triangle_count);
+	for (std::size_t t = 0; t < triangle_count; ++t) {
+		triangle_score[t] = vertex_score[(*indices)[3 * t]]
+							+ vertex_score[(*indices)[3 * t + 1]]
+							+ vertex_score[(*indices)[3 * t + 2]];
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<unsigned int> result;
+	result.reserve(indices->size());
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> next_cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	std::size_t scan_cursor = 0;
+	auto best_triangle = std::numeric_limits<std::size_t>::max();
+	for (std::size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+		if (best_triangle == std::numeric_limits<std::size_t>::max()) {
+			// nothing left around the cache: restart from the first remaining triangle.
+			while (emitted[scan_cursor]) {
+				++scan_cursor;
+			}
+			best_triangle = scan_cursor;
+		}
+
+		const unsigned int* tri = indices->data() + 3 * best_triangle;
+		result.insert(result.end(), tri, tri + 3);
+		emitted[best_triangle] = true;
+
+		// the triangle doesn't need to be scored anymore.
+		for (std::size_t k = 0; k < 3; ++k) {
+			auto v = tri[k];
+			auto begin = adjacency.begin() + static_cast<std::ptrdiff_t>(adjacency_offsets[v]);
+			auto end = begin + remaining[v];
+			std::iter_swap(std::find(begin, end, best_triangle), end - 1);
+			--remaining[v];
+		}
+
+		// its vertices move to the front of the cache.
+		next_cache.assign(tri, tri + 3);
+		for (auto v : cache) {
+			if (v != tri[0] && v != tri[1] && v != tri[2]) {
+				next_cache.push_back(v);
+			}
+		}
+		std::swap(cache, next_cache);
+
+		for (std::size_t i = 0; i < cache.size(); ++i) {
+			auto v = cache[i];
+			cache_position[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+			float score = forsyth_vertex_score(cache_position[v], remaining[v]);
+			float diff = score - vertex_score[v];
+			vertex_score[v] = score;
+			for (std::size_t a = adjacency_offsets[v], end = a + remaining[v]; a < end; ++a) {
+				triangle_score[adjacency[a]] += diff;
+			}
+		}
+		if (cache.size() > FORSYTH_CACHE_SIZE) {
+			cache.resize(FORSYTH_CACHE_SIZE);
+		}
+
+		// next triangle: best one using a vertex in cache.
+		best_triangle = std::numeric_limits<std::size_t>::max();
+		float best_score = -1.f;
+		for (auto v : cache) {
+			for (std::size_t a = adjacency_offsets[v], end = a + remaining[v]; a < end; ++a) {
+				if (triangle_score[adjacency[a]] > best_score) {
+					best_score = triangle_score[adjacency[a]];
+					best_triangle = adjacency[a];
+				}
+			}
+		}
+	}
+
+	*indices = std::move(result);
+}
+
+void ow::optimize_overdraw(std::vector<unsigned int>* indices, const std::vector<vertex>& vertices, float threshold,
+						   std::size_t cache_size) {
+	const std::size_t triangle_count = indices->size() / 3;
+	if (triangle_count == 0 || indices->size() % 3 != 0) {
+		return;
+	}
+
+	auto misses = triangle_misses(*indices, vertices.size(), cache_size);
+
+	// hard boundaries: the cache is cold again (every vertex of the triangle missed),
+	// so moving what follows elsewhere doesn't cost anything.
+	std::vector<std::size_t> hard_clusters;
+	for (std::size_t t = 0; t < triangle_count; ++t) {
+		if (t == 0 || misses[t] == 3) {
+			hard_clusters.push_back(t);
+		}
+	}
+	hard_clusters.push_back(triangle_count);
+
+	// soft boundaries: split a hard cluster as soon as the part behind has an ACMR
+	// close enough (threshold) to the one of the whole cluster.
+	std::vector<std::size_t> clusters;
+	for (std::size_t c = 0; c + 1 < hard_clusters.size(); ++c) {
+		std::size_t begin = hard_clusters[c];
+		std::size_t end = hard_clusters[c + 1];
+
+		unsigned int cluster_misses = std::accumulate(misses.begin() + static_cast<std::ptrdiff_t>(begin),
+													  misses.begin() + static_cast<std::ptrdiff_t>(end), 0u);
+		float cluster_acmr = static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+		clusters.push_back(begin);
+		unsigned int running_misses = 0;
+		std::size_t running_begin = begin;
+		for (std::size_t t = begin; t < end; ++t) {
+			running_misses += misses[t];
+			float running_acmr = static_cast<float>(running_misses) / static_cast<float>(t + 1 - running_begin);
+			if (t + 1 < end && running_acmr <= cluster_acmr * threshold) {
+				clusters.push_back(t + 1);
+				running_misses = 0;
+				running_begin = t + 1;
+			}
+		}
+	}
+	clusters.push_back(triangle_count);
+
+	// sort key: how much each cluster faces away from the center of the mesh.
+	auto position = [&] (std::size_t i) { return vertices[(*indices)[i]].position; };
+
+	glm::vec3 mesh_centroid{0.f};
+	float mesh_area = 0.f;
+	for (std::size_t t = 0; t < triangle_count; ++t) {
+		glm::vec3 p0 = position(3 * t), p1 = position(3 * t + 1), p2 = position(3 * t + 2);
+		float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+		mesh_centroid += (p0 + p1 + p2) * (area / 3.f);
+		mesh_area += area;
+	}
+	if (mesh_area > 0.f) {
+		mesh_centroid /= mesh_area;
+	}
+
+	std::vector<float> keys(clusters.size() - 1);
+	for (std::size_t c = 0; c + 1 < clusters.size(); ++c) {
+		glm::vec3 centroid{0.f};
+		glm::vec3 normal{0.f};
+		float area_sum = 0.f;
+		for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			glm::vec3 p0 = position(3 * t), p1 = position(3 * t + 1), p2 = position(3 * t + 2);
+			glm::vec3 area_normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(area_normal);
+			centroid += (p0 + p1 + p2) * (area / 3.f);
+			normal += area_normal;
+			area_sum += area;
+		}
+
+		float normal_length = glm::length(normal);
+		keys[c] = area_sum > 0.f && normal_length > 0.f
+				  ? glm::dot(centroid / area_sum - mesh_centroid, normal / normal_length)
+				  : 0.f;
+	}
+
+	std::vector<std::size_t> order(keys.size());
+	std::iota(order.begin(), order.end(), std::size_t{0});
+	std::stable_sort(order.begin(), order.end(), [&keys] (std::size_t lhs, std::size_t rhs) {
+		return keys[lhs] > keys[rhs];
+	});
+
+	std::vector<unsigned int> result;
+	result.reserve(indices->size());
+	for (auto c : order) {
+		result.insert(result.end(),
+					  indices->begin() + static_cast<std::ptrdiff_t>(3 * clusters[c]),
+					  indices->begin() + static_cast<std::ptrdiff_t>(3 * clusters[c + 1]));
+	}
+	*indices = std::move(result);
+}
+
+std::size_t ow::optimize_vertex_fetch(std::vector<vertex>* vertices, std::vector<unsigned int>* indices) {
+	constexpr auto unused = std::numeric_limits<unsigned int>::max();
+	std::vector<unsigned int> remap(vertices->size(), unused);
+
+	std::vector<vertex> reordered;
+	reordered.reserve(vertices->size());
+	for (auto& idx : *indices) {
+		if (remap[idx] == unused) {
+			remap[idx] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back((*vertices)[idx]);
+		}
+		idx = remap[idx];
+	}
+
+	*vertices = std::move(reordered);
+	return vertices->size();
+}
+
+ow::mesh_optimization_report ow::optimize_mesh(std::vector<vertex>* vertices, std::vector<unsigned int>* indices,
+											   float overdraw_threshold) {
+	mesh_optimization_report report{};
+	report.before = simulate_vertex_cache(*indices, vertices->size());
+
+	optimize_vertex_cache(indices, vertices->size());
+	optimize_overdraw(indices, *vertices, overdraw_threshold);
+	optimize_vertex_fetch(vertices, indices);
+
+	report.after = simulate_vertex_cache(*indices, vertices->size());
+	return report;
+}
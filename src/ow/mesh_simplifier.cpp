@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <ow/mesh_optimizer.hpp>
+#include <ow/mesh_simplifier.hpp>
+
+namespace {
+	// cosine of the largest rotation a collapse may apply to a triangle.
+	constexpr float MAX_FLIP_COSINE = 0.25f;
+
+	// a level removing less than that is not worth storing.
+	constexpr float MIN_LOD_REDUCTION = 0.9f;
+
+	// sum of the squared distances to a set of planes, weighted by triangle area.
+	struct quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+
+		void add_plane(glm::vec3 normal, double d, double w) {
+			double x = normal.x, y = normal.y, z = normal.z;
+			a00 += w * x * x; a01 += w * x * y; a02 += w * x * z;
+			a11 += w * y * y; a12 += w * y * z; a22 += w * z * z;
+			b0 += w * x * d; b1 += w * y * d; b2 += w * z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		quadric& operator+=(const quadric& o) {
+			a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+			b0 += o.b0; b1 += o.b1; b2 += o.b2;
+			c += o.c;
+			weight += o.weight;
+			return *this;
+		}
+
+		// root mean square distance of p to the planes.
+		float error(glm::vec3 p) const {
+			if (weight <= 0) {
+				return 0.f;
+			}
+			double x = p.x, y = p.y, z = p.z;
+			double squared = x * (a00 * x + a01 * y + a02 * z)
+							 + y * (a01 * x + a11 * y + a12 * z)
+							 + z * (a02 * x + a12 * y + a22 * z)
+							 + 2 * (b0 * x + b1 * y + b2 * z) + c;
+			return static_cast<float>(std::sqrt(std::max(squared, 0.0) / weight));
+		}
+	};
+
+	struct collapse {
+		unsigned int from; // position ids
+		unsigned int to;
+		float error;
+	};
+
+	// id of the first vertex with the same position, for every vertex.
+	std::vector<unsigned int> position_ids(const std::vector<ow::vertex>& vertices) {
+		struct position_hash {
+			std::size_t operator()(const std::array<std::uint32_t, 3>& key) const noexcept {
+				return key[0] * 73856093u ^ key[1] * 19349663u ^ key[2] * 83492791u;
+			}
+		};
+
+		std::unordered_map<std::array<std::uint32_t, 3>, unsigned int, position_hash> first_of;
+		first_of.reserve(vertices.size());
+
+		std::vector<unsigned int> ids(vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i) {
+			std::array<std::uint32_t, 3> key;
+			std::memcpy(key.data(), &vertices[i].position, sizeof(key));
+			ids[i] = first_of.try_emplace(key, static_cast<unsigned int>(i)).first->second;
+		}
+		return ids;
+	}
+
+	std::uint64_t edge_key(unsigned int a, unsigned int b) {
+		return a < b ? (std::uint64_t{a} << 32) | b : (std::uint64_t{b} << 32) | a;
+	}
+
+	glm::vec3 bounding_box_extent(const std::vector<ow::vertex>& vertices) {
+		if (vertices.empty()) {
+			return glm::vec3{0.f};
+		}
+		glm::vec3 min = vertices.front().position;
+		glm::vec3 max = min;
+		for (auto& v : vertices) {
+			min = glm::min(min, v.position);
+			max = glm::max(max, v.position);
+		}
+		return max - min;
+	}
+}
+
+ow::simplify_result ow::simplify(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+								 std::size_t target_index_count, float max_error) {
+	simplify_result result{indices, 0.f};
+	auto& current = result.indices;
+	if (current.size() <= target_index_count || current.size() % 3 != 0) {
+		return result;
+	}
+
+	const std::size_t vertex_count = vertices.size();
+	auto pos_id = position_ids(vertices);
+	auto position = [&] (unsigned int id) { return vertices[id].position; };
+
+	// wedges: vertices sharing a position, as rings.
+	std::vector<unsigned int> next_wedge(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v) {
+		next_wedge[v] = static_cast<unsigned int>(v);
+		if (pos_id[v] != v) {
+			std::swap(next_wedge[v], next_wedge[pos_id[v]]);
+		}
+	}
+
+	// quadrics and borders are computed once on the input surface.
+	std::vector<quadric> quadrics(vertex_count);
+	std::unordered_map<std::uint64_t, unsigned int> edge_uses;
+	edge_uses.reserve(current.size());
+	for (std::size_t t = 0; t < current.size(); t += 3) {
+		unsigned int p[3] = {pos_id[current[t]], pos_id[current[t + 1]], pos_id[current[t + 2]]};
+		glm::vec3 p0 = position(p[0]), p1 = position(p[1]), p2 = position(p[2]);
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(normal);
+		if (area > 0.f) {
+			normal /= area;
+			for (auto id : p) {
+				quadrics[id].add_plane(normal, -glm::dot(normal, p0), area);
+			}
+		}
+		for (int k = 0; k < 3; ++k) {
+			++edge_uses[edge_key(p[k], p[(k + 1) % 3])];
+		}
+	}
+
+	// open or non manifold edges stay where they are.
+	std::vector<bool> locked(vertex_count, false);
+	for (auto& [key, uses] : edge_uses) {
+		if (uses != 2) {
+			locked[static_cast<unsigned int>(key >> 32)] = true;
+			locked[static_cast<unsigned int>(key & 0xffffffffu)] = true;
+		}
+	}
+
+	std::vector<unsigned int> remap(vertex_count);
+	std::vector<std::size_t> adjacency_offsets(vertex_count + 1);
+	std::vector<std::size_t> adjacency;
+	std::vector<bool> touched(vertex_count);
+	std::vector<collapse> candidates;
+
+	std::size_t triangle_count = current.size() / 3;
+	const std::size_t target_triangle_count = target_index_count / 3;
+
+	// each pass collapses independent vertices in increasing error order, then rebuilds.
+	for (bool progress = true; progress && triangle_count > target_triangle_count;) {
+		progress = false;
+
+		// triangles around each position
+		std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+		for (auto idx : current) {
+			++adjacency_offsets[pos_id[idx] + 1];
+		}
+		for (std::size_t v = 0; v < vertex_count; ++v) {
+			adjacency_offsets[v + 1] += adjacency_offsets[v];
+		}
+		adjacency.resize(current.size());
+		{
+			std::vector<std::size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+			for (std::size_t i = 0; i < current.size(); ++i) {
+				adjacency[fill[pos_id[current[i]]]++] = i / 3;
+			}
+		}
+		auto triangles_around = [&] (unsigned int id, auto&& body) {
+			for (std::size_t a = adjacency_offsets[id]; a < adjacency_offsets[id + 1]; ++a) {
+				body(adjacency[a]);
+			}
+		};
+
+		// one candidate per edge, in its cheapest direction.
+		candidates.clear();
+		for (std::size_t i = 0; i < current.size(); ++i) {
+			unsigned int a = pos_id[current[i]];
+			unsigned int b = pos_id[current[i - i % 3 + (i + 1) % 3]];
+			if (a >= b) {
+				continue; // each edge once (or degenerate).
+			}
+
+			quadric merged = quadrics[a];
+			merged += quadrics[b];
+			float a_to_b = locked[a] ? std::numeric_limits<float>::max() : merged.error(position(b));
+			float b_to_a = locked[b] ? std::numeric_limits<float>::max() : merged.error(position(a));
+			if (std::min(a_to_b, b_to_a) <= max_error) {
+				candidates.push_back(a_to_b <= b_to_a ? collapse{a, b, a_to_b} : collapse{b, a, b_to_a});
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [] (const collapse& lhs, const collapse& rhs) {
+			return lhs.error < rhs.error;
+		});
+
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), false);
+
+		for (auto& candidate : candidates) {
+			if (triangle_count <= target_triangle_count) {
+				break;
+			}
+			if (touched[candidate.from] || touched[candidate.to]) {
+				continue;
+			}
+
+			// every wedge of `from` must have a wedge of `to` in one of its triangles,
+			// otherwise the collapse would tear a seam open.
+			bool valid = true;
+			unsigned int w = candidate.from;
+			do {
+				unsigned int target = std::numeric_limits<unsigned int>::max();
+				bool used = false;
+				triangles_around(candidate.from, [&] (std::size_t t) {
+					const unsigned int* tri = current.data() + 3 * t;
+					if (tri[0] != w && tri[1] != w && tri[2] != w) {
+						return;
+					}
+					used = true;
+					for (int k = 0; k < 3; ++k) {
+						if (pos_id[tri[k]] == candidate.to) {
+							target = tri[k];
+						}
+					}
+				});
+				if (used && target == std::numeric_limits<unsigned int>::max()) {
+					valid = false;
+					break;
+				}
+				remap[w] = used ? target : w;
+				w = next_wedge[w];
+			} while (w != candidate.from);
+
+			// triangles moving with `from` must not flip, removed ones are counted meanwhile.
+			std::size_t removed = 0;
+			triangles_around(candidate.from, [&] (std::size_t t) {
+				unsigned int p[3] = {pos_id[current[3 * t]], pos_id[current[3 * t + 1]], pos_id[current[3 * t + 2]]};
+				if (p[0] == candidate.to || p[1] == candidate.to || p[2] == candidate.to) {
+					++removed;
+					return;
+				}
+
+				glm::vec3 before[3] = {position(p[0]), position(p[1]), position(p[2])};
+				glm::vec3 after[3] = {before[0], before[1], before[2]};
+				for (int k = 0; k < 3; ++k) {
+					if (p[k] == candidate.from) {
+						after[k] = position(candidate.to);
+					}
+				}
+				glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+				// flipped, rotated too much, or folded onto a line.
+				float area_before = glm::length(normal_before);
+				float area_after = glm::length(normal_after);
+				if ((area_before > 0.f && !(area_after > 0.f))
+						|| glm::dot(normal_before, normal_after) < MAX_FLIP_COSINE * area_before * area_after) {
+					valid = false;
+				}
+			});
+
+			if (!valid) {
+				// undo the partial wedge mapping.
+				w = candidate.from;
+				do {
+					remap[w] = w;
+					w = next_wedge[w];
+				} while (w != candidate.from);
+				continue;
+			}
+
+			quadrics[candidate.to] += quadrics[candidate.from];
+			touched[candidate.from] = true;
+			touched[candidate.to] = true;
+			triangles_around(candidate.from, [&] (std::size_t t) {
+				for (int k = 0; k < 3; ++k) {
+					touched[pos_id[current[3 * t + k]]] = true;
+				}
+			});
+
+			triangle_count -= removed;
+			result.error = std::max(result.error, candidate.error);
+			progress = true;
+		}
+
+		// apply the collapses and drop the triangles which became degenerate.
+		std::size_t kept = 0;
+		for (std::size_t t = 0; t < current.size(); t += 3) {
+			unsigned int a = remap[current[t]], b = remap[current[t + 1]], c = remap[current[t + 2]];
+			if (pos_id[a] != pos_id[b] && pos_id[b] != pos_id[c] && pos_id[a] != pos_id[c]) {
+				current[kept++] = a;
+				current[kept++] = b;
+				current[kept++] = c;
+			}
+		}
+		current.resize(kept);
+		triangle_count = kept / 3;
+	}
+
+	return result;
+}
+
+std::vector<ow::lod_level> ow::build_lod_chain(const std::vector<vertex>& vertices, const std::vector<unsigned int>& indices,
+											   const lod_settings& settings) {
+	std::vector<lod_level> levels;
+	levels.push_back({indices, 0.f});
+
+	float max_error = settings.max_error * glm::length(bounding_box_extent(vertices));
+	while (levels.size() < settings.max_levels) {
+		const lod_level& previous = levels.back();
+		auto target = static_cast<std::size_t>(static_cast<float>(previous.indices.size()) * settings.reduction);
+		target -= target % 3;
+
+		// errors of successive levels add up: each one gets what is left of the budget.
+		auto simplified = simplify(vertices, previous.indices, target, max_error - previous.error);
+		if (simplified.indices.empty()
+				|| static_cast<float>(simplified.indices.size()) > MIN_LOD_REDUCTION * static_cast<float>(previous.indices.size())) {
+			break;
+		}
+
+		optimize_vertex_cache(&simplified.indices, vertices.size());
+		levels.push_back({std::move(simplified.indices), previous.error + simplified.error});
+	}
+	return levels;
+}
+
+float ow::projected_error(float error, float distance, float fov, float viewport_height) {
+	// height of the view frustum at that distance, mapped on the viewport.
+	float frustum_height = 2.f * std::max(distance, std::numeric_limits<float>::epsilon()) * std::tan(fov / 2.f);
+	return error / frustum_height * viewport_height;
+}
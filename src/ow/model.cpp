@@ -1,54 +1,451 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <ow/gl_state.hpp>
+#include <ow/image.hpp>
 #include <ow/model.hpp>
+#include <ow/mesh_cache.hpp>
+#include <ow/mesh_optimizer.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/texture_registry.hpp>
+#include <ow/thread_pool.hpp>
 #include <ow/utils.hpp>
 
-ow::model::model(const std::string& path)
+namespace {
+	constexpr std::array<ow::texture_type, ow::MESH_CACHE_TEXTURE_TYPES> TEXTURE_TYPES = {
+		ow::texture_type::diffuse,
+		ow::texture_type::specular,
+		ow::texture_type::emission
+	};
+
+	// material libraries of a Wavefront .obj, which the cached meshes depend on as well.
+	std::vector<std::string> material_libraries(const std::string& path) {
+		std::vector<std::string> libraries;
+		auto dot = path.find_last_of('.');
+		std::string extension = dot == std::string::npos ? std::string{} : path.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [] (unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		if (extension != "obj") {
+			return libraries;
+		}
+
+		auto slash = path.find_last_of('/');
+		std::string directory = slash == std::string::npos ? std::string{} : path.substr(0, slash + 1);
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.compare(0, 7, "mtllib ") == 0) {
+				auto end = line.find_last_not_of(" \t\r");
+				libraries.push_back(directory + line.substr(7, end == std::string::npos ? 0 : end - 6));
+			}
+		}
+		return libraries;
+	}
+}
+
+struct ow::model::streaming_state {
+	std::mutex mutex{};
+	std::vector<mesh_data> meshes{};       // imported, waiting for their textures or for upload
+	std::map<std::string, image> images{}; // decoded, waiting for upload
+	std::set<std::string> decoding{};      // images still being decoded
+	bool imported = false;
+
+	// only used by the OpenGL thread.
+	bool arena_reserved = false;
+	// textures of the meshes not uploaded yet: the registry only keeps weak references.
+	std::map<std::pair<std::string, texture_type>, std::shared_ptr<texture>> uploaded{};
+};
+
+ow::model::model(const std::string& path, model_options options)
 		: m_meshes{}
-		, m_directory{}
+		, m_arena{options.packed ? std::make_unique<mesh_arena>() : nullptr}
+		, m_directory{path.substr(0, path.find_last_of('/'))}
+		, m_streaming{}
+		, m_pixel_unpack_buffer{0}
+		, m_world_bounds()
+		, m_visibility()
+		, m_instances()
 {
-	load_model(path);
+	if (options.mode == model_load_mode::streaming) {
+		start_streaming(path, options);
+	} else {
+		load_model(path, options);
+	}
+}
+
+ow::model::model(model&& other) noexcept
+		: m_meshes{std::move(other.m_meshes)}
+		, m_arena{std::move(other.m_arena)}
+		, m_directory{std::move(other.m_directory)}
+		, m_streaming{std::move(other.m_streaming)}
+		, m_pixel_unpack_buffer{std::exchange(other.m_pixel_unpack_buffer, 0)}
+		, m_world_bounds()
+		, m_visibility()
+		, m_instances(std::move(other.m_instances)) {}
+
+ow::model::~model() {
+	if (m_pixel_unpack_buffer != 0) {
+		gl_state::current().delete_buffer(m_pixel_unpack_buffer);
+		check_errors("error while deleting pixel unpack buffer. ");
+	}
 }
 
 void ow::model::draw(const shader_program& prog) const {
+	if (m_arena) {
+		m_arena->draw(prog);
+	}
 	for (auto& mesh : m_meshes) {
 		mesh.draw(prog);
 	}
 }
 
-void ow::model::load_model(const std::string& path) {
+void ow::model::draw(const shader_program& prog, const frustum& view_frustum, const glm::mat4& model_matrix,
+					 culling_stats* stats) const {
+	// arena meshes first, then the others.
+	std::size_t arena_size = m_arena ? m_arena->size() : 0;
+	m_world_bounds.clear();
+	for (std::size_t i = 0; i < arena_size; ++i) {
+		m_world_bounds.push_back(transform(m_arena->bounds(i), model_matrix));
+	}
+	for (auto& mesh : m_meshes) {
+		m_world_bounds.push_back(transform(mesh.get_bounding_sphere(), model_matrix));
+	}
+
+	culling_stats culled = cull_spheres(view_frustum, m_world_bounds, &m_visibility);
+	if (stats) {
+		stats->visible += culled.visible;
+		stats->culled += culled.culled;
+	}
+
+	if (m_arena) {
+		m_arena->draw(prog, m_visibility.data());
+	}
+	for (std::size_t i = 0; i < m_meshes.size(); ++i) {
+		if (m_visibility[arena_size + i]) {
+			m_meshes[i].draw(prog);
+		}
+	}
+}
+
+void ow::model::draw_instanced(const shader_program& prog, const std::vector<instance>& instances) const {
+	if (instances.empty()) {
+		return;
+	}
+
+	// uploaded once, shared by all the meshes.
+	if (!m_instances) {
+		m_instances = std::make_unique<instance_buffer>();
+	}
+	m_instances->set_data(instances);
+
+	if (m_arena) {
+		m_arena->draw_instanced(prog, *m_instances);
+	}
+	for (auto& mesh : m_meshes) {
+		mesh.draw_instanced(prog, *m_instances);
+	}
+}
+
+bool ow::model::stream(std::chrono::microseconds budget) {
+	if (!m_streaming) {
+		return true;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + budget;
+	auto& registry = texture_registry::global();
+	auto& state = *m_streaming;
+
+	if (m_pixel_unpack_buffer == 0) {
+		glGenBuffers(1, &m_pixel_unpack_buffer);
+		check_errors("error while generating pixel unpack buffer. ");
+	}
+
+	// the budget is checked before each upload once something was uploaded.
+	bool uploaded_any = false;
+	auto out_of_time = [&uploaded_any, deadline] {
+		return uploaded_any && std::chrono::steady_clock::now() >= deadline;
+	};
+
+	do {
+		// only this thread removes meshes, and the workers don't touch them once imported:
+		// ready stays valid after the lock is released.
+		std::size_t ready = 0;
+		texture_names names;
+		std::size_t reserved_vertices = 0;
+		std::size_t reserved_indices = 0;
+		{
+			std::lock_guard<std::mutex> lock{state.mutex};
+			auto it = std::find_if(state.meshes.begin(), state.meshes.end(), [&state] (const mesh_data& candidate) {
+				return std::none_of(candidate.textures.begin(), candidate.textures.end(), [&state] (auto& type_names) {
+					return std::any_of(type_names.begin(), type_names.end(), [&state] (auto& name) {
+						return state.decoding.count(name) != 0;
+					});
+				});
+			});
+
+			if (it == state.meshes.end()) {
+				if (state.imported && state.meshes.empty()) {
+					break; // done.
+				}
+				return false; // wait for the worker threads.
+			}
+			ready = static_cast<std::size_t>(it - state.meshes.begin());
+			names = it->textures;
+
+			if (m_arena && state.imported && !state.arena_reserved) {
+				for (auto& pending : state.meshes) {
+					reserved_vertices += pending.vertex_count();
+					reserved_indices += pending.index_count();
+				}
+			}
+		}
+
+		if (m_arena && state.imported && !state.arena_reserved) {
+			// allocate the whole model at once instead of growing the buffers mesh after mesh.
+			m_arena->reserve(reserved_vertices, reserved_indices);
+			state.arena_reserved = true;
+		}
+
+		// textures one by one: a mesh whose textures don't fit in the budget is finished by
+		// the next calls.
+		for (auto type : TEXTURE_TYPES) {
+			for (auto& name : names[static_cast<std::size_t>(type)]) {
+				auto& uploaded = state.uploaded[{name, type}];
+				if (uploaded) {
+					continue;
+				}
+				if (out_of_time()) {
+					return false;
+				}
+
+				// the workers insert images concurrently, so the lookup takes the lock. The image
+				// itself is read without it: images are never removed from the map while streaming,
+				// and std::map doesn't invalidate references on insertion.
+				const image* decoded = nullptr;
+				{
+					std::lock_guard<std::mutex> lock{state.mutex};
+					auto it = state.images.find(name);
+					decoded = it != state.images.end() ? &it->second : nullptr;
+				}
+				std::string filename = m_directory + '/' + name;
+				uploaded = decoded ? registry.get(filename, type, *decoded, m_pixel_unpack_buffer)
+								   : registry.get(filename, type);
+				uploaded_any = true;
+			}
+		}
+		if (out_of_time()) {
+			return false;
+		}
+
+		mesh_data data;
+		{
+			std::lock_guard<std::mutex> lock{state.mutex};
+			data = std::move(state.meshes[ready]);
+			state.meshes.erase(state.meshes.begin() + static_cast<std::ptrdiff_t>(ready));
+		}
+
+		std::array<std::vector<std::shared_ptr<texture>>, MESH_CACHE_TEXTURE_TYPES> maps;
+		for (auto type : TEXTURE_TYPES) {
+			for (auto& name : data.textures[static_cast<std::size_t>(type)]) {
+				maps[static_cast<std::size_t>(type)].push_back(state.uploaded[{name, type}]);
+			}
+		}
+
+		add_mesh(std::move(data), std::move(maps));
+		uploaded_any = true;
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	{
+		std::lock_guard<std::mutex> lock{state.mutex};
+		if (!state.imported || !state.meshes.empty()) {
+			return false;
+		}
+	}
+
+	// everything is uploaded: release the staging resources.
+	m_streaming.reset();
+	gl_state::current().delete_buffer(m_pixel_unpack_buffer);
+	check_errors("error while deleting pixel unpack buffer. ");
+	m_pixel_unpack_buffer = 0;
+	return true;
+}
+
+void ow::model::load_model(const std::string& path, const model_options& options) {
+	build_meshes(import_meshes(path, options));
+}
+
+void ow::model::start_streaming(const std::string& path, const model_options& options) {
+	m_streaming = std::make_shared<streaming_state>();
+
+	// the tasks only hold the shared state: the model may be destroyed or moved meanwhile.
+	thread_pool::global().submit([state = m_streaming, directory = m_directory, path, options] {
+		std::vector<mesh_data> meshes = import_meshes(path, options);
+
+		auto& registry = texture_registry::global();
+		std::set<std::string> to_decode;
+		for (auto& data : meshes) {
+			for (auto type : TEXTURE_TYPES) {
+				for (auto& name : data.textures[static_cast<std::size_t>(type)]) {
+					if (!registry.find(directory + '/' + name, type)) {
+						to_decode.insert(name);
+					}
+				}
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{state->mutex};
+			state->meshes = std::move(meshes);
+			state->decoding = to_decode;
+			state->imported = true;
+		}
+
+		// one task per image, so that they are decoded in parallel.
+		for (auto& name : to_decode) {
+			thread_pool::global().submit([state, name, filename = directory + '/' + name] {
+				image img = image::load(filename);
+				if (!img) {
+					logger << "Failed to load texture " << filename << '\n';
+				}
+
+				std::lock_guard<std::mutex> lock{state->mutex};
+				state->images.emplace(name, std::move(img));
+				state->decoding.erase(name);
+			});
+		}
+	});
+}
+
+std::vector<ow::model::mesh_data> ow::model::import_meshes(const std::string& path, const model_options& options) {
+	std::uint64_t source_hash = 0;
+	std::string cache_filename;
+	std::vector<mesh_data> meshes;
+	if (options.use_cache) {
+		// the materials and the import settings change the cached data as well.
+		source_hash = hash_file(path);
+		for (auto& library : material_libraries(path)) {
+			std::uint64_t library_hash = hash_file(library);
+			source_hash = hash_bytes(&library_hash, sizeof(library_hash), hash_string(library, source_hash));
+		}
+		const bool import_settings[] = {options.weld, options.optimize};
+		source_hash = hash_bytes(import_settings, sizeof(import_settings), source_hash);
+		cache_filename = mesh_cache::cache_filename_for(path);
+
+		auto cache = std::make_shared<const mesh_cache>(cache_filename, source_hash);
+		if (*cache) {
+			load_cache(cache, &meshes);
+			return meshes;
+		}
+	}
+
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
 
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
 		logger << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-		return;
+		return meshes;
+	}
+
+	process_node(scene->mRootNode, scene, &meshes);
+
+	if (options.weld) {
+		weld_meshes(path, &meshes);
+	}
+	if (options.optimize) {
+		optimize_meshes(path, &meshes);
+	}
+
+	if (options.use_cache) {
+		mesh_cache_writer cache_writer;
+		for (auto& data : meshes) {
+			cache_writer.add_mesh(data.vertices, data.indices, data.textures);
+		}
+		cache_writer.write(cache_filename, source_hash); // failures are logged, the import is still valid
+	}
+
+	return meshes;
+}
+
+void ow::model::weld_meshes(const std::string& path, std::vector<mesh_data>* meshes) {
+	std::size_t before = 0;
+	std::size_t after = 0;
+	for (auto& data : *meshes) {
+		before += data.vertices.size();
+		after += weld_vertices(&data.vertices, &data.indices);
+	}
+
+	if (after < before) {
+		logger << "Welded " << path << ": " << before << " -> " << after << " vertices\n";
+	}
+}
+
+void ow::model::optimize_meshes(const std::string& path, std::vector<mesh_data>* meshes) {
+	std::size_t triangles = 0;
+	std::size_t vertices_before = 0;
+	std::size_t vertices_after = 0;
+	std::size_t transformed_before = 0;
+	std::size_t transformed_after = 0;
+	for (auto& data : *meshes) {
+		vertices_before += data.vertices.size();
+		triangles += data.indices.size() / 3;
+
+		auto report = optimize_mesh(&data.vertices, &data.indices);
+		transformed_before += report.before.transformed_vertices;
+		transformed_after += report.after.transformed_vertices;
+		// the fetch pass drops the unreferenced vertices.
+		vertices_after += data.vertices.size();
+	}
+
+	if (triangles > 0 && vertices_before > 0 && vertices_after > 0) {
+		auto ratio = [] (std::size_t num, std::size_t den) { return static_cast<float>(num) / static_cast<float>(den); };
+		logger << "Optimized " << path << ": ACMR " << ratio(transformed_before, triangles)
+			   << " -> " << ratio(transformed_after, triangles)
+			   << ", ATVR " << ratio(transformed_before, vertices_before)
+			   << " -> " << ratio(transformed_after, vertices_after) << '\n';
 	}
-	m_directory = path.substr(0, path.find_last_of('/'));
+}
 
-	process_node(scene->mRootNode, scene);
+void ow::model::load_cache(const std::shared_ptr<const mesh_cache>& cache, std::vector<mesh_data>* meshes) {
+	meshes->reserve(cache->mesh_count());
+	for (std::size_t i = 0; i < cache->mesh_count(); ++i) {
+		mesh_data data{};
+		data.cache = cache;
+		data.cache_mesh = i;
+		for (auto type : TEXTURE_TYPES) {
+			data.textures[static_cast<std::size_t>(type)] = cache->texture_names(i, type);
+		}
+		meshes->push_back(std::move(data));
+	}
 }
 
-void ow::model::process_node(aiNode* node, const aiScene *scene) {
+void ow::model::process_node(aiNode* node, const aiScene *scene, std::vector<mesh_data>* meshes) {
 	// process all the node's meshes (if any)
 	for(unsigned int i = 0; i < node->mNumMeshes; ++i) {
-		process_mesh(scene->mMeshes[node->mMeshes[i]], scene);
+		process_mesh(scene->mMeshes[node->mMeshes[i]], scene, meshes);
 	}
 	// then do the same for each of its children
 	for(unsigned int i = 0; i < node->mNumChildren; ++i) {
-		process_node(node->mChildren[i], scene);
+		process_node(node->mChildren[i], scene, meshes);
 	}
 }
 
-void ow::model::process_mesh(aiMesh* mesh, const aiScene *scene) {
+void ow::model::process_mesh(aiMesh* mesh, const aiScene *scene, std::vector<mesh_data>* meshes) {
 	std::vector<vertex> vertices;
 	std::vector<unsigned int> indices;
 
 	// vertices
+	vertices.reserve(mesh->mNumVertices);
 	for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
 		glm::vec3 pos{
 			mesh->mVertices[i].x,
@@ -72,6 +469,7 @@ void ow::model::process_mesh(aiMesh* mesh, const aiScene *scene) {
 	}
 
 	// indices
+	indices.reserve(3 * mesh->mNumFaces);
 	for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
 		aiFace face = mesh->mFaces[i];
 		for (unsigned int j = 0; j < face.mNumIndices; ++j) {
@@ -83,21 +481,100 @@ void ow::model::process_mesh(aiMesh* mesh, const aiScene *scene) {
 	//if (mesh->mMaterialIndex >= 0) { // if (true)
 	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-	std::vector<std::shared_ptr<texture>> diffuse_maps = load_material_textures(material, aiTextureType_DIFFUSE, texture_type::diffuse);
-	std::vector<std::shared_ptr<texture>> specular_maps = load_material_textures(material, aiTextureType_SPECULAR, texture_type::specular);
-	std::vector<std::shared_ptr<texture>> emission_maps = load_material_textures(material, aiTextureType_EMISSIVE, texture_type::emission);
+	texture_names textures;
+	textures[static_cast<std::size_t>(texture_type::diffuse)] = material_texture_names(material, aiTextureType_DIFFUSE);
+	textures[static_cast<std::size_t>(texture_type::specular)] = material_texture_names(material, aiTextureType_SPECULAR);
+	textures[static_cast<std::size_t>(texture_type::emission)] = material_texture_names(material, aiTextureType_EMISSIVE);
 	//}
 
-	m_meshes.emplace_back(std::move(vertices), std::move(indices), std::move(diffuse_maps), std::move(specular_maps), std::move(emission_maps));
+	meshes->push_back({std::move(vertices), std::move(indices), std::move(textures)});
+}
+
+void ow::model::build_meshes(std::vector<mesh_data> meshes) {
+	auto& registry = texture_registry::global();
+
+	// decode every image which is not resident yet on the worker threads...
+	std::map<std::string, std::future<image>> pending;
+	for (auto& data : meshes) {
+		for (auto type : TEXTURE_TYPES) {
+			for (auto& name : data.textures[static_cast<std::size_t>(type)]) {
+				std::string filename = m_directory + '/' + name;
+				if (pending.count(filename) == 0 && !registry.find(filename, type)) {
+					pending.emplace(filename, thread_pool::global().submit([filename] { return image::load(filename); }));
+				}
+			}
+		}
+	}
+
+	std::map<std::string, image> decoded;
+	for (auto& [filename, future] : pending) {
+		image img = future.get();
+		if (!img) {
+			logger << "Failed to load texture " << filename << '\n';
+		}
+		decoded.emplace(filename, std::move(img));
+	}
+
+	// ...and only upload them on this thread.
+	if (m_arena) {
+		std::size_t vertex_count = 0;
+		std::size_t index_count = 0;
+		for (auto& data : meshes) {
+			vertex_count += data.vertex_count();
+			index_count += data.index_count();
+		}
+		m_arena->reserve(vertex_count, index_count);
+	} else {
+		m_meshes.reserve(m_meshes.size() + meshes.size());
+	}
+	for (auto& data : meshes) {
+		std::array<std::vector<std::shared_ptr<texture>>, MESH_CACHE_TEXTURE_TYPES> maps;
+		for (auto type : TEXTURE_TYPES) {
+			for (auto& name : data.textures[static_cast<std::size_t>(type)]) {
+				std::string filename = m_directory + '/' + name;
+				auto it = decoded.find(filename);
+				maps[static_cast<std::size_t>(type)].push_back(it != decoded.end()
+						? registry.get(filename, type, it->second)
+						: registry.get(filename, type));
+			}
+		}
+
+		add_mesh(std::move(data), std::move(maps));
+	}
+}
+
+void ow::model::add_mesh(mesh_data data, std::array<std::vector<std::shared_ptr<texture>>, MESH_CACHE_TEXTURE_TYPES> maps) {
+	if (data.cache) {
+		const mesh_cache& cache = *data.cache;
+		const vertex* vertices = cache.vertices(data.cache_mesh);
+		const unsigned int* indices = cache.indices(data.cache_mesh);
+		if (m_arena) {
+			m_arena->add_mesh(vertices, data.vertex_count(), indices, data.index_count(), std::move(maps));
+			return;
+		}
+
+		// a mesh keeps its geometry in CPU memory (see mesh::get_vertices): its only copy.
+		data.vertices.assign(vertices, vertices + data.vertex_count());
+		data.indices.assign(indices, indices + data.index_count());
+	}
+
+	if (m_arena) {
+		m_arena->add_mesh(data.vertices, data.indices, std::move(maps));
+		return;
+	}
+
+	m_meshes.emplace_back(std::move(data.vertices), std::move(data.indices),
+						  std::move(maps[static_cast<std::size_t>(texture_type::diffuse)]),
+						  std::move(maps[static_cast<std::size_t>(texture_type::specular)]),
+						  std::move(maps[static_cast<std::size_t>(texture_type::emission)]));
 }
 
-std::vector<std::shared_ptr<ow::texture>> ow::model::load_material_textures(aiMaterial* mat, aiTextureType type, const texture_type& type_name) {
-	std::vector<std::shared_ptr<texture>> textures;
+std::vector<std::string> ow::model::material_texture_names(aiMaterial* mat, aiTextureType type) {
+	std::vector<std::string> names;
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		std::string filename = m_directory + '/' + std::string(str.C_Str());
-		textures.push_back(std::make_shared<texture>(filename, type_name));
+		names.emplace_back(str.C_Str());
 	}
-	return textures;
+	return names;
 }
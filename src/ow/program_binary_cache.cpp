@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include <ow/gl_extensions.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/program_binary_cache.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	constexpr std::array<char, 4> MAGIC = {'O', 'W', 'P', 'B'};
+	constexpr std::uint32_t ENDIANNESS_MARKER = 0x01020304;
+
+	std::uint64_t hash_gl_string(GLenum name, std::uint64_t seed) {
+		auto str = reinterpret_cast<const char*>(glGetString(name));
+		return ow::hash_string(str != nullptr ? str : "", seed);
+	}
+
+	// errors of a rejected binary are expected, and not reported.
+	void clear_errors() {
+		while (glGetError() != GL_NO_ERROR) {}
+	}
+}
+
+ow::program_binary_cache::program_binary_cache(std::string directory)
+		: m_directory{std::move(directory)}, m_enabled{true} {}
+
+ow::program_binary_cache& ow::program_binary_cache::global() {
+	static program_binary_cache cache{"cache/shaders"};
+	return cache;
+}
+
+bool ow::program_binary_cache::enabled() const noexcept {
+	return m_enabled && gl_extensions::current().program_binary;
+}
+
+std::uint64_t ow::program_binary_cache::key(const std::vector<std::pair<GLenum, std::string>>& sources,
+											std::string_view defines) const {
+	std::uint64_t hash = hash_gl_string(GL_VENDOR, FNV1A_OFFSET_BASIS);
+	hash = hash_gl_string(GL_RENDERER, hash);
+	hash = hash_gl_string(GL_VERSION, hash);
+
+	// sizes are hashed too, so that moving text from one stage to the next changes the key.
+	for (auto& [stage, source] : sources) {
+		std::uint64_t size = source.size();
+		hash = hash_bytes(&stage, sizeof(stage), hash);
+		hash = hash_bytes(&size, sizeof(size), hash);
+		hash = hash_string(source, hash);
+	}
+	return hash_string(defines, hash);
+}
+
+bool ow::program_binary_cache::load(GLuint program, std::uint64_t key) const {
+	const std::string filename = filename_for(key);
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	program_cache_header header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file
+		|| header.magic != MAGIC
+		|| header.version != PROGRAM_CACHE_VERSION
+		|| header.endianness != ENDIANNESS_MARKER
+		|| header.key != key) {
+		return false;
+	}
+
+	std::error_code ec;
+	if (std::filesystem::file_size(filename, ec) != sizeof(header) + header.binary_size || ec) {
+		return false;
+	}
+
+	std::vector<char> binary(header.binary_size);
+	file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if (!file) {
+		return false;
+	}
+
+	clear_errors();
+	gl_extensions::current().ProgramBinary(program, header.binary_format, binary.data(),
+										   static_cast<GLsizei>(binary.size()));
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	clear_errors();
+
+	if (status != GL_TRUE) {
+		logger << "Program binary " << filename << " was rejected by the driver, linking from sources.\n";
+		return false;
+	}
+	return true;
+}
+
+void ow::program_binary_cache::prepare(GLuint program) const {
+	gl_extensions::current().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ow::program_binary_cache::store(GLuint program, std::uint64_t key) const {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return false;
+	}
+
+	program_cache_header header{};
+	header.magic = MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.endianness = ENDIANNESS_MARKER;
+	header.key = key;
+
+	std::vector<char> binary(static_cast<std::size_t>(length));
+	GLsizei written = 0;
+	GLenum format = 0;
+	gl_extensions::current().GetProgramBinary(program, length, &written, &format, binary.data());
+	check_errors("Failed to retrieve the binary of program " + std::to_string(program) + ".\n");
+	if (written <= 0) {
+		return false;
+	}
+	header.binary_format = format;
+	header.binary_size = static_cast<std::uint64_t>(written);
+
+	std::error_code ec;
+	std::filesystem::create_directories(m_directory, ec);
+
+	// write in a temporary file first so that a crash never leaves a truncated entry behind.
+	const std::string filename = filename_for(key);
+	const std::string tmp_filename = filename + ".tmp";
+	{
+		std::ofstream file(tmp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file) {
+			logger << "Failed to open program binary " << tmp_filename << " for writing.\n";
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), static_cast<std::streamsize>(header.binary_size));
+		if (!file) {
+			logger << "Failed to write program binary " << tmp_filename << ".\n";
+			return false;
+		}
+	}
+
+	std::remove(filename.c_str());
+	if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+		logger << "Failed to move program binary " << tmp_filename << " to " << filename << ".\n";
+		std::remove(tmp_filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::string ow::program_binary_cache::filename_for(std::uint64_t key) const {
+	static constexpr char digits[] = "0123456789abcdef";
+	std::string name(16, '0');
+	for (std::size_t i = name.size(); i-- > 0; key >>= 4) {
+		name[i] = digits[key & 0xF];
+	}
+	return m_directory + "/" + name + ".owbin";
+}
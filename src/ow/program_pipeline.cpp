@@ -0,0 +1,73 @@
+#include <string>
+#include <utility>
+
+#include <ow/gl_state.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/program_pipeline.hpp>
+
+ow::program_pipeline::program_pipeline(program_pipeline&& other) noexcept
+		: checkable(other.p_state)
+		, m_pipeline_id{std::exchange(other.m_pipeline_id, 0)}
+		, m_stages{std::exchange(other.m_stages, {})}
+{}
+
+ow::program_pipeline::~program_pipeline() {
+	if (get_id() != 0) {
+		gl_state::current().delete_program_pipeline(m_pipeline_id);
+	}
+}
+
+bool ow::program_pipeline::use_stages(GLbitfield stages, const shader_program& program) {
+	_create();
+	chk_state();
+	if (!program.separable() || program.pending()) {
+		throw invalid_state("Shader " + std::to_string(program.get_id()) + " is not a linked separable program.");
+	}
+
+	// the stages already holding the program are left out, one call sets the others.
+	GLbitfield changed = 0;
+	for (std::size_t i = 0; i < STAGE_BITS.size(); ++i) {
+		if ((stages & STAGE_BITS[i]) != 0 && m_stages[i] != program.get_id()) {
+			m_stages[i] = program.get_id();
+			changed |= STAGE_BITS[i];
+		}
+	}
+	if (changed == 0) {
+		return false;
+	}
+
+	gl_extensions::current().UseProgramStages(get_id(), changed, program.get_id());
+	check_errors("Error while using shader " + std::to_string(program.get_id()) + " in pipeline "
+				 + std::to_string(get_id()) + ".\n");
+	return true;
+}
+
+GLuint ow::program_pipeline::stage(GLbitfield stage) const noexcept {
+	for (std::size_t i = 0; i < STAGE_BITS.size(); ++i) {
+		if (STAGE_BITS[i] == stage) {
+			return m_stages[i];
+		}
+	}
+	return 0;
+}
+
+void ow::program_pipeline::bind() {
+	_create();
+	chk_state();
+	auto& state = gl_state::current();
+	state.use_program(0);
+	state.bind_program_pipeline(get_id());
+	check_errors("Error while binding pipeline " + std::to_string(get_id()) + ".\n");
+}
+
+void ow::program_pipeline::_create() {
+	if (get_id() != 0) {
+		return;
+	}
+	auto& gl = gl_extensions::current();
+	if (!gl.separate_shader_objects) {
+		throw invalid_state("Program pipelines need GL_ARB_separate_shader_objects.");
+	}
+	gl.GenProgramPipelines(1, &m_pipeline_id);
+	p_state = (get_id() != 0);
+}
@@ -0,0 +1,216 @@
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include <ow/gl_state.hpp>
+#include <ow/opengl_codes.hpp>
+#include <ow/render_queue.hpp>
+
+namespace {
+	constexpr unsigned PROGRAM_BITS = 10;
+	constexpr unsigned MATERIAL_BITS = 14;
+	constexpr unsigned VERTEX_ARRAY_BITS = 14;
+	constexpr unsigned DEPTH_BITS = 24;
+
+	constexpr std::uint64_t mask(unsigned bits) {
+		return (std::uint64_t{1} << bits) - 1;
+	}
+
+	// the bits of a positive float sort like the float itself.
+	std::uint64_t depth_bits(float depth) {
+		depth = depth > 0.f ? depth : 0.f;
+		std::uint32_t bits;
+		std::memcpy(&bits, &depth, sizeof(bits));
+		return bits >> (31 - DEPTH_BITS); // the sign bit is always 0
+	}
+
+	std::uint32_t material_id(const ow::mesh& m) {
+		std::uint32_t hash = 2166136261u;
+		auto mix = [&hash] (const std::vector<std::shared_ptr<ow::texture>>& maps) {
+			hash = (hash ^ (maps.empty() ? 0u : maps.front()->id)) * 16777619u;
+		};
+		mix(m.get_diffuse_maps());
+		mix(m.get_specular_maps());
+		mix(m.get_emission_maps());
+		return hash;
+	}
+
+	bool same_material(const ow::mesh& a, const ow::mesh& b) {
+		return a.get_diffuse_maps() == b.get_diffuse_maps()
+			&& a.get_specular_maps() == b.get_specular_maps()
+			&& a.get_emission_maps() == b.get_emission_maps();
+	}
+}
+
+void ow::render_queue::submit(const mesh& m, const shader_program& prog, const glm::mat4& model, render_pass pass,
+							  std::size_t lod) {
+	m_items.push_back({&m, &prog, &prog, model, lod, pass});
+}
+
+void ow::render_queue::submit(const mesh& m, const shader_program& vertex, const shader_program& fragment,
+							  const glm::mat4& model, render_pass pass, std::size_t lod) {
+	m_items.push_back({&m, &vertex, &fragment, model, lod, pass});
+}
+
+std::uint64_t ow::render_queue::make_key(render_pass pass, GLuint program, std::uint32_t material, GLuint vertex_array,
+										 float depth) noexcept {
+	std::uint64_t state = (std::uint64_t{program} & mask(PROGRAM_BITS)) << (MATERIAL_BITS + VERTEX_ARRAY_BITS)
+						| (std::uint64_t{material} & mask(MATERIAL_BITS)) << VERTEX_ARRAY_BITS
+						| (std::uint64_t{vertex_array} & mask(VERTEX_ARRAY_BITS));
+	auto pass_bits = static_cast<std::uint64_t>(pass) << 62;
+	if (pass == render_pass::transparent) {
+		// depth first: blending needs the far draws first.
+		return pass_bits | (mask(DEPTH_BITS) - depth_bits(depth)) << (62 - DEPTH_BITS) | state;
+	}
+	return pass_bits | state << DEPTH_BITS | depth_bits(depth);
+}
+
+void ow::render_queue::execute(const glm::mat4& view) {
+	m_stats = {};
+	m_entries.clear();
+	for (std::size_t i = 0; i < m_items.size(); ++i) {
+		auto& it = m_items[i];
+		glm::vec4 center = view * it.model * glm::vec4{it.drawn_mesh->get_aabb().center(), 1.f};
+		m_entries.push_back({make_key(it.pass, _program_key(it), material_id(*it.drawn_mesh),
+									  it.drawn_mesh->get_vertex_array(), -center.z), static_cast<std::uint32_t>(i)});
+	}
+	_sort();
+
+	auto& state = gl_state::current();
+	const shader_program* program = nullptr;  // vertex stage, gets the per draw uniforms
+	const shader_program* fragment = nullptr; // gets the material
+	uniform_handle model_uniform, normal_matrix_uniform, dequantization_uniform;
+	const mesh* material = nullptr;
+	GLuint vertex_array = 0;
+	bool dequantized = false; // the program in use has a non identity dequantization
+	bool blending = false;
+	for (auto& entry : m_entries) {
+		auto& it = m_items[entry.item];
+		const mesh& m = *it.drawn_mesh;
+
+		if (it.pass == render_pass::transparent && !blending) {
+			state.set_enabled(GL_BLEND, true);
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			state.depth_mask(false);
+			check_errors("Failed to set blending. ");
+			blending = true;
+		}
+
+		if (it.vertex != program || it.fragment != fragment) {
+			if (it.vertex != program && dequantized) {
+				// uniforms stay with their program: its next draws must not inherit the matrix.
+				program->set(dequantization_uniform, glm::mat4{1.f});
+				dequantized = false;
+			}
+			if (it.vertex == it.fragment) {
+				it.vertex->use();
+			} else {
+				// a program in use hides the pipeline, which kept its stages meanwhile.
+				if (program == fragment) {
+					m_pipeline.bind();
+				}
+				auto changed = static_cast<std::size_t>(m_pipeline.use_stages(GL_VERTEX_SHADER_BIT, *it.vertex))
+						+ static_cast<std::size_t>(m_pipeline.use_stages(GL_FRAGMENT_SHADER_BIT, *it.fragment));
+				m_stats.stage_changes += changed;
+				m_stats.stage_changes_avoided += 2 - changed;
+			}
+			if (it.vertex != program) {
+				program = it.vertex;
+				model_uniform = program->uniform("model");
+				normal_matrix_uniform = program->uniform("normal_matrix");
+				dequantization_uniform = program->uniform("dequantization");
+			}
+			if (it.fragment != fragment) {
+				fragment = it.fragment;
+				material = nullptr; // the texture uniforms belong to the program
+			}
+			++m_stats.program_changes;
+		} else {
+			++m_stats.program_changes_avoided;
+		}
+
+		if (!material || !same_material(*material, m)) {
+			m.bind_textures(*fragment);
+			material = &m;
+			++m_stats.material_changes;
+		} else {
+			++m_stats.material_changes_avoided;
+		}
+
+		if (m.get_vertex_array() != vertex_array) {
+			vertex_array = m.get_vertex_array();
+			state.bind_vertex_array(vertex_array);
+			check_errors("failed to bind VAO. ");
+			++m_stats.vertex_array_changes;
+		} else {
+			++m_stats.vertex_array_changes_avoided;
+		}
+
+		if (m.get_vertex_packing() == vertex_packing::packed) {
+			program->set(dequantization_uniform, m.get_dequantization());
+			dequantized = true;
+		} else if (dequantized) {
+			program->set(dequantization_uniform, glm::mat4{1.f});
+			dequantized = false;
+		}
+
+		program->set(model_uniform, it.model);
+		program->set(normal_matrix_uniform, glm::mat3(glm::transpose(glm::inverse(view * it.model))));
+		m.draw_elements(it.lod);
+		++m_stats.draws;
+	}
+
+	// reset
+	if (dequantized) {
+		program->set(dequantization_uniform, glm::mat4{1.f});
+	}
+	if (blending) {
+		state.set_enabled(GL_BLEND, false);
+		state.depth_mask(true);
+		check_errors("Failed to reset blending. ");
+	}
+
+	m_items.clear();
+}
+
+GLuint ow::render_queue::_program_key(const item& it) noexcept {
+	if (it.vertex == it.fragment) {
+		return it.vertex->get_id();
+	}
+	constexpr unsigned STAGE_BITS = PROGRAM_BITS / 2;
+	return static_cast<GLuint>((it.vertex->get_id() & mask(STAGE_BITS)) << STAGE_BITS
+							   | (it.fragment->get_id() & mask(STAGE_BITS)));
+}
+
+void ow::render_queue::_sort() {
+	if (m_entries.empty()) {
+		return;
+	}
+
+	// least significant digit first, 8 bits per pass. The histograms of all the passes are
+	// built at once, and a pass is skipped when all the keys share its digit.
+	constexpr std::size_t DIGITS = 8;
+	std::array<std::array<std::uint32_t, 256>, DIGITS> counts{};
+	for (auto& entry : m_entries) {
+		for (std::size_t digit = 0; digit < DIGITS; ++digit) {
+			++counts[digit][(entry.key >> (8 * digit)) & 0xff];
+		}
+	}
+
+	m_scratch.resize(m_entries.size());
+	for (std::size_t digit = 0; digit < DIGITS; ++digit) {
+		auto& count = counts[digit];
+		if (count[(m_entries.front().key >> (8 * digit)) & 0xff] == m_entries.size()) {
+			continue;
+		}
+
+		std::uint32_t offset = 0;
+		for (auto& c : count) {
+			offset += std::exchange(c, offset);
+		}
+		for (auto& entry : m_entries) {
+			m_scratch[count[(entry.key >> (8 * digit)) & 0xff]++] = entry;
+		}
+		m_entries.swap(m_scratch);
+	}
+}
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cassert>
+
+#include <ow/opengl_codes.hpp>
+#include <ow/shader_object_cache.hpp>
+#include <ow/utils.hpp>
+
+ow::shader_object_cache& ow::shader_object_cache::global() {
+	static shader_object_cache cache;
+	return cache;
+}
+
+GLuint ow::shader_object_cache::acquire(GLenum stage, const std::string& source) {
+	std::uint64_t key = hash_string(source, hash_bytes(&stage, sizeof(stage)));
+	auto [first, last] = m_entries.equal_range(key);
+	for (auto it = first; it != last; ++it) {
+		if (it->second.stage == stage && it->second.source == source) {
+			++it->second.users;
+			++m_stats.reused;
+			return it->second.shader;
+		}
+	}
+
+	auto& cached = m_entries.emplace(key, entry{stage, source, glCreateShader(stage), 1})->second;
+	m_keys[cached.shader] = key;
+	++m_stats.compiled;
+
+	const char *const tmp = source.data();
+	glShaderSource(cached.shader, 1, &tmp, nullptr);
+	check_errors("Error while sourcing shader " + std::to_string(cached.shader) + ".\n");
+
+	glCompileShader(cached.shader);
+	check_errors("Error while compiling shader " + std::to_string(cached.shader) + ". ");
+	return cached.shader;
+}
+
+void ow::shader_object_cache::release(GLuint shader) {
+	auto key = m_keys.find(shader);
+	if (key == m_keys.end()) {
+		return;
+	}
+
+	auto [first, last] = m_entries.equal_range(key->second);
+	auto it = std::find_if(first, last, [shader](const auto& cached) { return cached.second.shader == shader; });
+	assert(it != last && it->second.users > 0);
+	--it->second.users;
+}
+
+void ow::shader_object_cache::trim() {
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		if (it->second.users > 0) {
+			++it;
+			continue;
+		}
+		glDeleteShader(it->second.shader);
+		check_errors("Error while deleting shader " + std::to_string(it->second.shader) + ".\n");
+		m_keys.erase(it->second.shader);
+		it = m_entries.erase(it);
+	}
+}
@@ -0,0 +1,21 @@
+#include <ow/shader_permutations.hpp>
+
+ow::shader_permutations::shader_permutations(std::vector<std::pair<GLenum, std::string>> shaders, bool separable)
+		: m_shaders{std::move(shaders)}, m_separable{separable}, m_programs() {}
+
+ow::shader_program& ow::shader_permutations::submit(const shader_defines& defines) {
+	auto& program = m_programs[defines.text()];
+	if (!program) {
+		std::vector<std::pair<GLenum, std::string_view>> shaders(m_shaders.begin(), m_shaders.end());
+		program = std::make_unique<shader_program>();
+		program->set_separable(m_separable);
+		program->put_async(shaders, defines);
+	}
+	return *program;
+}
+
+const ow::shader_program& ow::shader_permutations::get(const shader_defines& defines) {
+	auto& program = submit(defines);
+	program.wait();
+	return program;
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <ow/shader_preprocessor.hpp>
+#include <ow/utils.hpp>
+
+namespace {
+	bool starts_with(std::string_view str, std::string_view prefix) {
+		return str.substr(0, prefix.size()) == prefix;
+	}
+
+	std::string_view trim_left(std::string_view str) {
+		auto first = str.find_first_not_of(" \t");
+		return first == std::string_view::npos ? std::string_view{} : str.substr(first);
+	}
+
+	// name of `#include "name"`, empty if malformed.
+	std::string_view include_name(std::string_view directive) {
+		auto open = directive.find('"');
+		auto close = open == std::string_view::npos ? open : directive.find('"', open + 1);
+		if (close == std::string_view::npos || close == open + 1) {
+			return {};
+		}
+		return directive.substr(open + 1, close - open - 1);
+	}
+
+	void append_line_directive(std::string* source, std::size_t line, int id) {
+		*source += "#line " + std::to_string(line) + ' ' + std::to_string(id) + '\n';
+	}
+}
+
+ow::shader_defines::shader_defines(std::initializer_list<std::pair<std::string_view, std::string_view>> defines)
+		: m_defines() {
+	for (auto& define : defines) {
+		set(define.first, define.second);
+	}
+}
+
+ow::shader_defines& ow::shader_defines::set(std::string_view name, std::string_view value) {
+	auto it = std::lower_bound(m_defines.begin(), m_defines.end(), name,
+							   [](const auto& define, std::string_view key) { return define.first < key; });
+	if (it != m_defines.end() && it->first == name) {
+		it->second = value;
+	} else {
+		m_defines.emplace(it, name, value);
+	}
+	return *this;
+}
+
+ow::shader_defines& ow::shader_defines::set(std::string_view name, long value) {
+	return set(name, std::to_string(value));
+}
+
+ow::shader_defines& ow::shader_defines::merge(const shader_defines& other) {
+	for (auto& define : other.m_defines) {
+		set(define.first, define.second);
+	}
+	return *this;
+}
+
+std::string ow::shader_defines::text() const {
+	std::string text;
+	for (auto& [name, value] : m_defines) {
+		text += "#define " + name + ' ' + value + '\n';
+	}
+	return text;
+}
+
+std::string ow::shader_defines::text_used_by(std::string_view source) const {
+	std::string text;
+	for (auto& [name, value] : m_defines) {
+		if (source.find(name) != std::string_view::npos) {
+			text += "#define " + name + ' ' + value + '\n';
+		}
+	}
+	return text;
+}
+
+ow::shader_preprocessor::shader_preprocessor(std::string root)
+		: m_root{std::move(root)}, m_files(), m_file_names() {}
+
+ow::shader_preprocessor& ow::shader_preprocessor::global() {
+	static shader_preprocessor preprocessor{"resources/shaders/"};
+	return preprocessor;
+}
+
+bool ow::shader_preprocessor::process(std::string_view file_name, const shader_defines& defines, std::string* source) {
+	source->clear();
+	std::vector<std::string> included;
+	std::size_t defines_at = 0;
+	if (!_expand(std::string(file_name), &defines_at, &included, source)) {
+		return false;
+	}
+	source->insert(defines_at, defines.text_used_by(*source));
+	return true;
+}
+
+std::string_view ow::shader_preprocessor::file_name(int id) const noexcept {
+	if (id < 0 || static_cast<std::size_t>(id) >= m_file_names.size()) {
+		return {};
+	}
+	return m_file_names[static_cast<std::size_t>(id)];
+}
+
+void ow::shader_preprocessor::clear() noexcept {
+	m_files.clear();
+}
+
+bool ow::shader_preprocessor::_expand(const std::string& file_name, std::size_t* defines_at,
+									  std::vector<std::string>* included, std::string* source) {
+	if (std::find(included->begin(), included->end(), file_name) != included->end()) {
+		return true;
+	}
+	included->push_back(file_name);
+
+	const std::string* text = _read(file_name);
+	if (text == nullptr) {
+		logger << "[" << file_name << "] : failed to open file." << std::endl;
+		return false;
+	}
+
+	int id = _id_of(file_name);
+	auto directory = std::filesystem::path(file_name).parent_path();
+	if (defines_at == nullptr) {
+		append_line_directive(source, 1, id);
+	}
+
+	std::string_view remaining = *text;
+	for (std::size_t line_number = 1; !remaining.empty(); ++line_number) {
+		auto end = remaining.find('\n');
+		std::string_view line = remaining.substr(0, end);
+		remaining = end == std::string_view::npos ? std::string_view{} : remaining.substr(end + 1);
+
+		auto directive = trim_left(line);
+		if (starts_with(directive, "#include")) {
+			auto name = include_name(directive);
+			if (name.empty()) {
+				logger << "[" << file_name << ":" << line_number << "] : malformed #include." << std::endl;
+				return false;
+			}
+
+			auto path = (directory / std::string(name)).lexically_normal().generic_string();
+			if (!_expand(path, nullptr, included, source)) {
+				return false;
+			}
+			append_line_directive(source, line_number + 1, id);
+			continue;
+		}
+
+		*source += line;
+		*source += '\n';
+
+		if (defines_at != nullptr && line_number == 1) {
+			// no #version: the defines go first.
+			*defines_at = starts_with(directive, "#version") ? source->size() : 0;
+			append_line_directive(source, line_number + 1, id);
+		}
+	}
+	return true;
+}
+
+const std::string* ow::shader_preprocessor::_read(const std::string& file_name) {
+	auto it = m_files.find(file_name);
+	if (it != m_files.end()) {
+		return &it->second;
+	}
+
+	std::ifstream file(m_root + file_name, std::ios::in);
+	if (!file) {
+		return nullptr;
+	}
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return &m_files.emplace(file_name, contents.str()).first->second;
+}
+
+int ow::shader_preprocessor::_id_of(const std::string& file_name) {
+	auto it = std::find(m_file_names.begin(), m_file_names.end(), file_name);
+	if (it == m_file_names.end()) {
+		m_file_names.push_back(file_name);
+		return static_cast<int>(m_file_names.size() - 1);
+	}
+	return static_cast<int>(it - m_file_names.begin());
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -7,78 +8,212 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <ow/gl_extensions.hpp>
+#include <ow/light_block.hpp>
+#include <ow/program_binary_cache.hpp>
+#include <ow/shader_object_cache.hpp>
 #include <ow/shader_program.hpp>
 #include <ow/utils.hpp>
 
 ow::shader_program::shader_program(shader_program&& other) noexcept
 		: checkable(other.p_state)
 		, m_program_id{std::exchange(other.m_program_id, 0)}
+		, m_uniforms{std::move(other.m_uniforms)}
+		, m_pending{std::move(other.m_pending)}
+		, m_separable{other.m_separable}
 {}
 
-bool ow::shader_program::put(const std::vector<std::pair<GLenum, std::string_view>>& shaders) {
+ow::shader_program::~shader_program() {
+	if (m_pending) {
+		for (auto& shader : m_pending->shaders) {
+			shader_object_cache::global().release(shader.first);
+		}
+	}
+	if (get_id() != 0) {
+		gl_state::current().delete_program(m_program_id);
+	}
+}
+
+bool ow::shader_program::put(const std::vector<std::pair<GLenum, std::string_view>>& shaders,
+							 const shader_defines& defines) {
+	if (!put_async(shaders, defines)) {
+		return false;
+	}
+	wait();
+	return static_cast<bool>(*this);
+}
+
+bool ow::shader_program::put_async(const std::vector<std::pair<GLenum, std::string_view>>& shaders,
+								   const shader_defines& defines) {
 	if (get_id() == 0) {
 		m_program_id = glCreateProgram();
 		p_state = (get_id() != 0);
 	}
 
 	chk_state();
+	wait();
+
+	auto& gl = gl_extensions::current();
+	if (m_separable && !gl.separate_shader_objects) {
+		throw invalid_state("Shader " + std::to_string(get_id()) + " is separable, which needs GL_ARB_separate_shader_objects.");
+	}
+	if (gl.separate_shader_objects) {
+		// before glProgramBinary too: binaries don't restore it everywhere.
+		gl.ProgramParameteri(get_id(), GL_PROGRAM_SEPARABLE, m_separable ? GL_TRUE : GL_FALSE);
+		check_errors("Error while setting the separability of shader " + std::to_string(get_id()) + ".\n");
+	}
+
+	// lets the stages redeclare gl_PerVertex, which needs the extension enabled.
+	shader_defines program_defines = defines;
+	if (m_separable) {
+		program_defines.set("SEPARABLE_PROGRAM");
+	}
 
+	std::vector<std::pair<GLenum, std::string>> sources;
+	sources.reserve(shaders.size());
 	for (auto&& shader : shaders) {
-		auto shader_id = glCreateShader(shader.first);
-		if (!load_compile(shader_id, shader.second)) {
+		std::string source;
+		if (!load_shader(shader.second, program_defines, &source)) {
 			p_state = false;
 			return false;
 		}
+		sources.emplace_back(shader.first, std::move(source));
+	}
+
+	auto& cache = program_binary_cache::global();
+	auto pending = std::make_unique<pending_link>();
+	pending->cached = cache.enabled();
+	pending->cache_key = pending->cached ? cache.key(sources, program_defines.text() + (m_separable ? "separable\n" : "")) : 0;
+	if (pending->cached && cache.load(get_id(), pending->cache_key)) {
+		p_state = true;
+		return _linked();
+	}
+
+	// nothing is checked before the link: the driver may still be compiling on its threads.
+	auto& objects = shader_object_cache::global();
+	for (std::size_t i = 0; i < shaders.size(); ++i) {
+		auto shader_id = objects.acquire(sources[i].first, sources[i].second);
+		pending->shaders.emplace_back(shader_id, std::string(shaders[i].second));
 
 		glAttachShader(get_id(), shader_id);
-		p_state = check_errors(
-				"Error while attaching " + std::to_string(shader_id) + " to shader " + std::to_string(get_id()) + "\n");
-		if (!p_state) {
-			return false;
-		}
+		check_errors("Error while attaching " + std::to_string(shader_id) + " to shader " + std::to_string(get_id()) + "\n");
+	}
 
-		glDeleteShader(shader_id);
-		p_state = check_errors("Error while flagging " + std::to_string(shader_id)
-							   + " for deletion (in shader " + std::to_string(get_id()) + "\n");
-		if (!p_state) {
+	if (pending->cached) {
+		cache.prepare(get_id());
+	}
+	glLinkProgram(get_id());
+	check_errors("Unexpected error while linking shader " + std::to_string(get_id()) + ".\n");
+	m_pending = std::move(pending);
+	return true;
+}
+
+bool ow::shader_program::poll() {
+	if (!m_pending) {
+		return true;
+	}
+
+	// without the extension, the status queries of _finish block until the link is done.
+	if (gl_extensions::current().parallel_shader_compile) {
+		GLint done = GL_FALSE;
+		glGetProgramiv(get_id(), GL_COMPLETION_STATUS_KHR, &done);
+		if (done == GL_FALSE) {
 			return false;
 		}
 	}
-	glLinkProgram(get_id());
-	p_state = check_errors("Unexpected error while linking shader " + std::to_string(get_id()) + ".\n");
-	return static_cast<bool>(*this);
+	_finish();
+	return true;
+}
+
+void ow::shader_program::wait() {
+	if (m_pending) {
+		_finish();
+	}
 }
 
+void ow::shader_program::_finish() {
+	auto pending = std::move(m_pending);
 
+	bool compiled = true;
+	for (auto& [shader_id, file] : pending->shaders) {
+		compiled = checked_compile(shader_id, file) && compiled;
+	}
 
-bool ow::shader_program::load_shader(GLuint shader, std::string_view file_name) {
-	using namespace std::string_literals;
+	p_state = compiled && checked_link(get_id());
 
-	std::ifstream file("resources/shaders/"s + file_name.data(), std::ios::in);
-	if (!file) {
-		logger << "[" << file_name << "] : failed to open file." << std::endl;
-		return false;
+	// the linked program doesn't need its shaders, which would be linked again by the next put.
+	for (auto& shader : pending->shaders) {
+		glDetachShader(get_id(), shader.first);
+		check_errors("Error while detaching " + std::to_string(shader.first)
+					 + " (in shader " + std::to_string(get_id()) + "\n");
+		shader_object_cache::global().release(shader.first);
+	}
+	if (p_state && pending->cached && !program_binary_cache::global().store(get_id(), pending->cache_key)) {
+		logger << "Warning: failed to cache the binary of shader " << get_id() << '\n';
 	}
+	_linked();
+}
 
-	std::string line;
-	std::string str_out;
-	while (file) {
-		std::getline(file, line);
-		str_out += line + '\n';
+bool ow::shader_program::_linked() {
+	if (p_state) {
+		_introspect();
+		bind_uniform_block(LIGHTS_BLOCK_NAME, LIGHTS_BLOCK_BINDING);
 	}
+	return static_cast<bool>(*this);
+}
 
-	const char *const tmp = str_out.data();
-	glShaderSource(shader, 1, &tmp, nullptr);
-	return check_errors("["s + file_name.data() + "] : Error while sourcing code.\n");
+void ow::shader_program::bind_uniform_block(std::string_view name, GLuint binding) const {
+	GLuint index = glGetUniformBlockIndex(get_id(), std::string(name).c_str());
+	if (index != GL_INVALID_INDEX) {
+		glUniformBlockBinding(get_id(), index, binding);
+		check_errors("Error while binding uniform block " + std::string(name) + ".\n");
+	}
+}
+
+void ow::shader_program::_introspect() {
+	m_uniforms.clear();
+
+	GLint count = 0;
+	GLint max_length = 0;
+	glGetProgramiv(get_id(), GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(get_id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+	std::vector<char> buffer(static_cast<std::size_t>(std::max(max_length, 1)));
+
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(get_id(), static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type,
+						   buffer.data());
+		std::string name(buffer.data(), static_cast<std::size_t>(length));
+
+		// members of uniform blocks have no location, and are skipped by the table.
+		m_uniforms.insert(name, glGetUniformLocation(get_id(), name.c_str()));
+
+		// arrays are reported as their first element: "lights[0]". Their elements are not
+		// guaranteed to have consecutive locations, so they are all queried.
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+			std::string_view array(name.data(), name.size() - 3);
+			m_uniforms.insert(array, m_uniforms.find(name));
+			for (GLint element = 1; element < size; ++element) {
+				std::string element_name{uniform_name(array, static_cast<std::size_t>(element))};
+				m_uniforms.insert(element_name, glGetUniformLocation(get_id(), element_name.c_str()));
+			}
+		}
+	}
+	check_errors("Error while introspecting the uniforms of shader " + std::to_string(get_id()) + ".\n");
+}
+
+
+
+bool ow::shader_program::load_shader(std::string_view file_name, const shader_defines& defines, std::string* source) {
+	return shader_preprocessor::global().process(file_name, defines, source);
 }
 
 bool ow::shader_program::checked_compile(GLuint shader, std::string_view shader_file) {
 	const std::string failed_compile_status =
 			"\tError while retrieving compile status for shader " + std::to_string(shader) + ". ";
 	
-	glCompileShader(shader);
-	check_errors("Error while compiling shader " + std::to_string(shader) + ". ");
-
 	int success;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 	check_errors(failed_compile_status);
@@ -114,11 +249,29 @@ bool ow::shader_program::checked_compile(GLuint shader, std::string_view shader_
 
 		}
 
+		// the messages name the files by their source string number.
+		auto& preprocessor = shader_preprocessor::global();
+		ostream << "source string numbers:";
+		for (int id = 0; !preprocessor.file_name(id).empty(); ++id) {
+			ostream << ' ' << id << " = " << preprocessor.file_name(id);
+		}
+		ostream << '\n';
 		return false;
 	}
 	return true;
 }
 
-bool ow::shader_program::load_compile(GLuint shader, std::string_view file) {
-	return load_shader(shader, file) && checked_compile(shader, file);
+bool ow::shader_program::checked_link(GLuint program) {
+	GLint success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (success == GL_TRUE) {
+		return true;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+	std::vector<char> log(static_cast<std::size_t>(std::max(length, 1)), '\0');
+	glGetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, log.data());
+	logger << "Failed to link shader " << program << " :\n" << log.data();
+	return false;
 }
@@ -1,17 +1,19 @@
 #include <string>
 #include <vector>
+#include <future>
 #include <iostream>
 #include <utility>
 
-#include <stb_image.h>
-
+#include <ow/gl_state.hpp>
+#include <ow/image.hpp>
 #include <ow/skybox.hpp>
+#include <ow/thread_pool.hpp>
 #include <ow/utils.hpp>
 #include <ow/opengl_codes.hpp>
 
-ow::skybox::skybox(const std::string& dirname) : id{} {
+ow::skybox::skybox(const std::string& dirname) : id{}, byte_size{0} {
 	glGenTextures(1, &id);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+	gl_state::current().bind_texture(GL_TEXTURE_CUBE_MAP, id);
 
     std::vector<std::string> filenames = {
         "/right.jpg",
@@ -22,21 +24,26 @@ ow::skybox::skybox(const std::string& dirname) : id{} {
         "/back.jpg"
     };
 
+	// decode the six faces on the worker threads, upload them here.
+	std::vector<std::future<image>> faces;
+	faces.reserve(filenames.size());
+	for (auto& filename : filenames) {
+		faces.push_back(thread_pool::global().submit([path = dirname + filename] { return image::load(path); }));
+	}
+
 	// load and generate the skybox
-	int width, height, nbr_channels;
-	stbi_set_flip_vertically_on_load(true);
-    for(GLuint i = 0; i < filenames.size(); i++) {
-        unsigned char* data = stbi_load((dirname + filenames[i]).c_str(), &width, &height, &nbr_channels, 0);
-        if(data) {
-            glTexImage2D(
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 
-                0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
-            );
-        } else {
-            logger << "Failed to load cubemap texture " << dirname << filenames[i] << '\n';
-        }
-	    stbi_image_free(data);
-    }
+	for (GLuint i = 0; i < filenames.size(); i++) {
+		image face = faces[i].get();
+		if (face) {
+			glTexImage2D(
+				GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+				0, GL_RGB, face.width, face.height, 0, GL_RGB, GL_UNSIGNED_BYTE, face.data
+			);
+			byte_size += face.byte_size();
+		} else {
+			logger << "Failed to load cubemap texture " << dirname << filenames[i] << '\n';
+		}
+	}
 
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -46,8 +53,9 @@ ow::skybox::skybox(const std::string& dirname) : id{} {
 }
 
 ow::skybox::skybox(skybox&& other) noexcept
-	: id{std::exchange(other.id, 0)} {}
+	: id{std::exchange(other.id, 0)}
+	, byte_size{std::exchange(other.byte_size, 0)} {}
 
 ow::skybox::~skybox() {
-	glDeleteTextures(1, &id);
+	gl_state::current().delete_texture(id);
 }
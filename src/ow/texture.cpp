@@ -1,9 +1,9 @@
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <utility>
 
-#include <stb_image.h>
-
+#include <ow/gl_state.hpp>
 #include <ow/texture.hpp>
 #include <ow/utils.hpp>
 #include <ow/opengl_codes.hpp>
@@ -21,63 +21,89 @@ std::string ow::texture_type_to_string(texture_type type) {
 	}
 }
 
-ow::texture::texture(const std::string& filename, texture_type type_) : id{}, type(type_) {
-	// load and generate the texture
-	int width, height, nbr_channels;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nbr_channels, 0);
-	if (data) {
-		GLenum format;
-		switch (nbr_channels) {
-		case 1:
-			format = GL_RED;
-			break;
-		case 3:
-			format = GL_RGB;
-			break;
-		case 4:
-			format = GL_RGBA;
-			break;
-		default:
-			abort();
-		}
+ow::texture::texture(const std::string& filename, texture_type type_) : texture(image::load(filename), type_) {
+	if (id == 0) {
+		logger << "Failed to load texture " << filename << '\n';
+	}
+}
 
-		auto gl_chk = [this] () {check_errors("Error configuring texture " + std::to_string(id));};
+ow::texture::texture(const image& img, texture_type type_, GLuint pixel_unpack_buffer) : id{}, type(type_), byte_size(0) {
+	if (!img) {
+		return;
+	}
 
-		glGenTextures(1, &id);
-		check_errors("Error while generating texture.");
-		glBindTexture(GL_TEXTURE_2D, id);
-		gl_chk();
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		gl_chk();
-		glGenerateMipmap(GL_TEXTURE_2D);
-		gl_chk();
+	GLenum format;
+	switch (img.channels) {
+	case 1:
+		format = GL_RED;
+		break;
+	case 3:
+		format = GL_RGB;
+		break;
+	case 4:
+		format = GL_RGBA;
+		break;
+	default:
+		abort();
+	}
 
-		// set the texture wrapping/filtering options (on the currently bound
-		// texture object)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		gl_chk();
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	auto gl_chk = [this] () {check_errors("Error configuring texture " + std::to_string(id));};
+
+	glGenTextures(1, &id);
+	check_errors("Error while generating texture.");
+	gl_state::current().bind_texture(GL_TEXTURE_2D, id);
+	gl_chk();
+	const void* pixels = img.data;
+	if (pixel_unpack_buffer != 0) {
+		// orphan the previous storage so that the driver doesn't have to wait for the last
+		// upload to complete, then copy the pixels in the mapped buffer.
+		gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, pixel_unpack_buffer);
 		gl_chk();
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		auto size = static_cast<GLsizeiptr>(img.byte_size());
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
 		gl_chk();
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (staging) {
+			std::memcpy(staging, img.data, img.byte_size());
+			pixels = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE ? nullptr : img.data;
+		}
+		if (pixels) { // mapping failed: read from client memory.
+			gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
 		gl_chk();
-
-		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	glTexImage2D(GL_TEXTURE_2D, 0, format, img.width, img.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+	gl_chk();
+	if (!pixels) {
+		gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
 		gl_chk();
-	} else {
-		logger << "Failed to load texture " << filename << '\n';
 	}
+	glGenerateMipmap(GL_TEXTURE_2D);
+	gl_chk();
+	// a full mipmap chain adds a third of the base level.
+	byte_size = img.byte_size() * 4 / 3;
+
+	// set the texture wrapping/filtering options (on the currently bound
+	// texture object)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	gl_chk();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	gl_chk();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	gl_chk();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	gl_chk();
 
-	stbi_image_free(data);
+	gl_state::current().bind_texture(GL_TEXTURE_2D, 0);
+	gl_chk();
 }
 
 ow::texture::texture(texture&& other) noexcept
 		: id{std::exchange(other.id, 0)}
 		, type{other.type}
+		, byte_size{std::exchange(other.byte_size, 0)}
 		{}
 
 ow::texture::~texture() {
-	glDeleteTextures(1, &id);
+	gl_state::current().delete_texture(id);
 }
@@ -0,0 +1,96 @@
+#include <filesystem>
+#include <system_error>
+
+#include <ow/texture_registry.hpp>
+
+namespace {
+	// look for a live entry, create it outside of the lock if needed.
+	template <typename Map, typename Key, typename Factory>
+	auto get_or_create(std::mutex& mutex, Map& map, const Key& key, std::size_t& hits, std::size_t& misses, Factory&& factory) {
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			if (auto it = map.find(key); it != map.end()) {
+				if (auto resident = it->second.lock()) {
+					++hits;
+					return resident;
+				}
+			}
+			++misses;
+		}
+
+		// loading may be slow: don't block other threads meanwhile.
+		auto created = factory();
+
+		std::lock_guard<std::mutex> lock{mutex};
+		auto& entry = map[key];
+		if (auto resident = entry.lock()) {
+			return resident; // another thread was faster.
+		}
+		entry = created;
+		return created;
+	}
+}
+
+ow::texture_registry& ow::texture_registry::global() {
+	static texture_registry registry;
+	return registry;
+}
+
+std::shared_ptr<ow::texture> ow::texture_registry::get(const std::string& filename, texture_type type) {
+	return get_or_create(m_mutex, m_textures, key_type{canonical_path(filename), type}, m_hits, m_misses, [&] {
+		return std::make_shared<texture>(filename, type);
+	});
+}
+
+std::shared_ptr<ow::texture> ow::texture_registry::get(const std::string& filename, texture_type type, const image& decoded,
+													   GLuint pixel_unpack_buffer) {
+	return get_or_create(m_mutex, m_textures, key_type{canonical_path(filename), type}, m_hits, m_misses, [&] {
+		return std::make_shared<texture>(decoded, type, pixel_unpack_buffer);
+	});
+}
+
+std::shared_ptr<ow::skybox> ow::texture_registry::get_skybox(const std::string& dirname) {
+	return get_or_create(m_mutex, m_skyboxes, canonical_path(dirname), m_hits, m_misses, [&] {
+		return std::make_shared<skybox>(dirname);
+	});
+}
+
+std::shared_ptr<ow::texture> ow::texture_registry::find(const std::string& filename, texture_type type) const {
+	std::lock_guard<std::mutex> lock{m_mutex};
+	auto it = m_textures.find(key_type{canonical_path(filename), type});
+	return it != m_textures.end() ? it->second.lock() : nullptr;
+}
+
+ow::texture_registry_stats ow::texture_registry::stats() const {
+	std::lock_guard<std::mutex> lock{m_mutex};
+	texture_registry_stats stats{m_hits, m_misses, 0, 0};
+	for (auto& [key, entry] : m_textures) {
+		if (auto resident = entry.lock()) {
+			++stats.resident_textures;
+			stats.resident_bytes += resident->byte_size;
+		}
+	}
+	for (auto& [key, entry] : m_skyboxes) {
+		if (auto resident = entry.lock()) {
+			++stats.resident_textures;
+			stats.resident_bytes += resident->byte_size;
+		}
+	}
+	return stats;
+}
+
+void ow::texture_registry::purge() {
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (auto it = m_textures.begin(); it != m_textures.end();) {
+		it = it->second.expired() ? m_textures.erase(it) : std::next(it);
+	}
+	for (auto it = m_skyboxes.begin(); it != m_skyboxes.end();) {
+		it = it->second.expired() ? m_skyboxes.erase(it) : std::next(it);
+	}
+}
+
+std::string ow::texture_registry::canonical_path(const std::string& filename) {
+	std::error_code ec;
+	auto path = std::filesystem::weakly_canonical(filename, ec);
+	return ec ? std::filesystem::path(filename).lexically_normal().string() : path.string();
+}
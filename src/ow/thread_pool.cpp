@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include <ow/thread_pool.hpp>
+
+ow::thread_pool::thread_pool(std::size_t thread_count)
+		: m_workers()
+		, m_tasks()
+		, m_mutex()
+		, m_condition()
+		, m_stopping{false} {
+	if (thread_count == 0) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	m_workers.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i) {
+		m_workers.emplace_back([this] { _work(); });
+	}
+}
+
+ow::thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+ow::thread_pool& ow::thread_pool::global() {
+	static thread_pool pool;
+	return pool;
+}
+
+void ow::thread_pool::_work() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock{m_mutex};
+			m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+			if (m_tasks.empty()) {
+				return; // stopping and nothing left to do.
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		task();
+	}
+}
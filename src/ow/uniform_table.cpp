@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include <ow/uniform_table.hpp>
+
+void ow::uniform_table::insert(std::string_view name, GLint location) {
+	if (location < 0) {
+		return;
+	}
+	if (2 * (m_size + 1) > m_slots.size()) {
+		_grow();
+	}
+
+	auto hash = std::hash<std::string_view>{}(name);
+	auto& s = m_slots[_probe(name, hash)];
+	if (s.location < 0) {
+		s.name = name;
+		s.hash = hash;
+		++m_size;
+	}
+	s.location = location;
+}
+
+GLint ow::uniform_table::find(std::string_view name) const noexcept {
+	if (m_slots.empty()) {
+		return -1;
+	}
+	return m_slots[_probe(name, std::hash<std::string_view>{}(name))].location;
+}
+
+void ow::uniform_table::clear() noexcept {
+	m_slots.clear();
+	m_size = 0;
+}
+
+std::size_t ow::uniform_table::_probe(std::string_view name, std::size_t hash) const noexcept {
+	std::size_t mask = m_slots.size() - 1;
+	for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+		auto& s = m_slots[i];
+		if (s.location < 0 || (s.hash == hash && s.name == name)) {
+			return i;
+		}
+	}
+}
+
+void ow::uniform_table::_grow() {
+	std::vector<slot> old(std::max<std::size_t>(16, 2 * m_slots.size()), slot{{}, 0, -1});
+	old.swap(m_slots);
+	for (auto& s : old) {
+		if (s.location >= 0) {
+			m_slots[_probe(s.name, s.hash)] = std::move(s);
+		}
+	}
+}
@@ -1,10 +1,37 @@
 
 #include <string_view>
 #include <iostream>
+#include <fstream>
+#include <array>
 
 #include "ow/utils.hpp"
 
 std::ostream& ow::logger_impl(std::string_view file, std::string_view function,
 					  unsigned long line) {
 	return std::cout << '[' << file << ':' << line << " (" << function << ")]:";
-}
\ No newline at end of file
+}
+
+std::uint64_t ow::hash_bytes(const void* data, std::size_t size, std::uint64_t seed) noexcept {
+	auto bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = seed;
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= FNV1A_PRIME;
+	}
+	return hash;
+}
+
+std::uint64_t ow::hash_file(const std::string& filename) {
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+
+	std::array<char, 1 << 16> buffer{};
+	std::uint64_t hash = FNV1A_OFFSET_BASIS;
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		hash = hash_bytes(buffer.data(), static_cast<std::size_t>(file.gcount()), hash);
+	}
+	return hash;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+#include <ow/vertex.hpp>
+
+std::vector<ow::packed_vertex> ow::pack_vertices(const std::vector<vertex>& vertices, glm::mat4* dequantization) {
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+	for (auto& v : vertices) {
+		min = glm::min(min, v.position);
+		max = glm::max(max, v.position);
+	}
+
+	float extent = 0.f;
+	for (int axis = 0; axis < 3; ++axis) {
+		extent = std::max(extent, max[axis] - min[axis]);
+	}
+	if (extent <= 0.f) {
+		extent = 1.f; // single point or empty mesh.
+	}
+	if (vertices.empty()) {
+		min = glm::vec3{0.f};
+	}
+
+	*dequantization = glm::mat4{extent};
+	(*dequantization)[3] = glm::vec4{min, 1.f};
+
+	std::vector<packed_vertex> packed;
+	packed.reserve(vertices.size());
+	for (auto& v : vertices) {
+		glm::vec3 quantized = (v.position - min) / extent;
+		packed.push_back({
+			{glm::packUnorm1x16(quantized.x), glm::packUnorm1x16(quantized.y), glm::packUnorm1x16(quantized.z), 0},
+			glm::packSnorm3x10_1x2(glm::vec4{v.normal, 0.f}),
+			{glm::packHalf1x16(v.tex_coords.x), glm::packHalf1x16(v.tex_coords.y)}
+		});
+	}
+	return packed;
+}
+
+std::array<std::int16_t, 2> ow::encode_octahedral(glm::vec3 normal) {
+	// project on the octahedron, then fold the lower half over the upper one.
+	float norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (!(norm > 0.f)) {
+		return {0, 0}; // no direction (missing normals): +z, instead of NaNs.
+	}
+	normal /= norm;
+	float x = normal.x;
+	float y = normal.y;
+	if (normal.z < 0.f) {
+		x = (1.f - std::abs(normal.y)) * (normal.x >= 0.f ? 1.f : -1.f);
+		y = (1.f - std::abs(normal.x)) * (normal.y >= 0.f ? 1.f : -1.f);
+	}
+
+	auto snorm16 = [] (float value) {
+		return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+	};
+	return {snorm16(x), snorm16(y)};
+}
+
+glm::vec3 ow::decode_octahedral(std::array<std::int16_t, 2> encoded) {
+	float x = std::max(static_cast<float>(encoded[0]) / 32767.f, -1.f);
+	float y = std::max(static_cast<float>(encoded[1]) / 32767.f, -1.f);
+	glm::vec3 normal{x, y, 1.f - std::abs(x) - std::abs(y)};
+	if (normal.z < 0.f) {
+		normal.x = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+		normal.y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+	}
+	return glm::normalize(normal);
+}
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <ow/bvh.hpp>
+#include <ow/frustum.hpp>
+
+#include "check.hpp"
+
+namespace {
+
+std::mt19937 rng{1234};
+
+float uniform(float min, float max) {
+	return std::uniform_real_distribution<float>{min, max}(rng);
+}
+
+glm::vec3 random_point(float extent) {
+	return {uniform(-extent, extent), uniform(-extent, extent), uniform(-extent, extent)};
+}
+
+ow::aabb random_box() {
+	glm::vec3 center = random_point(50.f);
+	glm::vec3 half_size{uniform(0.05f, 2.5f), uniform(0.05f, 2.5f), uniform(0.05f, 2.5f)};
+	return {center - half_size, center + half_size};
+}
+
+ow::ray random_ray() {
+	glm::vec3 direction{0.f};
+	while (glm::length(direction) < 0.1f) {
+		direction = random_point(1.f);
+	}
+	return {random_point(60.f), glm::normalize(direction)};
+}
+
+bool same_distance(float lhs, float rhs) {
+	if (ow::missed(lhs) || ow::missed(rhs)) {
+		return ow::missed(lhs) && ow::missed(rhs);
+	}
+	return std::abs(lhs - rhs) <= 1e-4f * std::max(1.f, std::abs(lhs));
+}
+
+// Möller-Trumbore, same conventions as triangle_bvh.
+float intersect_triangle(const ow::ray& r, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+	glm::vec3 edge1 = b - a;
+	glm::vec3 edge2 = c - a;
+	glm::vec3 p = glm::cross(r.direction, edge2);
+	float determinant = glm::dot(edge1, p);
+	if (std::abs(determinant) < 1e-12f) {
+		return ow::NO_HIT;
+	}
+	glm::vec3 s = r.origin - a;
+	float u = glm::dot(s, p) / determinant;
+	glm::vec3 q = glm::cross(s, edge1);
+	float v = glm::dot(r.direction, q) / determinant;
+	float distance = glm::dot(edge2, q) / determinant;
+	if (u < 0.f || u > 1.f || v < 0.f || u + v > 1.f || distance < 0.f) {
+		return ow::NO_HIT;
+	}
+	return distance;
+}
+
+void test_missed() {
+	CHECK(ow::missed(ow::NO_HIT));
+	CHECK(ow::missed(std::nanf("")));
+	CHECK(!ow::missed(0.f));
+	CHECK(!ow::missed(std::numeric_limits<float>::max()));
+}
+
+void test_scene_raycast() {
+	ow::scene_bvh scene;
+	std::vector<ow::scene_bvh::object_id> objects;
+	for (int i = 0; i < 1000; ++i) {
+		objects.push_back(scene.insert(random_box()));
+	}
+	scene.commit();
+
+	auto check_rays = [&scene] (float max_distance) {
+		bool all_match = true;
+		for (int i = 0; i < 500; ++i) {
+			ow::ray r = random_ray();
+			float nearest = ow::NO_HIT;
+			for (ow::scene_bvh::object_id object = 0; object < 1000; ++object) {
+				if (scene.bounds(object).min.x <= scene.bounds(object).max.x) {
+					nearest = std::min(nearest, ow::intersect(r, scene.bounds(object), max_distance));
+				}
+			}
+			auto hit = scene.raycast(r, max_distance);
+			all_match = all_match && same_distance(hit.distance, nearest) && static_cast<bool>(hit) == !ow::missed(nearest);
+			if (hit) {
+				all_match = all_match && same_distance(ow::intersect(r, scene.bounds(hit.object), max_distance), hit.distance);
+			}
+		}
+		return all_match;
+	};
+	CHECK(check_rays(ow::NO_HIT));
+	CHECK(check_rays(20.f));
+
+	// refitted after moves, rebuilt after removals: removed boxes are emptied so that brute force skips them.
+	for (std::size_t i = 0; i < objects.size(); i += 3) {
+		scene.update(objects[i], random_box());
+	}
+	scene.commit();
+	CHECK(check_rays(ow::NO_HIT));
+	for (std::size_t i = 1; i < objects.size(); i += 7) {
+		scene.update(objects[i], {glm::vec3{1.f}, glm::vec3{-1.f}});
+		scene.remove(objects[i]);
+	}
+	scene.commit();
+	CHECK(check_rays(ow::NO_HIT));
+}
+
+void test_scene_query() {
+	ow::scene_bvh scene;
+	for (int i = 0; i < 1000; ++i) {
+		scene.insert(random_box());
+	}
+	scene.commit();
+
+	glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 80.f);
+	bool all_match = true;
+	for (int i = 0; i < 50; ++i) {
+		glm::vec3 eye = random_point(40.f);
+		ow::frustum view_frustum{proj, glm::lookAt(eye, random_point(40.f), glm::vec3{0.f, 1.f, 0.f})};
+
+		std::vector<ow::scene_bvh::object_id> visible;
+		scene.query(view_frustum, &visible);
+		std::sort(visible.begin(), visible.end());
+
+		std::vector<ow::scene_bvh::object_id> expected;
+		for (ow::scene_bvh::object_id object = 0; object < 1000; ++object) {
+			if (view_frustum.intersects(scene.bounds(object))) {
+				expected.push_back(object);
+			}
+		}
+		all_match = all_match && visible == expected;
+	}
+	CHECK(all_match);
+}
+
+void test_triangle_raycast() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (unsigned int t = 0; t < 2000; ++t) {
+		glm::vec3 center = random_point(40.f);
+		for (int corner = 0; corner < 3; ++corner) {
+			indices.push_back(static_cast<unsigned int>(vertices.size()));
+			vertices.emplace_back(center + random_point(3.f));
+		}
+	}
+	ow::triangle_bvh triangles{vertices, indices};
+	CHECK(triangles.triangle_count() == 2000);
+
+	bool all_match = true;
+	std::size_t hits = 0;
+	for (int i = 0; i < 2000; ++i) {
+		// aimed at a corner of a triangle, so that most rays hit something: the hit is then on
+		// a face of the triangle's box.
+		glm::vec3 origin = random_point(60.f);
+		ow::ray r{origin, glm::normalize(vertices[static_cast<std::size_t>(i) * 3].position - origin)};
+
+		float nearest = ow::NO_HIT;
+		for (std::size_t t = 0; t < indices.size(); t += 3) {
+			nearest = std::min(nearest, intersect_triangle(r, vertices[indices[t]].position, vertices[indices[t + 1]].position,
+														  vertices[indices[t + 2]].position));
+		}
+		auto hit = triangles.raycast(r);
+		all_match = all_match && same_distance(hit.distance, nearest);
+		if (hit) {
+			++hits;
+			std::size_t t = 3 * hit.triangle;
+			float distance = intersect_triangle(r, vertices[indices[t]].position, vertices[indices[t + 1]].position,
+												vertices[indices[t + 2]].position);
+			all_match = all_match && same_distance(distance, hit.distance);
+		}
+	}
+	CHECK(all_match);
+	CHECK(hits > 1000);
+}
+
+}
+
+int main() {
+	test_missed();
+	test_scene_raycast();
+	test_scene_query();
+	test_triangle_raycast();
+	return ow::test::test_result();
+}
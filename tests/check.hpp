@@ -0,0 +1,30 @@
+#pragma once
+
+#include <iostream>
+
+// minimal assertions for the tests: a failed check is reported and the test goes on,
+// main returns test_result() so that ctest sees the failures.
+namespace ow::test {
+
+inline int& failures() {
+	static int count = 0;
+	return count;
+}
+
+inline int test_result() {
+	if (failures() != 0) {
+		std::cerr << failures() << " check(s) failed\n";
+		return 1;
+	}
+	return 0;
+}
+
+}
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #expr "\n"; \
+			++ow::test::failures(); \
+		} \
+	} while (false)
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <ow/frustum.hpp>
+
+#include "check.hpp"
+
+namespace {
+
+ow::frustum test_frustum() {
+	glm::mat4 proj = glm::perspective(1.f, 16.f / 9.f, 0.1f, 100.f);
+	glm::mat4 view = glm::lookAt(glm::vec3{3.f, 2.f, 10.f}, glm::vec3{0.f, 0.f, -20.f}, glm::vec3{0.f, 1.f, 0.f});
+	return ow::frustum{proj, view};
+}
+
+// smallest distance + radius over the planes, in double: spheres close to 0 are left out, the
+// kernels add the terms in different orders and may round them either way.
+double margin(const ow::frustum& view_frustum, const ow::bounding_sphere& sphere) {
+	double least = HUGE_VAL;
+	for (auto& plane : view_frustum.planes()) {
+		double distance = static_cast<double>(plane.x) * sphere.center.x + static_cast<double>(plane.y) * sphere.center.y
+				+ static_cast<double>(plane.z) * sphere.center.z + static_cast<double>(plane.w);
+		least = std::min(least, distance + static_cast<double>(sphere.radius));
+	}
+	return least;
+}
+
+// spheres in and around the frustum, about half of them visible.
+std::vector<ow::bounding_sphere> random_spheres(const ow::frustum& view_frustum, std::size_t count, unsigned int seed) {
+	std::mt19937 rng{seed};
+	std::uniform_real_distribution<float> coordinate{-80.f, 80.f};
+	std::uniform_real_distribution<float> radius{0.f, 10.f};
+	std::vector<ow::bounding_sphere> spheres;
+	while (spheres.size() < count) {
+		ow::bounding_sphere sphere;
+		sphere.center = {coordinate(rng), coordinate(rng), coordinate(rng) - 40.f};
+		sphere.radius = radius(rng);
+		if (std::abs(margin(view_frustum, sphere)) > 1e-3) {
+			spheres.push_back(sphere);
+		}
+	}
+	return spheres;
+}
+
+std::vector<ow::culling_kernel> supported_kernels() {
+	std::vector<ow::culling_kernel> kernels;
+	for (auto kernel : {ow::culling_kernel::scalar, ow::culling_kernel::sse, ow::culling_kernel::avx2}) {
+		if (kernel <= ow::best_culling_kernel()) {
+			kernels.push_back(kernel);
+		}
+	}
+	return kernels;
+}
+
+void test_kernels_agree() {
+	auto view_frustum = test_frustum();
+	// around the lane widths, the remainders go through the scalar loop.
+	for (std::size_t count : {0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 1027u}) {
+		auto spheres = random_spheres(view_frustum, count, static_cast<unsigned int>(count) + 1);
+		ow::sphere_batch batch;
+		std::vector<unsigned char> expected;
+		std::size_t expected_visible = 0;
+		for (auto& sphere : spheres) {
+			batch.push_back(sphere);
+			expected.push_back(view_frustum.intersects(sphere) ? 1 : 0);
+			expected_visible += expected.back();
+		}
+
+		for (auto kernel : supported_kernels()) {
+			// stale contents of another size are replaced.
+			std::vector<unsigned char> visibility(count + 5, 7);
+			auto stats = ow::cull_spheres(view_frustum, batch, &visibility, kernel);
+			CHECK(visibility == expected);
+			CHECK(stats.visible == expected_visible);
+			CHECK(stats.culled == count - expected_visible);
+		}
+	}
+}
+
+void test_visible_ratio() {
+	// the comparisons above mean little if every sphere is on the same side.
+	auto view_frustum = test_frustum();
+	auto spheres = random_spheres(view_frustum, 1000, 42);
+	ow::sphere_batch batch;
+	for (auto& sphere : spheres) {
+		batch.push_back(sphere);
+	}
+	std::vector<unsigned char> visibility;
+	auto stats = ow::cull_spheres(view_frustum, batch, &visibility);
+	CHECK(stats.visible > 50);
+	CHECK(stats.culled > 50);
+}
+
+void test_infinite_radius() {
+	auto view_frustum = test_frustum();
+	ow::sphere_batch batch;
+	for (int i = 0; i < 9; ++i) {
+		batch.push_back({glm::vec3{1000.f, 0.f, static_cast<float>(i)}, HUGE_VALF});
+	}
+	for (auto kernel : supported_kernels()) {
+		std::vector<unsigned char> visibility;
+		auto stats = ow::cull_spheres(view_frustum, batch, &visibility, kernel);
+		CHECK(stats.visible == batch.size());
+		CHECK(std::all_of(visibility.begin(), visibility.end(), [](unsigned char v) { return v == 1; }));
+	}
+}
+
+}
+
+int main() {
+	test_kernels_agree();
+	test_visible_ratio();
+	test_infinite_radius();
+	return ow::test::test_result();
+}
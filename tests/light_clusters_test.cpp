@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <ow/light_clusters.hpp>
+
+#include "check.hpp"
+
+namespace {
+
+constexpr float NEAR = 0.1f;
+constexpr float FAR = 100.f;
+constexpr float FOV = 1.f;
+constexpr float ASPECT = 16.f / 9.f;
+
+// view space lights in and around the frustum, some crossing the near and far planes,
+// one of infinite radius.
+ow::sphere_batch random_lights(std::size_t count) {
+	std::mt19937 rng{99};
+	std::uniform_real_distribution<float> unit{0.f, 1.f};
+	ow::sphere_batch lights;
+	for (std::size_t l = 0; l < count; ++l) {
+		float depth = -1.f + 110.f * unit(rng);
+		float half_height = std::tan(FOV / 2.f) * std::max(depth, 1.f);
+		glm::vec3 center{(2.f * unit(rng) - 1.f) * 1.2f * half_height * ASPECT, (2.f * unit(rng) - 1.f) * 1.2f * half_height,
+						 -depth};
+		lights.push_back({center, 0.1f + 8.f * unit(rng) * unit(rng)});
+	}
+	lights.push_back({glm::vec3{0.f, 0.f, -50.f}, std::numeric_limits<float>::infinity()});
+	return lights;
+}
+
+// view space box of cluster (i, j, k), computed independently from light_clusters.
+void cluster_box(const ow::cluster_grid& grid, std::uint32_t i, std::uint32_t j, std::uint32_t k,
+				 glm::vec3* min, glm::vec3* max) {
+	float near_depth = NEAR * std::pow(FAR / NEAR, static_cast<float>(k) / static_cast<float>(grid.z));
+	float far_depth = NEAR * std::pow(FAR / NEAR, static_cast<float>(k + 1) / static_cast<float>(grid.z));
+	float tan_y = std::tan(FOV / 2.f);
+	float tan_x = tan_y * ASPECT;
+	auto edge = [] (std::uint32_t t, std::uint32_t tiles, float tan) {
+		return (-1.f + 2.f * static_cast<float>(t) / static_cast<float>(tiles)) * tan;
+	};
+	float x0 = edge(i, grid.x, tan_x), x1 = edge(i + 1, grid.x, tan_x);
+	float y0 = edge(j, grid.y, tan_y), y1 = edge(j + 1, grid.y, tan_y);
+	*min = {std::min(x0 * near_depth, x0 * far_depth), std::min(y0 * near_depth, y0 * far_depth), near_depth};
+	*max = {std::max(x1 * near_depth, x1 * far_depth), std::max(y1 * near_depth, y1 * far_depth), far_depth};
+}
+
+void test_brute_force() {
+	ow::cluster_grid grid{};
+	ow::light_clusters clusters{grid};
+	clusters.set_projection(glm::perspective(FOV, ASPECT, NEAR, FAR));
+	auto lights = random_lights(500);
+	auto stats = clusters.assign(lights);
+	CHECK(stats.dropped == 0);
+	CHECK(stats.lights > 0 && stats.lights <= lights.size());
+
+	// lights within a small margin of a cluster are ambiguous: rounding differs.
+	std::size_t missing = 0, extra = 0, checked = 0;
+	for (std::uint32_t k = 0; k < grid.z; ++k) {
+		for (std::uint32_t j = 0; j < grid.y; ++j) {
+			for (std::uint32_t i = 0; i < grid.x; ++i) {
+				glm::vec3 min, max;
+				cluster_box(grid, i, j, k, &min, &max);
+				auto assigned = clusters.lights_of(i, j, k);
+				std::sort(assigned.begin(), assigned.end());
+				CHECK(std::adjacent_find(assigned.begin(), assigned.end()) == assigned.end());
+
+				for (std::size_t l = 0; l < lights.size(); ++l) {
+					glm::vec3 center{lights.x[l], lights.y[l], -lights.z[l]};
+					glm::vec3 d = glm::max(glm::max(min - center, center - max), glm::vec3{0.f});
+					float distance2 = glm::dot(d, d);
+					float radius = lights.radius[l];
+					bool found = std::binary_search(assigned.begin(), assigned.end(), static_cast<std::uint16_t>(l));
+					if (std::isinf(radius)) {
+						missing += found ? 0 : 1;
+						continue;
+					}
+					float margin = 1e-3f * (radius * radius + 1.f);
+					if (distance2 < radius * radius - margin) {
+						missing += found ? 0 : 1;
+						++checked;
+					} else if (distance2 > radius * radius + margin) {
+						extra += found ? 1 : 0;
+						++checked;
+					}
+				}
+			}
+		}
+	}
+	CHECK(missing == 0);
+	CHECK(extra == 0);
+	CHECK(checked > grid.size() * lights.size() * 9 / 10);
+}
+
+void test_kernels_agree() {
+	ow::light_clusters reference{};
+	reference.set_projection(glm::perspective(FOV, ASPECT, NEAR, FAR));
+	auto lights = random_lights(2000);
+	reference.assign(lights, ow::culling_kernel::scalar);
+
+	for (auto kernel : {ow::culling_kernel::sse, ow::culling_kernel::avx2}) {
+		if (kernel > ow::best_culling_kernel()) {
+			continue; // not supported here
+		}
+		ow::light_clusters clusters{};
+		clusters.set_projection(glm::perspective(FOV, ASPECT, NEAR, FAR));
+		auto stats = clusters.assign(lights, kernel);
+		CHECK(stats.indices == reference.stats().indices);
+		CHECK(stats.max_per_cluster == reference.stats().max_per_cluster);
+		bool same = clusters.indices() == reference.indices();
+		for (std::size_t c = 0; c < reference.ranges().size(); ++c) {
+			same = same && clusters.ranges()[c].offset == reference.ranges()[c].offset
+				   && clusters.ranges()[c].count == reference.ranges()[c].count;
+		}
+		CHECK(same);
+	}
+}
+
+void test_max_indices() {
+	ow::light_clusters clusters{};
+	clusters.set_projection(glm::perspective(FOV, ASPECT, NEAR, FAR));
+	auto lights = random_lights(500);
+	auto all = clusters.assign(lights);
+	auto truncated = clusters.assign(lights, ow::culling_kernel::automatic, all.indices / 2);
+	CHECK(truncated.indices == all.indices / 2);
+	CHECK(truncated.dropped == all.indices - all.indices / 2);
+	CHECK(clusters.indices().size() == all.indices / 2);
+}
+
+}
+
+int main() {
+	test_brute_force();
+	test_kernels_agree();
+	test_max_indices();
+	return ow::test::test_result();
+}
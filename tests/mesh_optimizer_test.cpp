@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <ow/mesh_optimizer.hpp>
+
+#include "check.hpp"
+
+namespace {
+
+// size x size quads, two triangles each, in a random order.
+void shuffled_grid(unsigned int size, std::vector<ow::vertex>* vertices, std::vector<unsigned int>* indices) {
+	for (unsigned int y = 0; y <= size; ++y) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			vertices->emplace_back(glm::vec3(x, y, 0), glm::vec3(0, 0, 1));
+		}
+	}
+
+	std::vector<std::array<unsigned int, 3>> triangles;
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int corner = y * (size + 1) + x;
+			triangles.push_back({corner, corner + 1, corner + size + 2});
+			triangles.push_back({corner, corner + size + 2, corner + size + 1});
+		}
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937{42});
+	for (const auto& tri : triangles) {
+		indices->insert(indices->end(), tri.begin(), tri.end());
+	}
+}
+
+using coordinates = std::tuple<float, float, float>;
+using triangle = std::array<coordinates, 3>;
+
+// triangles by vertex positions, rotated so that the smallest comes first (the winding is kept).
+std::vector<triangle> triangles_of(const std::vector<ow::vertex>& vertices, const std::vector<unsigned int>& indices) {
+	std::vector<triangle> triangles;
+	for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+		triangle tri;
+		for (std::size_t j = 0; j < 3; ++j) {
+			const auto& pos = vertices[indices[i + j]].position;
+			tri[j] = {pos.x, pos.y, pos.z};
+		}
+		std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+		triangles.push_back(tri);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+void test_weld_cell_border() {
+	// cells are centered on multiples of 4 tolerances: 0.0019 and 0.0021 are on both sides of a border.
+	// The last vertex is across the border on two axes.
+	std::vector<ow::vertex> vertices = {
+		{glm::vec3(0.0019f, 0.0019f, 0)}, {glm::vec3(0.0021f, 0.0019f, 0)}, {glm::vec3(0.0035f, 0, 0)},
+		{glm::vec3(0.0021f, 0.0021f, 0)}
+	};
+	std::vector<unsigned int> indices = {0, 1, 2, 3, 2, 1};
+	CHECK(ow::weld_vertices(&vertices, &indices, 1e-3f) == 2);
+	CHECK((indices == std::vector<unsigned int>{0, 0, 1, 0, 1, 0}));
+	CHECK(vertices[0].position.x > 0.0018f && vertices[0].position.x < 0.0020f);
+}
+
+void test_weld_parallel() {
+	// above the parallel threshold: every vertex of the grid comes three times, slightly moved.
+	constexpr unsigned int size = 128;
+	constexpr float tolerance = 1e-3f;
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::mt19937 rng{7};
+	std::uniform_real_distribution<float> jitter{-0.4f * tolerance, 0.4f * tolerance};
+	for (unsigned int copy = 0; copy < 3; ++copy) {
+		for (unsigned int y = 0; y < size; ++y) {
+			for (unsigned int x = 0; x < size; ++x) {
+				glm::vec3 position(static_cast<float>(x) * 0.01f + jitter(rng), static_cast<float>(y) * 0.01f + jitter(rng), 0.f);
+				indices.push_back(static_cast<unsigned int>(vertices.size()));
+				vertices.emplace_back(position, glm::vec3(0, 0, 1));
+			}
+		}
+	}
+	const auto original = vertices;
+
+	CHECK(ow::weld_vertices(&vertices, &indices, tolerance) == size * size);
+	CHECK(vertices.size() == size * size);
+	bool same_positions = true;
+	for (std::size_t i = 0; i < indices.size(); ++i) {
+		same_positions = same_positions && glm::distance(vertices[indices[i]].position, original[i].position) < 2.f * tolerance;
+	}
+	CHECK(same_positions);
+	// the first copy is the one kept, in order.
+	CHECK((indices[size * size + 5] == 5 && vertices[5].position == original[5].position));
+}
+
+void test_simulate_vertex_cache() {
+	// the second triangle reuses two vertices, the third one all of them.
+	std::vector<unsigned int> indices = {0, 1, 2, 1, 2, 3, 3, 2, 1};
+	auto stats = ow::simulate_vertex_cache(indices, 4, 16);
+	CHECK(stats.transformed_vertices == 4);
+	CHECK(stats.acmr > 4.f / 3.f - 1e-6f && stats.acmr < 4.f / 3.f + 1e-6f);
+	CHECK(stats.atvr > 1.f - 1e-6f && stats.atvr < 1.f + 1e-6f);
+
+	// a cache of 3 entries has evicted vertex 0 when it comes back.
+	indices = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+	CHECK(ow::simulate_vertex_cache(indices, 6, 3).transformed_vertices == 9);
+	CHECK(ow::simulate_vertex_cache(indices, 6, 6).transformed_vertices == 6);
+}
+
+void test_optimize_mesh() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	shuffled_grid(32, &vertices, &indices);
+	// never referenced: dropped by the fetch pass.
+	vertices.emplace_back(glm::vec3(-1, -1, 0));
+
+	const auto triangles = triangles_of(vertices, indices);
+	const auto before = ow::simulate_vertex_cache(indices, vertices.size());
+
+	auto report = ow::optimize_mesh(&vertices, &indices);
+	const auto after = ow::simulate_vertex_cache(indices, vertices.size());
+
+	CHECK(report.before.transformed_vertices == before.transformed_vertices);
+	CHECK(report.after.transformed_vertices == after.transformed_vertices);
+	CHECK(vertices.size() == 33 * 33);
+	CHECK(triangles_of(vertices, indices) == triangles);
+
+	// a shuffled grid misses almost every vertex, an optimized one stays well under 1.
+	CHECK(before.acmr > 2.f);
+	CHECK(after.acmr < 0.8f);
+	CHECK(after.transformed_vertices >= vertices.size());
+	CHECK(report.after.atvr > after.atvr - 1e-6f && report.after.atvr < after.atvr + 1e-6f);
+	CHECK(after.atvr < 1.6f);
+}
+
+void test_optimize_vertex_fetch() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	shuffled_grid(8, &vertices, &indices);
+	ow::optimize_vertex_fetch(&vertices, &indices);
+
+	// vertices come in order of first use.
+	unsigned int next = 0;
+	for (auto idx : indices) {
+		CHECK(idx <= next);
+		if (idx == next) {
+			++next;
+		}
+	}
+	CHECK(next == vertices.size());
+}
+
+}
+
+int main() {
+	test_weld_cell_border();
+	test_weld_parallel();
+	test_simulate_vertex_cache();
+	test_optimize_mesh();
+	test_optimize_vertex_fetch();
+	return ow::test::test_result();
+}
@@ -0,0 +1,159 @@
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ow/mesh_simplifier.hpp>
+
+#include "check.hpp"
+
+namespace {
+
+// closed unit sphere centered on the origin: every triangle faces outward.
+void uv_sphere(unsigned int rings, unsigned int segments, std::vector<ow::vertex>* vertices,
+			   std::vector<unsigned int>* indices) {
+	const float pi = std::acos(-1.f);
+	vertices->emplace_back(glm::vec3(0, 1, 0), glm::vec3(0, 1, 0));
+	for (unsigned int r = 1; r < rings; ++r) {
+		float theta = pi * static_cast<float>(r) / static_cast<float>(rings);
+		for (unsigned int s = 0; s < segments; ++s) {
+			float phi = 2.f * pi * static_cast<float>(s) / static_cast<float>(segments);
+			glm::vec3 position(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertices->emplace_back(position, position);
+		}
+	}
+	vertices->emplace_back(glm::vec3(0, -1, 0), glm::vec3(0, -1, 0));
+
+	auto at = [segments] (unsigned int r, unsigned int s) { return 1 + (r - 1) * segments + s % segments; };
+	const auto south = static_cast<unsigned int>(vertices->size() - 1);
+	for (unsigned int s = 0; s < segments; ++s) {
+		indices->insert(indices->end(), {0, at(1, s + 1), at(1, s)});
+		indices->insert(indices->end(), {south, at(rings - 1, s), at(rings - 1, s + 1)});
+	}
+	for (unsigned int r = 1; r + 1 < rings; ++r) {
+		for (unsigned int s = 0; s < segments; ++s) {
+			indices->insert(indices->end(), {at(r, s), at(r, s + 1), at(r + 1, s)});
+			indices->insert(indices->end(), {at(r, s + 1), at(r + 1, s + 1), at(r + 1, s)});
+		}
+	}
+}
+
+// triangles of a convex mesh around the origin must face away from it.
+bool all_outward(const std::vector<ow::vertex>& vertices, const std::vector<unsigned int>& indices) {
+	for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+		glm::vec3 p0 = vertices[indices[t]].position;
+		glm::vec3 p1 = vertices[indices[t + 1]].position;
+		glm::vec3 p2 = vertices[indices[t + 2]].position;
+		if (glm::dot(glm::cross(p1 - p0, p2 - p0), p0 + p1 + p2) <= 0.f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void test_triangle_target() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	uv_sphere(32, 64, &vertices, &indices);
+	CHECK(all_outward(vertices, indices));
+
+	for (std::size_t target : {indices.size() / 2, indices.size() / 8}) {
+		target -= target % 3;
+		auto result = ow::simplify(vertices, indices, target, 1.f);
+		CHECK(result.indices.size() <= target);
+		CHECK(result.indices.size() % 3 == 0);
+		// collapses remove two triangles at most: the target is not overshot by much.
+		CHECK(result.indices.size() + 64 * 3 >= target);
+		CHECK(all_outward(vertices, result.indices));
+	}
+}
+
+void test_error_budget() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	uv_sphere(32, 64, &vertices, &indices);
+
+	// every collapse on a sphere moves the surface: nothing happens without a budget.
+	auto unchanged = ow::simplify(vertices, indices, 0, 0.f);
+	CHECK(unchanged.indices == indices);
+	CHECK(unchanged.error <= 0.f);
+
+	float previous_size = static_cast<float>(indices.size());
+	for (float max_error : {1e-3f, 1e-2f, 5e-2f}) {
+		auto result = ow::simplify(vertices, indices, 0, max_error);
+		CHECK(result.error > 0.f);
+		CHECK(result.error <= max_error);
+		CHECK(all_outward(vertices, result.indices));
+		// a bigger budget simplifies more.
+		CHECK(static_cast<float>(result.indices.size()) < previous_size);
+		previous_size = static_cast<float>(result.indices.size());
+	}
+}
+
+void test_flat_grid() {
+	// flat interior vertices collapse for free, the open border stays in place.
+	constexpr unsigned int size = 16;
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (unsigned int y = 0; y <= size; ++y) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			vertices.emplace_back(glm::vec3(x, y, 0), glm::vec3(0, 0, 1));
+		}
+	}
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int corner = y * (size + 1) + x;
+			indices.insert(indices.end(), {corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1});
+		}
+	}
+
+	auto result = ow::simplify(vertices, indices, 0, 0.f);
+	CHECK(result.indices.size() < indices.size() / 4);
+	bool facing_up = true;
+	std::vector<bool> used(vertices.size(), false);
+	for (std::size_t t = 0; t < result.indices.size(); t += 3) {
+		glm::vec3 p0 = vertices[result.indices[t]].position;
+		glm::vec3 p1 = vertices[result.indices[t + 1]].position;
+		glm::vec3 p2 = vertices[result.indices[t + 2]].position;
+		facing_up = facing_up && glm::cross(p1 - p0, p2 - p0).z > 0.f;
+		for (std::size_t k = 0; k < 3; ++k) {
+			used[result.indices[t + k]] = true;
+		}
+	}
+	CHECK(facing_up);
+	bool border_kept = true;
+	for (unsigned int i = 0; i <= size; ++i) {
+		border_kept = border_kept && used[i] && used[size * (size + 1) + i] && used[i * (size + 1)] && used[i * (size + 1) + size];
+	}
+	CHECK(border_kept);
+}
+
+void test_lod_chain() {
+	std::vector<ow::vertex> vertices;
+	std::vector<unsigned int> indices;
+	uv_sphere(32, 64, &vertices, &indices);
+
+	ow::lod_settings settings{};
+	auto levels = ow::build_lod_chain(vertices, indices, settings);
+	CHECK(levels.size() > 1);
+	CHECK(levels.size() <= settings.max_levels);
+	CHECK(levels.front().indices == indices);
+	// the sphere's bounding box diagonal is 2 * sqrt(3).
+	const float budget = settings.max_error * 2.f * std::sqrt(3.f);
+	for (std::size_t i = 1; i < levels.size(); ++i) {
+		CHECK(levels[i].error >= levels[i - 1].error);
+		CHECK(levels[i].error <= budget * 1.0001f);
+		CHECK(levels[i].indices.size() < levels[i - 1].indices.size());
+		CHECK(all_outward(vertices, levels[i].indices));
+	}
+}
+
+}
+
+int main() {
+	test_triangle_target();
+	test_error_budget();
+	test_flat_grid();
+	test_lod_chain();
+	return ow::test::test_result();
+}